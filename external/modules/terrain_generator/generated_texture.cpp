@@ -1,10 +1,112 @@
 // Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
 
 #include <godot/servers/rendering_server.h>
+#include <cstring>
 
 #include "generated_texture.h"
 #include "logger.h"
 #include "terrain_generator.h"
+#include "terrain_generator_profiler.h"
+
+///////////////////////////
+// Private Functions
+///////////////////////////
+
+// Creates the array on the RenderingDevice with copy usage. Returns false if unavailable, as on
+// the Compatibility renderer or a separate render thread, or if the layers aren't uniform.
+bool GeneratedTexture::_create_rd(const TypedArray<Image> &p_layers, const int p_capacity) {
+	RenderingDevice *rd = RD::get_singleton();
+	if (!rd || !RS::get_singleton()->is_on_render_thread()) {
+		return false;
+	}
+	Ref<Image> img = p_layers[0];
+	RD::DataFormat format = RD::DATA_FORMAT_MAX;
+	switch (img->get_format()) {
+		case Image::FORMAT_RF:
+			format = RD::DATA_FORMAT_R32_SFLOAT;
+			break;
+		case Image::FORMAT_RGBA8:
+			// Only color maps are RGBA8, and always sampled as source_color
+			format = RD::DATA_FORMAT_R8G8B8A8_SRGB;
+			break;
+		default:
+			return false;
+	}
+	Vector<Vector<uint8_t>> data;
+	for (int i = 0; i < p_layers.size(); i++) {
+		Ref<Image> layer = p_layers[i];
+		if (layer.is_null() || layer->get_size() != img->get_size() || layer->get_format() != img->get_format() ||
+				layer->get_mipmap_count() != img->get_mipmap_count()) {
+			return false;
+		}
+		data.push_back(layer->get_data());
+	}
+	Vector<uint8_t> blank;
+	blank.resize(data[0].size());
+	memset(blank.ptrw(), 0, blank.size());
+	for (int i = p_layers.size(); i < p_capacity; i++) {
+		data.push_back(blank);
+	}
+	TerrainGeneratorProfiler::add_upload_bytes(uint64_t(data[0].size()) * data.size());
+
+	RD::TextureFormat tf;
+	tf.format = format;
+	tf.width = img->get_width();
+	tf.height = img->get_height();
+	tf.array_layers = data.size();
+	tf.mipmaps = img->get_mipmap_count() + 1;
+	tf.texture_type = RD::TEXTURE_TYPE_2D_ARRAY;
+	tf.usage_bits = RD::TEXTURE_USAGE_SAMPLING_BIT | RD::TEXTURE_USAGE_CAN_UPDATE_BIT |
+			RD::TEXTURE_USAGE_CAN_COPY_FROM_BIT | RD::TEXTURE_USAGE_CAN_COPY_TO_BIT;
+	_rd_rid = rd->texture_create(tf, RD::TextureView(), data);
+	if (!_rd_rid.is_valid()) {
+		return false;
+	}
+	_rid = RS::get_singleton()->texture_rd_create(_rd_rid, RS::TEXTURE_LAYERED_2D_ARRAY);
+	_rd_format = format;
+	_mipmaps = tf.mipmaps;
+	_capacity = data.size();
+	return true;
+}
+
+// Copies the area of each mipmap level through a small staging texture
+void GeneratedTexture::_update_area_rd(const Ref<Image> &p_image, const int p_layer, const Rect2i &p_area) {
+	RenderingDevice *rd = RD::get_singleton();
+	const uint8_t *src = p_image->ptr();
+	int pixel_size = Image::get_format_pixel_size(p_image->get_format());
+	Rect2i area = p_area;
+	for (int mip = 0; mip < _mipmaps && mip <= p_image->get_mipmap_count(); mip++) {
+		int64_t offset;
+		int width, height;
+		p_image->get_mipmap_offset_and_size(mip, offset, width, height);
+		area = area.intersection(Rect2i(0, 0, width, height));
+		if (!area.has_area()) {
+			break;
+		}
+		Vector<uint8_t> data;
+		data.resize(area.size.x * area.size.y * pixel_size);
+		for (int y = 0; y < area.size.y; y++) {
+			memcpy(data.ptrw() + y * area.size.x * pixel_size,
+					src + offset + ((area.position.y + y) * width + area.position.x) * pixel_size, area.size.x * pixel_size);
+		}
+		RD::TextureFormat tf;
+		tf.format = _rd_format;
+		tf.width = area.size.x;
+		tf.height = area.size.y;
+		tf.usage_bits = RD::TEXTURE_USAGE_SAMPLING_BIT | RD::TEXTURE_USAGE_CAN_UPDATE_BIT | RD::TEXTURE_USAGE_CAN_COPY_FROM_BIT;
+		Vector<Vector<uint8_t>> layers;
+		layers.push_back(data);
+		RID staging = rd->texture_create(tf, RD::TextureView(), layers);
+		TerrainGeneratorProfiler::add_upload_bytes(data.size());
+		rd->texture_copy(staging, _rd_rid, Vector3(), Vector3(area.position.x, area.position.y, 0),
+				Vector3(area.size.x, area.size.y, 1), 0, mip, 0, p_layer);
+		rd->free(staging);
+		// Pixels of the next level covering the area
+		Vector2i start = area.position / 2;
+		Vector2i end = (area.get_end() + Vector2i(1, 1)) / 2;
+		area = Rect2i(start, end - start);
+	}
+}
 
 ///////////////////////////
 // Public Functions
@@ -15,24 +117,53 @@ void GeneratedTexture::clear() {
 		LOG(EXTREME, "GeneratedTexture freeing ", _rid);
 		RS::get_singleton()->free(_rid);
 	}
+	// The wrapping texture may have freed it already
+	if (_rd_rid.is_valid() && RD::get_singleton() && RD::get_singleton()->texture_is_valid(_rd_rid)) {
+		RD::get_singleton()->free(_rd_rid);
+	}
+	_rd_rid = RID();
+	_rd_format = RD::DATA_FORMAT_MAX;
+	_mipmaps = 1;
 	if (_image.is_valid()) {
 		LOG(EXTREME, "GeneratedTexture unref image", _image);
 		_image.unref();
 	}
 	_rid = RID();
 	_dirty = true;
+	_layers = 0;
+	_capacity = 0;
 }
 
-RID GeneratedTexture::create(const TypedArray<Image> &p_layers) {
+// Creates a Texture2DArray from p_layers. If p_capacity is larger than the layer count, the array is
+// padded with blank layers so regions can later be added with set_layer() without recreating the array.
+RID GeneratedTexture::create(const TypedArray<Image> &p_layers, const int p_capacity) {
 	if (!p_layers.is_empty()) {
 		if (TerrainGenerator::debug_level >= DEBUG) {
-			LOG(EXTREME, "RenderingServer creating Texture2DArray, layers size: ", p_layers.size());
+			LOG(EXTREME, "RenderingServer creating Texture2DArray, layers size: ", p_layers.size(), ", capacity: ", p_capacity);
 			for (int i = 0; i < p_layers.size(); i++) {
 				Ref<Image> img = p_layers[i];
 				LOG(EXTREME, i, ": ", img, ", empty: ", img->is_empty(), ", size: ", img->get_size(), ", format: ", img->get_format());
 			}
 		}
-		_rid = RS::get_singleton()->call("_texture_2d_layered_create", p_layers, RenderingServer::TEXTURE_LAYERED_2D_ARRAY);
+		if (_create_rd(p_layers, MAX(p_capacity, p_layers.size()))) {
+			_layers = p_layers.size();
+			_dirty = false;
+			return _rid;
+		}
+		TypedArray<Image> layers = p_layers;
+		if (p_capacity > p_layers.size()) {
+			Ref<Image> img = p_layers[0];
+			Ref<Image> blank = Image::create_empty(img->get_width(), img->get_height(), img->has_mipmaps(), img->get_format());
+			layers = p_layers.duplicate();
+			for (int i = p_layers.size(); i < p_capacity; i++) {
+				layers.push_back(blank);
+			}
+		}
+		_rid = RS::get_singleton()->call("_texture_2d_layered_create", layers, RenderingServer::TEXTURE_LAYERED_2D_ARRAY);
+		Ref<Image> img = p_layers[0];
+		TerrainGeneratorProfiler::add_upload_bytes(uint64_t(img->get_data_size()) * layers.size());
+		_layers = p_layers.size();
+		_capacity = layers.size();
 		_dirty = false;
 	} else {
 		clear();
@@ -42,13 +173,56 @@ RID GeneratedTexture::create(const TypedArray<Image> &p_layers) {
 
 void GeneratedTexture::update(const Ref<Image> &p_image, const int p_layer) {
 	LOG(EXTREME, "RenderingServer updating Texture2DArray at index: ", p_layer);
+	TerrainGeneratorProfiler::add_upload_bytes(p_image->get_data_size());
+	if (_rd_rid.is_valid()) {
+		RD::get_singleton()->texture_update(_rd_rid, p_layer, p_image->get_data());
+		return;
+	}
 	RS::get_singleton()->texture_2d_update(_rid, p_image, p_layer);
 }
 
+// Updates p_area of a layer, in pixels of the full size image, and the mipmap levels above it.
+// Large areas, or arrays created by the RenderingServer, update the whole layer.
+void GeneratedTexture::update_area(const Ref<Image> &p_image, const int p_layer, const Rect2i &p_area) {
+	Rect2i area = p_area.intersection(Rect2i(V2I_ZERO, p_image->get_size()));
+	if (!_rd_rid.is_valid() || area.get_area() * 2 > p_image->get_width() * p_image->get_height()) {
+		update(p_image, p_layer);
+		return;
+	}
+	if (!area.has_area()) {
+		return;
+	}
+	LOG(EXTREME, "RenderingDevice updating Texture2DArray area: ", area, " at index: ", p_layer);
+	_update_area_rd(p_image, p_layer, area);
+}
+
+// Writes p_image into p_layer, which may be one past the last used layer if there is spare capacity.
+// Returns false if the array must be recreated to hold the layer.
+bool GeneratedTexture::set_layer(const Ref<Image> &p_image, const int p_layer) {
+	if (!_rid.is_valid() || _dirty || p_layer < 0 || p_layer > _layers || p_layer >= _capacity) {
+		return false;
+	}
+	update(p_image, p_layer);
+	if (p_layer == _layers) {
+		_layers++;
+	}
+	return true;
+}
+
+// Releases the last used layer back to spare capacity. The GPU data is left in place.
+void GeneratedTexture::remove_layer() {
+	if (_layers > 0) {
+		_layers--;
+	}
+}
+
 RID GeneratedTexture::create(const Ref<Image> &p_image) {
 	LOG(EXTREME, "RenderingServer creating Texture2D");
 	_image = p_image;
 	_rid = RS::get_singleton()->texture_2d_create(_image);
+	if (_image.is_valid()) {
+		TerrainGeneratorProfiler::add_upload_bytes(_image->get_data_size());
+	}
 	_dirty = false;
 	return _rid;
 }
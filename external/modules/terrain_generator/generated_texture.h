@@ -3,6 +3,7 @@
 #pragma once
 
 #include <godot/core/io/image.h>
+#include <godot/servers/rendering/rendering_device.h>
 
 #include "constants.h"
 
@@ -14,13 +15,29 @@ private:
 	RID _rid = RID();
 	Ref<Image> _image;
 	bool _dirty = false;
+	int _layers = 0; // Layers holding region data
+	int _capacity = 0; // Layers allocated in the Texture2DArray, including spares
+
+	// On RenderingDevice renderers, arrays are created on the device and wrapped by _rid,
+	// so areas of a layer can be copied in without uploading the whole layer
+	RID _rd_rid = RID();
+	RD::DataFormat _rd_format = RD::DATA_FORMAT_MAX;
+	int _mipmaps = 1;
+
+	bool _create_rd(const TypedArray<Image> &p_layers, const int p_capacity);
+	void _update_area_rd(const Ref<Image> &p_image, const int p_layer, const Rect2i &p_area);
 
 public:
 	void clear();
 	bool is_dirty() const { return _dirty; }
-	RID create(const TypedArray<Image> &p_layers);
+	RID create(const TypedArray<Image> &p_layers, const int p_capacity = 0);
 	void update(const Ref<Image> &p_image, const int p_layer);
+	void update_area(const Ref<Image> &p_image, const int p_layer, const Rect2i &p_area);
+	bool set_layer(const Ref<Image> &p_image, const int p_layer);
+	void remove_layer();
 	RID create(const Ref<Image> &p_image);
 	Ref<Image> get_image() const { return _image; }
 	RID get_rid() const { return _rid; }
+	int get_layer_count() const { return _layers; }
+	int get_capacity() const { return _capacity; }
 };
\ No newline at end of file
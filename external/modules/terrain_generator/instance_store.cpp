@@ -0,0 +1,258 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include <cstring>
+
+#include "instance_store.h"
+#include "logger.h"
+
+///////////////////////////
+// Cell Functions
+///////////////////////////
+
+// Removes the instances flagged in p_remove, keeping the order of the rest
+void InstanceStore::Cell::remove_if(const std::vector<bool> &p_remove) {
+	float *xform_ptr = xforms.ptrw();
+	Color *color_ptr = colors.ptrw();
+	int kept = 0;
+	for (int i = 0, count = size(); i < count; i++) {
+		if (i < int(p_remove.size()) && p_remove[i]) {
+			continue;
+		}
+		if (kept != i) {
+			memcpy(xform_ptr + kept * XFORM_FLOATS, xform_ptr + i * XFORM_FLOATS, sizeof(float) * XFORM_FLOATS);
+			color_ptr[kept] = color_ptr[i];
+		}
+		kept++;
+	}
+	xforms.resize(kept * XFORM_FLOATS);
+	colors.resize(kept);
+}
+
+// Interleaves transforms and colors into r_buffer, which must hold size() * BUFFER_FLOATS
+void InstanceStore::Cell::fill_buffer(float *r_buffer) const {
+	const float *xform_ptr = xforms.ptr();
+	const Color *color_ptr = colors.ptr();
+	for (int i = 0, count = size(); i < count; i++) {
+		float *dst = r_buffer + i * BUFFER_FLOATS;
+		memcpy(dst, xform_ptr + i * XFORM_FLOATS, sizeof(float) * XFORM_FLOATS);
+		dst[XFORM_FLOATS + 0] = color_ptr[i].r;
+		dst[XFORM_FLOATS + 1] = color_ptr[i].g;
+		dst[XFORM_FLOATS + 2] = color_ptr[i].b;
+		dst[XFORM_FLOATS + 3] = color_ptr[i].a;
+	}
+}
+
+///////////////////////////
+// Private Functions
+///////////////////////////
+
+// Converts the pre 0.94 format: cell{v2i} -> [ TypedArray<Transform3D>, PackedColorArray, modified:bool ]
+void InstanceStore::_load_legacy_mesh(const int p_mesh_id, const Dictionary &p_cells) {
+	LOG(DEBUG, "Converting legacy instance data for mesh ", p_mesh_id);
+	CellMap &cells = _meshes[p_mesh_id];
+	Array cell_locations = p_cells.keys();
+	for (int c = 0; c < cell_locations.size(); c++) {
+		Vector2i cell_loc = cell_locations[c];
+		Array triple = p_cells[cell_loc];
+		if (triple.size() < 2) {
+			LOG(WARN, "Malformed instance data in mesh ", p_mesh_id, " cell ", cell_loc);
+			continue;
+		}
+		TypedArray<Transform3D> xforms = triple[0];
+		PackedColorArray colors = triple[1];
+		if (xforms.is_empty()) {
+			continue;
+		}
+		Cell &cell = cells[cell_loc];
+		for (int i = 0; i < xforms.size(); i++) {
+			cell.append(xforms[i], (i < colors.size()) ? colors[i] : COLOR_WHITE);
+		}
+	}
+	if (cells.empty()) {
+		_meshes.erase(p_mesh_id);
+	}
+}
+
+///////////////////////////
+// Public Functions
+///////////////////////////
+
+std::vector<int> InstanceStore::get_mesh_ids() const {
+	std::vector<int> ids;
+	ids.reserve(_meshes.size());
+	for (const auto &it : _meshes) {
+		ids.push_back(it.first);
+	}
+	return ids;
+}
+
+InstanceStore::CellMap *InstanceStore::get_cells(const int p_mesh_id) {
+	auto it = _meshes.find(p_mesh_id);
+	return (it != _meshes.end()) ? &it->second : nullptr;
+}
+
+const InstanceStore::CellMap *InstanceStore::get_cells(const int p_mesh_id) const {
+	auto it = _meshes.find(p_mesh_id);
+	return (it != _meshes.end()) ? &it->second : nullptr;
+}
+
+InstanceStore::Cell *InstanceStore::get_cell(const int p_mesh_id, const Vector2i &p_cell) {
+	CellMap *cells = get_cells(p_mesh_id);
+	if (!cells) {
+		return nullptr;
+	}
+	auto it = cells->find(p_cell);
+	return (it != cells->end()) ? &it->second : nullptr;
+}
+
+// Removes the cell, and the mesh if it was the last one
+void InstanceStore::erase_cell(const int p_mesh_id, const Vector2i &p_cell) {
+	auto it = _meshes.find(p_mesh_id);
+	if (it == _meshes.end()) {
+		return;
+	}
+	it->second.erase(p_cell);
+	if (it->second.empty()) {
+		_meshes.erase(it);
+	}
+}
+
+void InstanceStore::swap_meshes(const int p_src_id, const int p_dst_id) {
+	CellMap src, dst;
+	bool has_src = has_mesh(p_src_id);
+	bool has_dst = has_mesh(p_dst_id);
+	if (has_src) {
+		src = std::move(_meshes[p_src_id]);
+		_meshes.erase(p_src_id);
+	}
+	if (has_dst) {
+		dst = std::move(_meshes[p_dst_id]);
+		_meshes.erase(p_dst_id);
+	}
+	if (has_src) {
+		_meshes[p_dst_id] = std::move(src);
+	}
+	if (has_dst) {
+		_meshes[p_src_id] = std::move(dst);
+	}
+}
+
+// Scales the XZ origin of all instances, marking every cell modified
+void InstanceStore::scale_origins(const real_t p_scale) {
+	for (auto &mesh : _meshes) {
+		for (auto &it : mesh.second) {
+			Cell &cell = it.second;
+			float *ptr = cell.xforms.ptrw();
+			for (int i = 0, count = cell.size(); i < count; i++) {
+				ptr[i * XFORM_FLOATS + 3] *= p_scale;
+				ptr[i * XFORM_FLOATS + 11] *= p_scale;
+			}
+			cell.modified = true;
+		}
+	}
+}
+
+int InstanceStore::get_instance_count() const {
+	int count = 0;
+	for (const auto &mesh : _meshes) {
+		for (const auto &it : mesh.second) {
+			count += it.second.size();
+		}
+	}
+	return count;
+}
+
+// Loads mesh_id{int} -> { cells: PackedInt32Array(x, y, ...), counts: PackedInt32Array,
+// xforms: PackedFloat32Array, colors: PackedColorArray }, with the cells' instances in sequence
+void InstanceStore::set_data(const Dictionary &p_data) {
+	clear();
+	Array mesh_ids = p_data.keys();
+	for (int m = 0; m < mesh_ids.size(); m++) {
+		int mesh_id = mesh_ids[m];
+		Dictionary mesh_data = p_data[mesh_ids[m]];
+		if (!mesh_data.has("counts")) {
+			_load_legacy_mesh(mesh_id, mesh_data);
+			continue;
+		}
+		PackedInt32Array cell_locs = mesh_data.get("cells", PackedInt32Array());
+		PackedInt32Array counts = mesh_data.get("counts", PackedInt32Array());
+		PackedFloat32Array xforms = mesh_data.get("xforms", PackedFloat32Array());
+		PackedColorArray colors = mesh_data.get("colors", PackedColorArray());
+		// Counts are summed wide and must not be negative, so the copies below stay within the arrays
+		int64_t total = 0;
+		bool valid_counts = true;
+		for (int c = 0; c < counts.size(); c++) {
+			valid_counts = valid_counts && counts[c] >= 0;
+			total += counts[c];
+		}
+		if (!valid_counts || cell_locs.size() != counts.size() * 2 || colors.size() != total || xforms.size() != total * XFORM_FLOATS) {
+			LOG(ERROR, "Instance data for mesh ", mesh_id, " is corrupt. Cells: ", cell_locs.size() / 2,
+					", counts: ", counts.size(), ", transforms: ", xforms.size() / XFORM_FLOATS, ", colors: ", colors.size());
+			continue;
+		}
+		CellMap &cells = _meshes[mesh_id];
+		cells.reserve(counts.size());
+		const float *xform_ptr = xforms.ptr();
+		const Color *color_ptr = colors.ptr();
+		int offset = 0;
+		for (int c = 0; c < counts.size(); c++) {
+			int count = counts[c];
+			if (count <= 0) {
+				continue;
+			}
+			Cell &cell = cells[Vector2i(cell_locs[c * 2], cell_locs[c * 2 + 1])];
+			cell.xforms.resize(count * XFORM_FLOATS);
+			memcpy(cell.xforms.ptrw(), xform_ptr + offset * XFORM_FLOATS, sizeof(float) * XFORM_FLOATS * count);
+			cell.colors.resize(count);
+			memcpy(cell.colors.ptrw(), color_ptr + offset, sizeof(Color) * count);
+			offset += count;
+		}
+		if (cells.empty()) {
+			_meshes.erase(mesh_id);
+		}
+	}
+}
+
+Dictionary InstanceStore::get_data() const {
+	Dictionary data;
+	for (const auto &mesh : _meshes) {
+		int total = 0;
+		for (const auto &it : mesh.second) {
+			total += it.second.size();
+		}
+		if (total == 0) {
+			continue;
+		}
+		PackedInt32Array cell_locs;
+		PackedInt32Array counts;
+		PackedFloat32Array xforms;
+		PackedColorArray colors;
+		cell_locs.resize(mesh.second.size() * 2);
+		counts.resize(mesh.second.size());
+		xforms.resize(total * XFORM_FLOATS);
+		colors.resize(total);
+		int32_t *cell_ptr = cell_locs.ptrw();
+		int32_t *count_ptr = counts.ptrw();
+		float *xform_ptr = xforms.ptrw();
+		Color *color_ptr = colors.ptrw();
+		int c = 0;
+		int offset = 0;
+		for (const auto &it : mesh.second) {
+			int count = it.second.size();
+			cell_ptr[c * 2] = it.first.x;
+			cell_ptr[c * 2 + 1] = it.first.y;
+			count_ptr[c] = count;
+			memcpy(xform_ptr + offset * XFORM_FLOATS, it.second.xforms.ptr(), sizeof(float) * XFORM_FLOATS * count);
+			memcpy(color_ptr + offset, it.second.colors.ptr(), sizeof(Color) * count);
+			offset += count;
+			c++;
+		}
+		Dictionary mesh_data;
+		mesh_data["cells"] = cell_locs;
+		mesh_data["counts"] = counts;
+		mesh_data["xforms"] = xforms;
+		mesh_data["colors"] = colors;
+		data[mesh.first] = mesh_data;
+	}
+	return data;
+}
@@ -0,0 +1,99 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "constants.h"
+
+// Instance transforms and colors of one region, stored by mesh id and cell.
+// Each cell keeps its instances in two packed arrays: transforms as 12 floats in the layout of
+// MultiMesh::TRANSFORM_3D, and colors. Cells are looked up through a hash map by cell location.
+// The serialized form stores each mesh as a few packed arrays so it loads without converting
+// each instance to and from a Variant.
+class InstanceStore {
+	CLASS_NAME_STATIC("TerrainGeneratorInstanceStore");
+
+public: // Constants
+	static inline const int XFORM_FLOATS = 12; // Basis rows with origin, see MultiMesh::set_buffer()
+	static inline const int BUFFER_FLOATS = XFORM_FLOATS + 4; // With color
+
+	struct Cell {
+		PackedFloat32Array xforms;
+		PackedColorArray colors;
+		bool modified = true; // Cleared once its MMIs are up to date
+
+		int size() const { return colors.size(); }
+		bool is_empty() const { return colors.is_empty(); }
+		Transform3D get_xform(const int p_index) const;
+		void set_xform(const int p_index, const Transform3D &p_xform);
+		void append(const Transform3D &p_xform, const Color &p_color);
+		void remove_if(const std::vector<bool> &p_remove);
+		void fill_buffer(float *r_buffer) const;
+	};
+
+	typedef std::unordered_map<Vector2i, Cell, Vector2iHash> CellMap;
+
+private:
+	std::map<int, CellMap> _meshes; // mesh_id -> cell -> Cell
+
+	static void _xform_to_floats(const Transform3D &p_xform, float *r_floats);
+	static Transform3D _floats_to_xform(const float *p_floats);
+	void _load_legacy_mesh(const int p_mesh_id, const Dictionary &p_cells);
+
+public:
+	InstanceStore() {}
+
+	bool is_empty() const { return _meshes.empty(); }
+	void clear() { _meshes.clear(); }
+	std::vector<int> get_mesh_ids() const;
+	bool has_mesh(const int p_mesh_id) const { return _meshes.count(p_mesh_id) > 0; }
+	CellMap *get_cells(const int p_mesh_id);
+	const CellMap *get_cells(const int p_mesh_id) const;
+	CellMap &get_or_create_cells(const int p_mesh_id) { return _meshes[p_mesh_id]; }
+	Cell *get_cell(const int p_mesh_id, const Vector2i &p_cell);
+	void erase_mesh(const int p_mesh_id) { _meshes.erase(p_mesh_id); }
+	void erase_cell(const int p_mesh_id, const Vector2i &p_cell);
+	void swap_meshes(const int p_src_id, const int p_dst_id);
+	void scale_origins(const real_t p_scale);
+	int get_instance_count() const;
+
+	// Serialization
+	void set_data(const Dictionary &p_data);
+	Dictionary get_data() const;
+};
+
+// Inline Functions
+
+inline void InstanceStore::_xform_to_floats(const Transform3D &p_xform, float *r_floats) {
+	for (int r = 0; r < 3; r++) {
+		r_floats[r * 4 + 0] = float(p_xform.basis.rows[r].x);
+		r_floats[r * 4 + 1] = float(p_xform.basis.rows[r].y);
+		r_floats[r * 4 + 2] = float(p_xform.basis.rows[r].z);
+		r_floats[r * 4 + 3] = float(p_xform.origin[r]);
+	}
+}
+
+inline Transform3D InstanceStore::_floats_to_xform(const float *p_floats) {
+	return Transform3D(p_floats[0], p_floats[1], p_floats[2],
+			p_floats[4], p_floats[5], p_floats[6],
+			p_floats[8], p_floats[9], p_floats[10],
+			p_floats[3], p_floats[7], p_floats[11]);
+}
+
+inline Transform3D InstanceStore::Cell::get_xform(const int p_index) const {
+	return _floats_to_xform(xforms.ptr() + p_index * XFORM_FLOATS);
+}
+
+inline void InstanceStore::Cell::set_xform(const int p_index, const Transform3D &p_xform) {
+	_xform_to_floats(p_xform, xforms.ptrw() + p_index * XFORM_FLOATS);
+}
+
+inline void InstanceStore::Cell::append(const Transform3D &p_xform, const Color &p_color) {
+	int index = colors.size();
+	xforms.resize((index + 1) * XFORM_FLOATS);
+	_xform_to_floats(p_xform, xforms.ptrw() + index * XFORM_FLOATS);
+	colors.push_back(p_color);
+}
@@ -0,0 +1,286 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TG_SNAPSHOT_SSE
+#endif
+
+#include "logger.h"
+#include "map_snapshot.h"
+#include "terrain_generator_data.h"
+
+// Positions this close to a vertex use only that vertex, as in TerrainGeneratorData::get_height()
+#define VERTEX_EPSILON 0.0001f
+
+///////////////////////////
+// Private Functions
+///////////////////////////
+
+// Bilinear interpolation of a chunk of gathered heights. Four positions at a time with SSE,
+// remainder (or everything without SSE) in the scalar loop, which compilers auto-vectorize.
+static void _bilerp_chunk(const float *p_h00, const float *p_h01, const float *p_h10, const float *p_h11,
+		const float *p_fx, const float *p_fz, float *r_heights, const int p_count) {
+	int i = 0;
+#ifdef TG_SNAPSHOT_SSE
+	for (; i + 4 <= p_count; i += 4) {
+		__m128 fx = _mm_loadu_ps(p_fx + i);
+		__m128 fz = _mm_loadu_ps(p_fz + i);
+		__m128 h00 = _mm_loadu_ps(p_h00 + i);
+		__m128 h01 = _mm_loadu_ps(p_h01 + i);
+		__m128 top = _mm_add_ps(h00, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p_h10 + i), h00), fx));
+		__m128 bottom = _mm_add_ps(h01, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p_h11 + i), h01), fx));
+		_mm_storeu_ps(r_heights + i, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fz)));
+	}
+#endif
+	for (; i < p_count; i++) {
+		float top = p_h00[i] + (p_h10[i] - p_h00[i]) * p_fx[i];
+		float bottom = p_h01[i] + (p_h11[i] - p_h01[i]) * p_fx[i];
+		r_heights[i] = top + (bottom - top) * p_fz[i];
+	}
+}
+
+// Fetches the 4 vertices surrounding each position and the position's fraction between them.
+// Holes and positions outside of regions return NAN in all 4.
+void MapSnapshot::_gather_heights(const Vector3 *p_positions, const int p_count, float *r_h00, float *r_h01,
+		float *r_h10, float *r_h11, float *r_fx, float *r_fz) const {
+	const real_t inv_spacing = 1.f / _vertex_spacing;
+	const Region *region = nullptr;
+	int region_x = INT32_MAX;
+	int region_z = INT32_MAX;
+	for (int i = 0; i < p_count; i++) {
+		real_t x = p_positions[i].x * inv_spacing;
+		real_t z = p_positions[i].z * inv_spacing;
+		real_t x0f = Math::floor(x);
+		real_t z0f = Math::floor(z);
+		int x0 = int(x0f);
+		int z0 = int(z0f);
+		float fx = float(x - x0f);
+		float fz = float(z - z0f);
+
+		// Neighboring positions usually share a region, so only resolve it when it changes
+		if ((x0 >> _region_shift) != region_x || (z0 >> _region_shift) != region_z) {
+			region_x = x0 >> _region_shift;
+			region_z = z0 >> _region_shift;
+			region = _get_region(x0, z0);
+		}
+		int lx = x0 & _region_mask;
+		int lz = z0 & _region_mask;
+		if (!region || !region->heights || (region->controls && is_hole(region->controls[lz * _region_size + lx]))) {
+			r_h00[i] = r_h01[i] = r_h10[i] = r_h11[i] = NAN;
+			r_fx[i] = r_fz[i] = 0.f;
+			continue;
+		}
+
+		if (lx < _region_mask && lz < _region_mask) {
+			// All 4 vertices in this region
+			const float *row = region->heights + lz * _region_size + lx;
+			r_h00[i] = row[0];
+			r_h10[i] = row[1];
+			r_h01[i] = row[_region_size];
+			r_h11[i] = row[_region_size + 1];
+		} else {
+			// On the far edge, reading from the neighboring regions
+			r_h00[i] = region->heights[lz * _region_size + lx];
+			r_h10[i] = get_height_pixel(x0 + 1, z0);
+			r_h01[i] = get_height_pixel(x0, z0 + 1);
+			r_h11[i] = get_height_pixel(x0 + 1, z0 + 1);
+		}
+
+		// Snap to a vertex when close enough so missing neighbors don't leak NAN into the result
+		if (fx < VERTEX_EPSILON) {
+			r_h10[i] = r_h00[i];
+			r_h11[i] = r_h01[i];
+			fx = 0.f;
+		}
+		if (fz < VERTEX_EPSILON) {
+			r_h01[i] = r_h00[i];
+			r_h11[i] = r_h10[i];
+			fz = 0.f;
+		}
+		r_fx[i] = fx;
+		r_fz[i] = fz;
+	}
+}
+
+///////////////////////////
+// Public Functions
+///////////////////////////
+
+void MapSnapshot::create(const TerrainGeneratorData *p_data) {
+	clear();
+	if (!p_data || p_data->get_region_count() == 0) {
+		return;
+	}
+	LOG(EXTREME, "Creating map snapshot of ", p_data->get_region_count(), " regions");
+	_region_size = p_data->_region_size;
+	if (_region_size <= 0 || !is_power_of_2(_region_size)) {
+		LOG(ERROR, "Invalid region size: ", _region_size);
+		_region_size = 0;
+		return;
+	}
+	_region_mask = _region_size - 1;
+	_region_shift = 0;
+	while ((1 << _region_shift) < _region_size) {
+		_region_shift++;
+	}
+	_vertex_spacing = p_data->_vertex_spacing;
+	_map_size = TerrainGeneratorData::REGION_MAP_SIZE;
+	_region_map.assign(_map_size * _map_size, 0);
+
+	TypedArray<Vector2i> region_locations = p_data->get_region_locations();
+	_regions.reserve(region_locations.size());
+	for (int i = 0; i < region_locations.size(); i++) {
+		Vector2i region_loc = region_locations[i];
+		TerrainGeneratorRegion *region = p_data->get_region_ptr(region_loc);
+		int map_index = TerrainGeneratorData::get_region_map_index(region_loc);
+		if (!region || region->is_deleted() || map_index < 0) {
+			continue;
+		}
+		Region snap;
+		Image *height_map = region->get_map_ptr(TYPE_HEIGHT);
+		if (height_map && height_map->get_format() == FORMAT[TYPE_HEIGHT] && height_map->get_width() == _region_size) {
+			snap.height_data = height_map->get_data();
+			snap.heights = reinterpret_cast<const float *>(snap.height_data.ptr());
+		}
+		Image *control_map = region->get_map_ptr(TYPE_CONTROL);
+		if (control_map && control_map->get_format() == FORMAT[TYPE_CONTROL] && control_map->get_width() == _region_size) {
+			snap.control_data = control_map->get_data();
+			snap.controls = reinterpret_cast<const uint32_t *>(snap.control_data.ptr());
+		}
+		_regions.push_back(snap);
+		_region_map[map_index] = _regions.size();
+	}
+}
+
+void MapSnapshot::clear() {
+	_region_size = 0;
+	_region_shift = 0;
+	_region_mask = 0;
+	_map_size = 0;
+	_region_map.clear();
+	_regions.clear();
+}
+
+// Interpolated heights. NAN for holes or outside of regions.
+void MapSnapshot::get_heights(const Vector3 *p_positions, real_t *r_heights, const int p_count) const {
+	if (is_empty()) {
+		for (int i = 0; i < p_count; i++) {
+			r_heights[i] = NAN;
+		}
+		return;
+	}
+	float h00[CHUNK_SIZE], h01[CHUNK_SIZE], h10[CHUNK_SIZE], h11[CHUNK_SIZE];
+	float fx[CHUNK_SIZE], fz[CHUNK_SIZE], heights[CHUNK_SIZE];
+	for (int start = 0; start < p_count; start += CHUNK_SIZE) {
+		int count = MIN(CHUNK_SIZE, p_count - start);
+		_gather_heights(p_positions + start, count, h00, h01, h10, h11, fx, fz);
+		_bilerp_chunk(h00, h01, h10, h11, fx, fz, heights, count);
+		for (int i = 0; i < count; i++) {
+			r_heights[start + i] = heights[i];
+		}
+	}
+}
+
+// Normals from the height slope along +X and +Z. NAN for holes or outside of regions.
+void MapSnapshot::get_normals(const Vector3 *p_positions, Vector3 *r_normals, const int p_count) const {
+	Vector3 pos_x[CHUNK_SIZE], pos_z[CHUNK_SIZE];
+	real_t height[CHUNK_SIZE], height_x[CHUNK_SIZE], height_z[CHUNK_SIZE];
+	for (int start = 0; start < p_count; start += CHUNK_SIZE) {
+		int count = MIN(CHUNK_SIZE, p_count - start);
+		const Vector3 *pos = p_positions + start;
+		for (int i = 0; i < count; i++) {
+			pos_x[i] = pos[i] + Vector3(_vertex_spacing, 0.f, 0.f);
+			pos_z[i] = pos[i] + Vector3(0.f, 0.f, _vertex_spacing);
+		}
+		get_heights(pos, height, count);
+		get_heights(pos_x, height_x, count);
+		get_heights(pos_z, height_z, count);
+		for (int i = 0; i < count; i++) {
+			if (std::isnan(height[i])) {
+				r_normals[start + i] = Vector3(NAN, NAN, NAN);
+				continue;
+			}
+			Vector3 normal = Vector3(height[i] - height_x[i], _vertex_spacing, height[i] - height_z[i]);
+			normal.normalize();
+			r_normals[start + i] = normal;
+		}
+	}
+}
+
+// Control map bits at the nearest pixel. UINT32_MAX outside of regions.
+void MapSnapshot::get_controls(const Vector3 *p_positions, uint32_t *r_controls, const int p_count) const {
+	if (is_empty()) {
+		for (int i = 0; i < p_count; i++) {
+			r_controls[i] = UINT32_MAX;
+		}
+		return;
+	}
+	const real_t inv_spacing = 1.f / _vertex_spacing;
+	for (int i = 0; i < p_count; i++) {
+		r_controls[i] = get_control_pixel(int(Math::floor(p_positions[i].x * inv_spacing)),
+				int(Math::floor(p_positions[i].z * inv_spacing)));
+	}
+}
+
+///////////////////////////
+// TerrainGeneratorMapSnapshot
+///////////////////////////
+
+real_t TerrainGeneratorMapSnapshot::get_height(const Vector3 &p_global_position) const {
+	real_t height;
+	_maps.get_heights(&p_global_position, &height, 1);
+	return height;
+}
+
+Vector3 TerrainGeneratorMapSnapshot::get_normal(const Vector3 &p_global_position) const {
+	Vector3 normal;
+	_maps.get_normals(&p_global_position, &normal, 1);
+	return normal;
+}
+
+uint32_t TerrainGeneratorMapSnapshot::get_control(const Vector3 &p_global_position) const {
+	uint32_t control;
+	_maps.get_controls(&p_global_position, &control, 1);
+	return control;
+}
+
+PackedRealArray TerrainGeneratorMapSnapshot::get_heights(const PackedVector3Array &p_global_positions) const {
+	PackedRealArray heights;
+	heights.resize(p_global_positions.size());
+	_maps.get_heights(p_global_positions.ptr(), heights.ptrw(), p_global_positions.size());
+	return heights;
+}
+
+PackedVector3Array TerrainGeneratorMapSnapshot::get_normals(const PackedVector3Array &p_global_positions) const {
+	PackedVector3Array normals;
+	normals.resize(p_global_positions.size());
+	_maps.get_normals(p_global_positions.ptr(), normals.ptrw(), p_global_positions.size());
+	return normals;
+}
+
+// Control bits as ints; -1 (UINT32_MAX) where there is no region
+PackedInt32Array TerrainGeneratorMapSnapshot::get_controls(const PackedVector3Array &p_global_positions) const {
+	PackedInt32Array controls;
+	controls.resize(p_global_positions.size());
+	_maps.get_controls(p_global_positions.ptr(), reinterpret_cast<uint32_t *>(controls.ptrw()), p_global_positions.size());
+	return controls;
+}
+
+///////////////////////////
+// Protected Functions
+///////////////////////////
+
+void TerrainGeneratorMapSnapshot::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("update", "data"), &TerrainGeneratorMapSnapshot::update);
+	ClassDB::bind_method(D_METHOD("clear"), &TerrainGeneratorMapSnapshot::clear);
+	ClassDB::bind_method(D_METHOD("is_empty"), &TerrainGeneratorMapSnapshot::is_empty);
+	ClassDB::bind_method(D_METHOD("get_region_size"), &TerrainGeneratorMapSnapshot::get_region_size);
+	ClassDB::bind_method(D_METHOD("get_vertex_spacing"), &TerrainGeneratorMapSnapshot::get_vertex_spacing);
+
+	ClassDB::bind_method(D_METHOD("get_height", "global_position"), &TerrainGeneratorMapSnapshot::get_height);
+	ClassDB::bind_method(D_METHOD("get_normal", "global_position"), &TerrainGeneratorMapSnapshot::get_normal);
+	ClassDB::bind_method(D_METHOD("get_control", "global_position"), &TerrainGeneratorMapSnapshot::get_control);
+	ClassDB::bind_method(D_METHOD("get_heights", "global_positions"), &TerrainGeneratorMapSnapshot::get_heights);
+	ClassDB::bind_method(D_METHOD("get_normals", "global_positions"), &TerrainGeneratorMapSnapshot::get_normals);
+	ClassDB::bind_method(D_METHOD("get_controls", "global_positions"), &TerrainGeneratorMapSnapshot::get_controls);
+}
@@ -0,0 +1,134 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/io/image.h>
+#include <vector>
+
+#include "constants.h"
+
+class TerrainGeneratorData;
+
+// A read-only copy of the height and control maps of all active regions for bulk queries.
+// The map buffers are shared copy-on-write with the regions, so creating a snapshot is cheap and
+// later edits to the terrain don't affect it. Create it on the main thread, then it may be queried
+// from any number of threads. Scripts use it through TerrainGeneratorMapSnapshot.
+class MapSnapshot {
+	CLASS_NAME_STATIC("TerrainGeneratorMapSnapshot");
+
+public: // Constants
+	static inline const int CHUNK_SIZE = 64; // Positions processed per batch step
+
+private:
+	struct Region {
+		PackedByteArray height_data;
+		PackedByteArray control_data;
+		const float *heights = nullptr;
+		const uint32_t *controls = nullptr;
+	};
+
+	int _region_size = 0;
+	int _region_shift = 0; // log2(_region_size)
+	int _region_mask = 0; // _region_size - 1
+	real_t _vertex_spacing = 1.f;
+	int _map_size = 0;
+	std::vector<int32_t> _region_map; // region_map_index -> index in _regions + 1, 0 = no region
+	std::vector<Region> _regions;
+
+	const Region *_get_region(const int p_x, const int p_z) const;
+	void _gather_heights(const Vector3 *p_positions, const int p_count, float *r_h00, float *r_h01,
+			float *r_h10, float *r_h11, float *r_fx, float *r_fz) const;
+
+public:
+	MapSnapshot() {}
+	MapSnapshot(const TerrainGeneratorData *p_data) { create(p_data); }
+
+	void create(const TerrainGeneratorData *p_data);
+	void clear();
+	bool is_empty() const { return _regions.empty(); }
+	int get_region_size() const { return _region_size; }
+	real_t get_vertex_spacing() const { return _vertex_spacing; }
+
+	// Direct pixel access in descaled global coordinates
+	float get_height_pixel(const int p_x, const int p_z) const;
+	uint32_t get_control_pixel(const int p_x, const int p_z) const;
+	bool get_pixel_ptrs(const int p_x, const int p_z, const float *&r_heights, const uint32_t *&r_controls) const;
+
+	// Bulk queries matching TerrainGeneratorData::get_height(), get_normal() and get_control()
+	void get_heights(const Vector3 *p_positions, real_t *r_heights, const int p_count) const;
+	void get_normals(const Vector3 *p_positions, Vector3 *r_normals, const int p_count) const;
+	void get_controls(const Vector3 *p_positions, uint32_t *r_controls, const int p_count) const;
+};
+
+// A MapSnapshot exposed to scripts. Get one from TerrainGeneratorData::get_map_snapshot() on the main
+// thread and keep it for repeated queries, from any thread, rather than paying for a new snapshot per
+// call. Call update() on the main thread to pick up later edits.
+class TerrainGeneratorMapSnapshot : public RefCounted {
+	GDCLASS(TerrainGeneratorMapSnapshot, RefCounted);
+	CLASS_NAME();
+
+private:
+	MapSnapshot _maps;
+
+public:
+	TerrainGeneratorMapSnapshot() {}
+
+	void update(const TerrainGeneratorData *p_data) { _maps.create(p_data); }
+	void clear() { _maps.clear(); }
+	bool is_empty() const { return _maps.is_empty(); }
+	int get_region_size() const { return _maps.get_region_size(); }
+	real_t get_vertex_spacing() const { return _maps.get_vertex_spacing(); }
+	const MapSnapshot &get_maps() const { return _maps; }
+
+	real_t get_height(const Vector3 &p_global_position) const;
+	Vector3 get_normal(const Vector3 &p_global_position) const;
+	uint32_t get_control(const Vector3 &p_global_position) const;
+	PackedRealArray get_heights(const PackedVector3Array &p_global_positions) const;
+	PackedVector3Array get_normals(const PackedVector3Array &p_global_positions) const;
+	PackedInt32Array get_controls(const PackedVector3Array &p_global_positions) const;
+
+protected:
+	static void _bind_methods();
+};
+
+// Inline Functions
+
+// Returns the region holding the descaled global pixel, or nullptr
+inline const MapSnapshot::Region *MapSnapshot::_get_region(const int p_x, const int p_z) const {
+	int loc_x = (p_x >> _region_shift) + _map_size / 2;
+	int loc_z = (p_z >> _region_shift) + _map_size / 2;
+	if (loc_x < 0 || loc_z < 0 || loc_x >= _map_size || loc_z >= _map_size) {
+		return nullptr;
+	}
+	int region_id = _region_map[loc_z * _map_size + loc_x];
+	return (region_id > 0) ? &_regions[region_id - 1] : nullptr;
+}
+
+inline float MapSnapshot::get_height_pixel(const int p_x, const int p_z) const {
+	const Region *region = _get_region(p_x, p_z);
+	if (!region || !region->heights) {
+		return NAN;
+	}
+	return region->heights[(p_z & _region_mask) * _region_size + (p_x & _region_mask)];
+}
+
+inline uint32_t MapSnapshot::get_control_pixel(const int p_x, const int p_z) const {
+	const Region *region = _get_region(p_x, p_z);
+	if (!region || !region->controls) {
+		return UINT32_MAX;
+	}
+	return region->controls[(p_z & _region_mask) * _region_size + (p_x & _region_mask)];
+}
+
+// Raw map pointers at the descaled global pixel, valid to the end of its row in that region.
+// Returns false if there is no region or it lacks a height or control map.
+inline bool MapSnapshot::get_pixel_ptrs(const int p_x, const int p_z, const float *&r_heights, const uint32_t *&r_controls) const {
+	const Region *region = _get_region(p_x, p_z);
+	if (!region || !region->heights || !region->controls) {
+		return false;
+	}
+	int index = (p_z & _region_mask) * _region_size + (p_x & _region_mask);
+	r_heights = region->heights + index;
+	r_controls = region->controls + index;
+	return true;
+}
@@ -4,7 +4,11 @@
 
 #include "register_types.h"
 #include "terrain_generator.h"
+#include "terrain_generator_benchmark.h"
 #include "terrain_generator_editor.h"
+#include "terrain_generator_procedural.h"
+#include "terrain_generator_region_file.h"
+#include "terrain_generator_undo_delta.h"
 
 void initialize_terrain_generator_module(ModuleInitializationLevel p_level) {
 	if (p_level != MODULE_INITIALIZATION_LEVEL_SCENE) {
@@ -12,14 +16,20 @@ void initialize_terrain_generator_module(ModuleInitializationLevel p_level) {
 	}
 	ClassDB::register_class<TerrainGenerator>();
 	ClassDB::register_class<TerrainGeneratorAssets>();
+	ClassDB::register_class<TerrainGeneratorBenchmark>();
 	ClassDB::register_class<TerrainGeneratorData>();
 	ClassDB::register_class<TerrainGeneratorEditor>();
 	ClassDB::register_class<TerrainGeneratorCollision>();
 	ClassDB::register_class<TerrainGeneratorInstancer>();
+	ClassDB::register_class<TerrainGeneratorMapSnapshot>();
 	ClassDB::register_class<TerrainGeneratorMaterial>();
 	ClassDB::register_class<TerrainGeneratorMeshAsset>();
+	ClassDB::register_class<TerrainGeneratorProcedural>();
+	ClassDB::register_class<TerrainGeneratorProceduralStage>();
 	ClassDB::register_class<TerrainGeneratorRegion>();
+	ClassDB::register_class<TerrainGeneratorRegionFile>();
 	ClassDB::register_class<TerrainGeneratorTextureAsset>();
+	ClassDB::register_class<TerrainGeneratorUndoDelta>();
 	ClassDB::register_class<TerrainGeneratorUtil>();
 }
 
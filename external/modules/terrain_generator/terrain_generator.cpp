@@ -22,6 +22,7 @@
 
 #include "logger.h"
 #include "terrain_generator.h"
+#include "terrain_generator_profiler.h"
 #include "terrain_generator_util.h"
 
 // Initialize static member variable
@@ -59,6 +60,11 @@ void TerrainGenerator::_initialize() {
 		LOG(DEBUG, "Creating mesher");
 		_mesher = new TerrainGeneratorMesher();
 	}
+	if (!_baker) {
+		LOG(DEBUG, "Creating mesh baker");
+		_baker = new TerrainGeneratorMeshBaker();
+		_baker->initialize(this);
+	}
 
 	// Connect signals
 	// Any region was changed, update region labels
@@ -71,6 +77,25 @@ void TerrainGenerator::_initialize() {
 		LOG(DEBUG, "Connecting _data::region_map_changed signal to build()");
 		_data->connect("region_map_changed", callable_mp(_collision, &TerrainGeneratorCollision::build));
 	}
+	// Maps were edited, drop cached collision shapes in the area
+	if (!_data->is_connected("maps_edited", callable_mp(_collision, &TerrainGeneratorCollision::_invalidate_shapes))) {
+		LOG(DEBUG, "Connecting _data::maps_edited signal to _collision->_invalidate_shapes()");
+		_data->connect("maps_edited", callable_mp(_collision, &TerrainGeneratorCollision::_invalidate_shapes));
+	}
+	// Maps were edited, or regions changed, drop baked tiles
+	if (!_data->is_connected("maps_edited", callable_mp(this, &TerrainGenerator::_invalidate_baked_tiles))) {
+		LOG(DEBUG, "Connecting _data::maps_edited signal to _invalidate_baked_tiles()");
+		_data->connect("maps_edited", callable_mp(this, &TerrainGenerator::_invalidate_baked_tiles));
+	}
+	if (!_data->is_connected("region_map_changed", callable_mp(this, &TerrainGenerator::_clear_baked_tiles))) {
+		LOG(DEBUG, "Connecting _data::region_map_changed signal to _clear_baked_tiles()");
+		_data->connect("region_map_changed", callable_mp(this, &TerrainGenerator::_clear_baked_tiles));
+	}
+	// Regions were streamed in or out, update only what is over them
+	if (!_data->is_connected("regions_streamed", callable_mp(this, &TerrainGenerator::_update_streamed_regions))) {
+		LOG(DEBUG, "Connecting _data::regions_streamed signal to _update_streamed_regions()");
+		_data->connect("regions_streamed", callable_mp(this, &TerrainGenerator::_update_streamed_regions));
+	}
 	// Any map was regenerated or regions changed, update material
 	if (!_data->is_connected("maps_changed", callable_mp(_material.ptr(), &TerrainGeneratorMaterial::_update_maps))) {
 		LOG(DEBUG, "Connecting _data::maps_changed signal to _material->_update_maps()");
@@ -117,6 +142,9 @@ void TerrainGenerator::__physics_process(const double p_delta) {
 		LOG(DEBUG, "Camera is null, getting the current one");
 		_grab_camera();
 	}
+	if (_region_streaming) {
+		_data->update_streaming();
+	}
 	if (_mesher) {
 		_mesher->snap();
 	}
@@ -192,6 +220,21 @@ void TerrainGenerator::_destroy_mesher(const bool p_final) {
 	}
 }
 
+// Regions were streamed in or out. Drops collision shapes and baked tiles only over them.
+void TerrainGenerator::_update_streamed_regions(const TypedArray<Vector2i> &p_loaded, const TypedArray<Vector2i> &p_evicted) {
+	update_region_labels();
+	TypedArray<Vector2i> locations = p_loaded.duplicate();
+	locations.append_array(p_evicted);
+	if (_collision) {
+		_collision->_invalidate_regions(locations);
+	}
+	real_t region_width = _region_size * _vertex_spacing;
+	for (int i = 0; i < locations.size(); i++) {
+		Vector2i loc = locations[i];
+		_invalidate_baked_tiles(AABB(Vector3(loc.x * region_width, 0.f, loc.y * region_width), Vector3(region_width, 0.f, region_width)));
+	}
+}
+
 void TerrainGenerator::_setup_mouse_picking() {
 	if (!is_inside_tree()) {
 		LOG(ERROR, "Not inside the tree, skipping mouse setup");
@@ -260,127 +303,6 @@ void TerrainGenerator::_destroy_mouse_picking() {
 	memdelete_safely(_mouse_vp);
 }
 
-void TerrainGenerator::_generate_triangles(PackedVector3Array &p_vertices, PackedVector2Array *p_uvs, const int32_t p_lod,
-		const TerrainGeneratorData::HeightFilter p_filter, const bool p_require_nav, const AABB &p_global_aabb) const {
-	ERR_FAIL_COND(_data == nullptr);
-	int32_t step = 1 << CLAMP(p_lod, 0, 8);
-
-	// Bake whole mesh, e.g. bake_mesh and painted navigation
-	if (!p_global_aabb.has_volume()) {
-		int32_t region_size = (int32_t)_region_size;
-
-		TypedArray<Vector2i> region_locations = _data->get_region_locations();
-		for (int r = 0; r < region_locations.size(); ++r) {
-			Vector2i region_loc = (Vector2i)region_locations[r] * region_size;
-
-			for (int32_t z = region_loc.y; z < region_loc.y + region_size; z += step) {
-				for (int32_t x = region_loc.x; x < region_loc.x + region_size; x += step) {
-					_generate_triangle_pair(p_vertices, p_uvs, p_lod, p_filter, p_require_nav, x, z);
-				}
-			}
-		}
-	} else {
-		// Bake within an AABB, e.g. runtime navigation baker
-		int32_t z_start = (int32_t)Math::ceil(p_global_aabb.position.z / _vertex_spacing);
-		int32_t z_end = (int32_t)Math::floor(p_global_aabb.get_end().z / _vertex_spacing) + 1;
-		int32_t x_start = (int32_t)Math::ceil(p_global_aabb.position.x / _vertex_spacing);
-		int32_t x_end = (int32_t)Math::floor(p_global_aabb.get_end().x / _vertex_spacing) + 1;
-
-		for (int32_t z = z_start; z < z_end; ++z) {
-			for (int32_t x = x_start; x < x_end; ++x) {
-				real_t height = _data->get_height(Vector3(x, 0.f, z));
-				if (height >= p_global_aabb.position.y && height <= p_global_aabb.get_end().y) {
-					_generate_triangle_pair(p_vertices, p_uvs, p_lod, p_filter, p_require_nav, x, z);
-				}
-			}
-		}
-	}
-}
-
-// Generates two triangles: Top 124, Bottom 143
-//		1  __  2
-//		  |\ |
-//		  | \|
-//		3  --  4
-// p_vertices is assumed to exist and the destination for data
-// p_uvs might not exist, so a pointer is fine
-// p_require_nav is false for the runtime baker, which ignores navigation
-void TerrainGenerator::_generate_triangle_pair(PackedVector3Array &p_vertices, PackedVector2Array *p_uvs,
-		const int32_t p_lod, const TerrainGeneratorData::HeightFilter p_filter, const bool p_require_nav,
-		const int32_t x, const int32_t z) const {
-	int32_t step = 1 << CLAMP(p_lod, 0, 8);
-	Vector3 xz = Vector3(x, 0.0f, z) * _vertex_spacing;
-	Vector3 xsz = Vector3(x + step, 0.0f, z) * _vertex_spacing;
-	Vector3 xzs = Vector3(x, 0.0f, z + step) * _vertex_spacing;
-	Vector3 xszs = Vector3(x + step, 0.0f, z + step) * _vertex_spacing;
-	Vector3 v1 = _data->get_mesh_vertex(p_lod, p_filter, xz);
-	bool nan1 = std::isnan(v1.y);
-	if (nan1) {
-		return;
-	}
-	Vector3 v2 = _data->get_mesh_vertex(p_lod, p_filter, xsz);
-	Vector3 v3 = _data->get_mesh_vertex(p_lod, p_filter, xzs);
-	Vector3 v4 = _data->get_mesh_vertex(p_lod, p_filter, xszs);
-	bool nan2 = std::isnan(v2.y);
-	bool nan3 = std::isnan(v3.y);
-	bool nan4 = std::isnan(v4.y);
-	// If on the region edge, duplicate the edge pixels
-	// Check #2 upper right
-	if (nan2) {
-		v2.y = v1.y;
-	}
-	// Check #3 lower left
-	if (nan3) {
-		v3.y = v1.y;
-	}
-	// Check #4 lower right
-	if (nan4) {
-		if (!nan2) {
-			v4.y = v2.y;
-		} else if (!nan3) {
-			v4.y = v3.y;
-		} else {
-			v4.y = v1.y;
-		}
-	}
-	uint32_t ctrl1 = _data->get_control(xz);
-	uint32_t ctrl2 = _data->get_control(xsz);
-	uint32_t ctrl3 = _data->get_control(xzs);
-	uint32_t ctrl4 = _data->get_control(xszs);
-	// Holes are only where the control map is valid and the bit is set
-	bool hole1 = ctrl1 != UINT32_MAX && is_hole(ctrl1);
-	bool hole2 = ctrl2 != UINT32_MAX && is_hole(ctrl2);
-	bool hole3 = ctrl3 != UINT32_MAX && is_hole(ctrl3);
-	bool hole4 = ctrl4 != UINT32_MAX && is_hole(ctrl4);
-	// Navigation is where the control map is valid and the bit is set, or it's the region edge and nav1 is set
-	bool nav1 = ctrl1 != UINT32_MAX && is_nav(ctrl1);
-	bool nav2 = ctrl2 != (UINT32_MAX && is_nav(ctrl2)) || (nan2 && nav1);
-	bool nav3 = ctrl3 != (UINT32_MAX && is_nav(ctrl3)) || (nan3 && nav1);
-	bool nav4 = ctrl4 != (UINT32_MAX && is_nav(ctrl4)) || (nan4 && nav1);
-	//Bottom 143 triangle
-	if (!(hole1 || hole4 || hole3) && (!p_require_nav || (nav1 && nav4 && nav3))) {
-		p_vertices.push_back(v1);
-		p_vertices.push_back(v4);
-		p_vertices.push_back(v3);
-		if (p_uvs) {
-			p_uvs->push_back(Vector2(v1.x, v1.z));
-			p_uvs->push_back(Vector2(v4.x, v4.z));
-			p_uvs->push_back(Vector2(v3.x, v3.z));
-		}
-	}
-	// Top 124 triangle
-	if (!(hole1 || hole2 || hole4) && (!p_require_nav || (nav1 && nav2 && nav4))) {
-		p_vertices.push_back(v1);
-		p_vertices.push_back(v2);
-		p_vertices.push_back(v4);
-		if (p_uvs) {
-			p_uvs->push_back(Vector2(v1.x, v1.z));
-			p_uvs->push_back(Vector2(v2.x, v2.z));
-			p_uvs->push_back(Vector2(v4.x, v4.z));
-		}
-	}
-}
-
 ///////////////////////////
 // Public Functions
 ///////////////////////////
@@ -451,6 +373,15 @@ void TerrainGenerator::set_assets(const Ref<TerrainGeneratorAssets> &p_assets) {
 	}
 }
 
+// Generates new regions made by TerrainGeneratorData::add_region_blank() and generate_regions()
+void TerrainGenerator::set_procedural(const Ref<TerrainGeneratorProcedural> &p_procedural) {
+	if (_procedural != p_procedural) {
+		LOG(INFO, "Setting procedural generator");
+		_procedural = p_procedural;
+		emit_signal("procedural_changed");
+	}
+}
+
 void TerrainGenerator::set_editor(TerrainGeneratorEditor *p_editor) {
 	if (p_editor && p_editor->is_queued_for_deletion()) {
 		LOG(ERROR, "Attempted to set a node queued for deletion");
@@ -540,6 +471,13 @@ void TerrainGenerator::set_save_16_bit(const bool p_enabled) {
 	_save_16_bit = p_enabled;
 }
 
+// Saves regions as tiled region files (*.tgr) instead of resources (*.res). Either loads.
+// Regions are converted as they are next saved. Exports need *.tgr in the non-resource file filter.
+void TerrainGenerator::set_tiled_region_files(const bool p_enabled) {
+	LOG(INFO, p_enabled);
+	_tiled_region_files = p_enabled;
+}
+
 void TerrainGenerator::set_label_distance(const real_t p_distance) {
 	real_t distance = CLAMP(p_distance, 0.f, 100000.f);
 	LOG(INFO, "Setting region label distance: ", distance);
@@ -590,6 +528,33 @@ void TerrainGenerator::update_region_labels() {
 	}
 }
 
+// Takes effect the next time the data directory is loaded
+void TerrainGenerator::set_region_streaming(const bool p_enabled) {
+	LOG(INFO, "Setting region streaming: ", p_enabled);
+	_region_streaming = p_enabled;
+}
+
+// Distance in regions around the clipmap and collision targets to keep loaded
+void TerrainGenerator::set_streaming_distance(const int p_distance) {
+	int distance = CLAMP(p_distance, 1, TerrainGeneratorData::REGION_MAP_SIZE / 2);
+	LOG(INFO, "Setting streaming distance: ", distance);
+	_streaming_distance = distance;
+}
+
+// Maximum number of regions kept in memory while streaming. Also the maximum texture array capacity.
+void TerrainGenerator::set_resident_region_budget(const int p_budget) {
+	int budget = CLAMP(p_budget, 1, TerrainGeneratorData::REGION_MAP_SIZE * TerrainGeneratorData::REGION_MAP_SIZE);
+	LOG(INFO, "Setting resident region budget: ", budget);
+	_resident_region_budget = budget;
+}
+
+// Memory the editor may use for undo data, in MB. The oldest undo steps are discarded beyond it.
+void TerrainGenerator::set_undo_memory_budget(const int p_megabytes) {
+	int budget = CLAMP(p_megabytes, 16, 65536);
+	LOG(INFO, "Setting undo memory budget: ", budget, " MB");
+	_undo_memory_budget = budget;
+}
+
 void TerrainGenerator::set_mesh_lods(const int p_count) {
 	if (_mesh_lods != p_count) {
 		LOG(INFO, "Setting mesh levels: ", p_count);
@@ -616,6 +581,7 @@ void TerrainGenerator::set_vertex_spacing(const real_t p_spacing) {
 	if (_vertex_spacing != spacing) {
 		_vertex_spacing = spacing;
 		LOG(INFO, "Setting vertex spacing: ", _vertex_spacing);
+		_clear_baked_tiles();
 		if (_collision && _data && _instancer && _material.is_valid()) {
 			_data->_vertex_spacing = _vertex_spacing;
 			update_region_labels();
@@ -791,23 +757,32 @@ Dictionary TerrainGenerator::get_raycast_result(const Vector3 &p_src_pos, const
 Ref<Mesh> TerrainGenerator::bake_mesh(const int p_lod, const TerrainGeneratorData::HeightFilter p_filter) const {
 	LOG(INFO, "Baking mesh at lod: ", p_lod, " with filter: ", p_filter);
 	Ref<Mesh> result;
-	ERR_FAIL_COND_V(_data == nullptr, result);
+	ERR_FAIL_COND_V(_data == nullptr || _baker == nullptr, result);
+
+	TerrainGeneratorMeshBaker::BakeSettings settings;
+	settings.lod = p_lod;
+	settings.filter = p_filter;
+	PackedVector3Array vertices;
+	PackedInt32Array indices;
+	_baker->bake(settings, false, vertices, indices);
+	if (indices.is_empty()) {
+		LOG(WARN, "No terrain to bake");
+		return result;
+	}
 
 	Ref<SurfaceTool> st;
 	st.instantiate();
 	st->begin(Mesh::PRIMITIVE_TRIANGLES);
-
-	PackedVector3Array vertices;
-	PackedVector2Array uvs;
-	_generate_triangles(vertices, &uvs, p_lod, p_filter, false, AABB());
-
-	ERR_FAIL_COND_V(vertices.size() != uvs.size(), result);
+	const Vector3 *vertices_ptr = vertices.ptr();
 	for (int i = 0; i < vertices.size(); ++i) {
-		st->set_uv(uvs[i]);
-		st->add_vertex(vertices[i]);
+		st->set_uv(Vector2(vertices_ptr[i].x, vertices_ptr[i].z));
+		st->add_vertex(vertices_ptr[i]);
+	}
+	const int32_t *indices_ptr = indices.ptr();
+	for (int i = 0; i < indices.size(); ++i) {
+		st->add_index(indices_ptr[i]);
 	}
 
-	st->index();
 	st->generate_normals();
 	st->generate_tangents();
 	st->optimize_indices_for_cache();
@@ -823,14 +798,66 @@ Ref<Mesh> TerrainGenerator::bake_mesh(const int p_lod, const TerrainGeneratorDat
  * p_require_nav: If true, this function will only generate geometry for terrain marked navigable.
  *  Otherwise, geometry is generated for the entire terrain within the AABB (which can be useful for
  *  dynamic and/or runtime nav mesh baking).
+ * Tiles are cached, so baking the same area again only regenerates tiles edited since.
  */
 PackedVector3Array TerrainGenerator::generate_nav_mesh_source_geometry(const AABB &p_global_aabb, const bool p_require_nav) const {
 	LOG(INFO, "Generating NavMesh source geometry from terrain");
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::NAVIGATION);
 	PackedVector3Array faces;
-	_generate_triangles(faces, nullptr, 0, TerrainGeneratorData::HEIGHT_FILTER_NEAREST, p_require_nav, p_global_aabb);
+	ERR_FAIL_COND_V(_data == nullptr || _baker == nullptr, faces);
+	TerrainGeneratorMeshBaker::BakeSettings settings;
+	settings.require_nav = p_require_nav;
+	settings.global_aabb = p_global_aabb;
+	PackedVector3Array vertices;
+	PackedInt32Array indices;
+	_baker->bake(settings, true, vertices, indices);
+
+	faces.resize(indices.size());
+	Vector3 *faces_ptr = faces.ptrw();
+	const Vector3 *vertices_ptr = vertices.ptr();
+	const int32_t *indices_ptr = indices.ptr();
+	for (int i = 0; i < indices.size(); ++i) {
+		faces_ptr[i] = vertices_ptr[indices_ptr[i]];
+	}
 	return faces;
 }
 
+/**
+ * Same as generate_nav_mesh_source_geometry(), but appends indexed vertices directly to p_source_geometry,
+ * rather than the 3x larger list of faces.
+ */
+void TerrainGenerator::append_nav_mesh_source_geometry(const Ref<NavigationMeshSourceGeometryData3D> &p_source_geometry,
+		const AABB &p_global_aabb, const bool p_require_nav) const {
+	LOG(INFO, "Appending NavMesh source geometry from terrain");
+	ERR_FAIL_COND(p_source_geometry.is_null());
+	ERR_FAIL_COND(_data == nullptr || _baker == nullptr);
+	TerrainGeneratorMeshBaker::BakeSettings settings;
+	settings.require_nav = p_require_nav;
+	settings.global_aabb = p_global_aabb;
+	PackedVector3Array vertices;
+	PackedInt32Array indices;
+	_baker->bake(settings, true, vertices, indices);
+	if (indices.is_empty()) {
+		return;
+	}
+
+	PackedFloat32Array source_vertices;
+	source_vertices.resize(vertices.size() * 3);
+	float *source_vertices_ptr = source_vertices.ptrw();
+	const Vector3 *vertices_ptr = vertices.ptr();
+	for (int i = 0; i < vertices.size(); ++i) {
+		source_vertices_ptr[i * 3 + 0] = vertices_ptr[i].x;
+		source_vertices_ptr[i * 3 + 1] = vertices_ptr[i].y;
+		source_vertices_ptr[i * 3 + 2] = vertices_ptr[i].z;
+	}
+	// add_faces() reverses the winding for the nav baker, which append_arrays() doesn't
+	int32_t *indices_ptr = indices.ptrw();
+	for (int i = 0; i < indices.size(); i += 3) {
+		SWAP(indices_ptr[i + 1], indices_ptr[i + 2]);
+	}
+	p_source_geometry->append_arrays(source_vertices, indices);
+}
+
 void TerrainGenerator::set_warning(const uint8_t p_warning, const bool p_enabled) {
 	if (p_enabled) {
 		_warnings |= p_warning;
@@ -899,6 +926,7 @@ void TerrainGenerator::_notification(const int p_what) {
 			}
 			_initialize(); // Rebuild anything freed: meshes, collision, instancer
 			set_physics_process(true);
+			TerrainGeneratorProfiler::add_terrain(this);
 			break;
 		}
 
@@ -989,6 +1017,7 @@ void TerrainGenerator::_notification(const int p_what) {
 			// Sent on scene changes
 			LOG(INFO, "NOTIFICATION_EXIT_TREE");
 			set_physics_process(false);
+			TerrainGeneratorProfiler::remove_terrain(this);
 			_destroy_mesher();
 			_destroy_mouse_picking();
 			if (_assets.is_valid()) {
@@ -1013,6 +1042,10 @@ void TerrainGenerator::_notification(const int p_what) {
 			// Object is about to be deleted
 			LOG(INFO, "NOTIFICATION_PREDELETE");
 			_destroy_mesher(true);
+			if (_baker) {
+				delete _baker;
+				_baker = nullptr;
+			}
 			_destroy_instancer();
 			_destroy_collision(true);
 			_assets.unref();
@@ -1053,6 +1086,8 @@ void TerrainGenerator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_material"), &TerrainGenerator::get_material);
 	ClassDB::bind_method(D_METHOD("set_assets", "assets"), &TerrainGenerator::set_assets);
 	ClassDB::bind_method(D_METHOD("get_assets"), &TerrainGenerator::get_assets);
+	ClassDB::bind_method(D_METHOD("set_procedural", "procedural"), &TerrainGenerator::set_procedural);
+	ClassDB::bind_method(D_METHOD("get_procedural"), &TerrainGenerator::get_procedural);
 	ClassDB::bind_method(D_METHOD("get_collision"), &TerrainGenerator::get_collision);
 	ClassDB::bind_method(D_METHOD("get_instancer"), &TerrainGenerator::get_instancer);
 	ClassDB::bind_method(D_METHOD("set_editor", "editor"), &TerrainGenerator::set_editor);
@@ -1075,10 +1110,20 @@ void TerrainGenerator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_region_size"), &TerrainGenerator::get_region_size);
 	ClassDB::bind_method(D_METHOD("set_save_16_bit", "enabled"), &TerrainGenerator::set_save_16_bit);
 	ClassDB::bind_method(D_METHOD("get_save_16_bit"), &TerrainGenerator::get_save_16_bit);
+	ClassDB::bind_method(D_METHOD("set_tiled_region_files", "enabled"), &TerrainGenerator::set_tiled_region_files);
+	ClassDB::bind_method(D_METHOD("get_tiled_region_files"), &TerrainGenerator::get_tiled_region_files);
 	ClassDB::bind_method(D_METHOD("set_label_distance", "distance"), &TerrainGenerator::set_label_distance);
 	ClassDB::bind_method(D_METHOD("get_label_distance"), &TerrainGenerator::get_label_distance);
 	ClassDB::bind_method(D_METHOD("set_label_size", "size"), &TerrainGenerator::set_label_size);
 	ClassDB::bind_method(D_METHOD("get_label_size"), &TerrainGenerator::get_label_size);
+	ClassDB::bind_method(D_METHOD("set_region_streaming", "enabled"), &TerrainGenerator::set_region_streaming);
+	ClassDB::bind_method(D_METHOD("get_region_streaming"), &TerrainGenerator::get_region_streaming);
+	ClassDB::bind_method(D_METHOD("set_streaming_distance", "distance"), &TerrainGenerator::set_streaming_distance);
+	ClassDB::bind_method(D_METHOD("get_streaming_distance"), &TerrainGenerator::get_streaming_distance);
+	ClassDB::bind_method(D_METHOD("set_resident_region_budget", "budget"), &TerrainGenerator::set_resident_region_budget);
+	ClassDB::bind_method(D_METHOD("get_resident_region_budget"), &TerrainGenerator::get_resident_region_budget);
+	ClassDB::bind_method(D_METHOD("set_undo_memory_budget", "megabytes"), &TerrainGenerator::set_undo_memory_budget);
+	ClassDB::bind_method(D_METHOD("get_undo_memory_budget"), &TerrainGenerator::get_undo_memory_budget);
 
 	// Collision
 	ClassDB::bind_method(D_METHOD("set_collision_mode", "mode"), &TerrainGenerator::set_collision_mode);
@@ -1166,6 +1211,7 @@ void TerrainGenerator::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_intersection", "src_pos", "direction", "gpu_mode"), &TerrainGenerator::get_intersection, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("bake_mesh", "lod", "filter"), &TerrainGenerator::bake_mesh, DEFVAL(TerrainGeneratorData::HEIGHT_FILTER_NEAREST));
 	ClassDB::bind_method(D_METHOD("generate_nav_mesh_source_geometry", "global_aabb", "require_nav"), &TerrainGenerator::generate_nav_mesh_source_geometry, DEFVAL(true));
+	ClassDB::bind_method(D_METHOD("append_nav_mesh_source_geometry", "source_geometry", "global_aabb", "require_nav"), &TerrainGenerator::append_nav_mesh_source_geometry, DEFVAL(true));
 
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "version", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_EDITOR | PROPERTY_USAGE_READ_ONLY), "", "get_version");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "debug_level", PROPERTY_HINT_ENUM, "Errors,Info,Debug,Extreme"), "set_debug_level", "get_debug_level");
@@ -1175,15 +1221,21 @@ void TerrainGenerator::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "data", PROPERTY_HINT_NONE, "TerrainGeneratorData", PROPERTY_USAGE_NONE), "", "get_data");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "material", PROPERTY_HINT_RESOURCE_TYPE, "TerrainGeneratorMaterial"), "set_material", "get_material");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "assets", PROPERTY_HINT_RESOURCE_TYPE, "TerrainGeneratorAssets"), "set_assets", "get_assets");
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "procedural", PROPERTY_HINT_RESOURCE_TYPE, "TerrainGeneratorProcedural"), "set_procedural", "get_procedural");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "collision", PROPERTY_HINT_NONE, "TerrainGeneratorCollision", PROPERTY_USAGE_NONE), "", "get_collision");
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "instancer", PROPERTY_HINT_NONE, "TerrainGeneratorInstancer", PROPERTY_USAGE_NONE), "", "get_instancer");
 
 	ADD_GROUP("Regions", "");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "region_size", PROPERTY_HINT_ENUM, "64:64,128:128,256:256,512:512,1024:1024,2048:2048", PROPERTY_USAGE_EDITOR), "change_region_size", "get_region_size");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "save_16_bit"), "set_save_16_bit", "get_save_16_bit");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "tiled_region_files"), "set_tiled_region_files", "get_tiled_region_files");
 	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "label_distance", PROPERTY_HINT_RANGE, "0.0,10000.0,0.5,or_greater"), "set_label_distance", "get_label_distance");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "label_size", PROPERTY_HINT_RANGE, "24,128,1"), "set_label_size", "get_label_size");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "show_grid"), "set_show_region_grid", "get_show_region_grid");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "region_streaming"), "set_region_streaming", "get_region_streaming");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "streaming_distance", PROPERTY_HINT_RANGE, "1,16,1"), "set_streaming_distance", "get_streaming_distance");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "resident_region_budget", PROPERTY_HINT_RANGE, "1,1024,1"), "set_resident_region_budget", "get_resident_region_budget");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "undo_memory_budget", PROPERTY_HINT_RANGE, "16,65536,1,suffix:MB"), "set_undo_memory_budget", "get_undo_memory_budget");
 
 	ADD_GROUP("Collision", "");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "collision_mode", PROPERTY_HINT_ENUM, "Disabled,Dynamic / Game,Dynamic / Editor,Full / Game,Full / Editor"), "set_collision_mode", "get_collision_mode");
@@ -1235,4 +1287,5 @@ void TerrainGenerator::_bind_methods() {
 
 	ADD_SIGNAL(MethodInfo("material_changed"));
 	ADD_SIGNAL(MethodInfo("assets_changed"));
+	ADD_SIGNAL(MethodInfo("procedural_changed"));
 }
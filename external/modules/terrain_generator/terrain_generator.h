@@ -10,6 +10,7 @@
 #include <godot/servers/rendering_server.h>
 #include <godot/scene/3d/physics/static_body_3d.h>
 #include <godot/scene/main/viewport.h>
+#include <godot/scene/resources/3d/navigation_mesh_source_geometry_data_3d.h>
 
 #include "constants.h"
 #include "target_node_3d.h"
@@ -19,7 +20,9 @@
 #include "terrain_generator_editor.h"
 #include "terrain_generator_instancer.h"
 #include "terrain_generator_material.h"
+#include "terrain_generator_mesh_baker.h"
 #include "terrain_generator_mesher.h"
+#include "terrain_generator_procedural.h"
 
 class TerrainGenerator : public Node3D {
 	GDCLASS(TerrainGenerator, Node3D);
@@ -55,9 +58,11 @@ private:
 	TerrainGeneratorData *_data = nullptr;
 	Ref<TerrainGeneratorMaterial> _material;
 	Ref<TerrainGeneratorAssets> _assets;
+	Ref<TerrainGeneratorProcedural> _procedural;
 	TerrainGeneratorInstancer *_instancer = nullptr;
 	TerrainGeneratorCollision *_collision = nullptr;
 	TerrainGeneratorMesher *_mesher = nullptr;
+	TerrainGeneratorMeshBaker *_baker = nullptr;
 	TerrainGeneratorEditor *_editor = nullptr;
 	EditorPlugin *_plugin = nullptr;
 
@@ -69,8 +74,13 @@ private:
 	// Regions
 	RegionSize _region_size = SIZE_1024;
 	bool _save_16_bit = false;
+	bool _tiled_region_files = false;
 	real_t _label_distance = 0.f;
 	int _label_size = 48;
+	bool _region_streaming = false;
+	int _streaming_distance = 2;
+	int _resident_region_budget = 64;
+	int _undo_memory_budget = 256; // MB
 
 	// Meshes
 	int _mesh_lods = 7;
@@ -106,15 +116,13 @@ private:
 	void _destroy_collision(const bool p_final = false);
 	void _destroy_mesher(const bool p_final = false);
 	void _update_mesher_aabbs() { _mesher ? _mesher->update_aabbs() : void(); }
+	void _invalidate_baked_tiles(const AABB &p_area) { _baker ? _baker->invalidate(p_area) : void(); }
+	void _clear_baked_tiles() { _baker ? _baker->clear_cache() : void(); }
+	void _update_streamed_regions(const TypedArray<Vector2i> &p_loaded, const TypedArray<Vector2i> &p_evicted);
 
 	void _setup_mouse_picking();
 	void _destroy_mouse_picking();
 
-	void _generate_triangles(PackedVector3Array &p_vertices, PackedVector2Array *p_uvs, const int32_t p_lod,
-			const TerrainGeneratorData::HeightFilter p_filter, const bool require_nav, const AABB &p_global_aabb) const;
-	void _generate_triangle_pair(PackedVector3Array &p_vertices, PackedVector2Array *p_uvs, const int32_t p_lod,
-			const TerrainGeneratorData::HeightFilter p_filter, const bool require_nav, const int32_t x, const int32_t z) const;
-
 public:
 	static DebugLevel debug_level; // Initialized in terrain_generator.cpp
 
@@ -135,8 +143,12 @@ public:
 	Ref<TerrainGeneratorMaterial> get_material() const { return _material; }
 	void set_assets(const Ref<TerrainGeneratorAssets> &p_assets);
 	Ref<TerrainGeneratorAssets> get_assets() const { return _assets; }
+	void set_procedural(const Ref<TerrainGeneratorProcedural> &p_procedural);
+	Ref<TerrainGeneratorProcedural> get_procedural() const { return _procedural; }
 	TerrainGeneratorCollision *get_collision() const { return _collision; }
 	TerrainGeneratorInstancer *get_instancer() const { return _instancer; }
+	TerrainGeneratorMesher *get_mesher() const { return _mesher; }
+	TerrainGeneratorMeshBaker *get_mesh_baker() const { return _baker; }
 	Node *get_mmi_parent() const { return _mmi_parent; }
 	void set_editor(TerrainGeneratorEditor *p_editor);
 	TerrainGeneratorEditor *get_editor() const { return _editor; }
@@ -159,11 +171,21 @@ public:
 	void change_region_size(const RegionSize p_size) { _data ? _data->change_region_size(p_size) : void(); }
 	void set_save_16_bit(const bool p_enabled);
 	bool get_save_16_bit() const { return _save_16_bit; }
+	void set_tiled_region_files(const bool p_enabled);
+	bool get_tiled_region_files() const { return _tiled_region_files; }
 	void set_label_distance(const real_t p_distance);
 	real_t get_label_distance() const { return _label_distance; }
 	void set_label_size(const int p_size);
 	int get_label_size() const { return _label_size; }
 	void update_region_labels();
+	void set_region_streaming(const bool p_enabled);
+	bool get_region_streaming() const { return _region_streaming; }
+	void set_streaming_distance(const int p_distance);
+	int get_streaming_distance() const { return _streaming_distance; }
+	void set_resident_region_budget(const int p_budget);
+	int get_resident_region_budget() const { return _resident_region_budget; }
+	void set_undo_memory_budget(const int p_megabytes);
+	int get_undo_memory_budget() const { return _undo_memory_budget; }
 
 	// Meshes
 	void set_mesh_lods(const int p_count);
@@ -194,6 +216,8 @@ public:
 	Dictionary get_raycast_result(const Vector3 &p_src_pos, const Vector3 &p_destination, const bool p_exclude_self = true) const;
 	Ref<Mesh> bake_mesh(const int p_lod, const TerrainGeneratorData::HeightFilter p_filter = TerrainGeneratorData::HEIGHT_FILTER_NEAREST) const;
 	PackedVector3Array generate_nav_mesh_source_geometry(const AABB &p_global_aabb, const bool p_require_nav = true) const;
+	void append_nav_mesh_source_geometry(const Ref<NavigationMeshSourceGeometryData3D> &p_source_geometry,
+			const AABB &p_global_aabb, const bool p_require_nav = true) const;
 
 	// Warnings
 	void set_warning(const uint8_t p_warning, const bool p_enabled);
@@ -0,0 +1,398 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include <godot/core/config/engine.h>
+#include <godot/core/io/dir_access.h>
+#include <godot/core/io/file_access.h>
+#include <godot/core/io/json.h>
+#include <godot/core/math/random_pcg.h>
+#include <godot/core/object/worker_thread_pool.h>
+#include <godot/core/os/os.h>
+#include <godot/core/os/time.h>
+#include <godot/servers/rendering/rendering_device.h>
+#include <functional>
+
+#include "logger.h"
+#include "terrain_generator_benchmark.h"
+#include "terrain_generator_data.h"
+#include "terrain_generator_profiler.h"
+#include "terrain_generator_region_file.h"
+
+///////////////////////////
+// Private Functions
+///////////////////////////
+
+void TerrainGeneratorBenchmark::Timing::add(const uint64_t p_usec) {
+	iterations++;
+	total += p_usec;
+	min = MIN(min, p_usec);
+	max = MAX(max, p_usec);
+}
+
+Dictionary TerrainGeneratorBenchmark::Timing::to_dictionary() const {
+	Dictionary dict;
+	dict["iterations"] = iterations;
+	dict["min_ms"] = iterations > 0 ? double(min) / 1000.0 : 0.0;
+	dict["avg_ms"] = iterations > 0 ? double(total) / 1000.0 / iterations : 0.0;
+	dict["max_ms"] = double(max) / 1000.0;
+	return dict;
+}
+
+// Rolling noise with ridges, and a second texture on steep slopes so control maps aren't uniform.
+// Erosion is left out to keep generation short. Set procedural to benchmark other worlds.
+Ref<TerrainGeneratorProcedural> TerrainGeneratorBenchmark::_get_default_procedural() const {
+	Ref<TerrainGeneratorProceduralStage> hills;
+	hills.instantiate();
+	Ref<TerrainGeneratorProceduralStage> ridges;
+	ridges.instantiate();
+	ridges->set_type(TerrainGeneratorProceduralStage::STAGE_RIDGED_NOISE);
+	ridges->set_seed_offset(1);
+	ridges->set_amplitude(80.f);
+	Ref<TerrainGeneratorProceduralStage> rock;
+	rock.instantiate();
+	rock->set_type(TerrainGeneratorProceduralStage::STAGE_TEXTURE);
+	rock->set_texture_id(1);
+	rock->set_slope_range(Vector2(30.f, 90.f));
+
+	TypedArray<TerrainGeneratorProceduralStage> stages;
+	stages.push_back(hills);
+	stages.push_back(ridges);
+	stages.push_back(rock);
+	Ref<TerrainGeneratorProcedural> procedural;
+	procedural.instantiate();
+	procedural->set_seed(1);
+	procedural->set_stages(stages);
+	return procedural;
+}
+
+// Removes region files left in the directory. Other files are left alone.
+void TerrainGeneratorBenchmark::_clear_directory() const {
+	PackedStringArray files = DirAccess::get_files_at(_directory);
+	for (const String &file : files) {
+		String ext = file.get_extension();
+		if (file.begins_with("TerrainGenerator") && (ext == "res" || ext == TerrainGeneratorRegionFile::EXTENSION)) {
+			DirAccess::remove_absolute(_directory + String("/") + file);
+		}
+	}
+}
+
+AABB TerrainGeneratorBenchmark::_get_world_aabb(const TerrainGenerator *p_terrain) const {
+	real_t region_width = _region_size * _vertex_spacing;
+	real_t world_width = _world_size * region_width;
+	real_t start = -(_world_size / 2) * region_width;
+	Vector2 height_range = p_terrain->get_data()->get_height_range();
+	return AABB(Vector3(start, height_range.x, start), Vector3(world_width, height_range.y - height_range.x, world_width));
+}
+
+///////////////////////////
+// Public Functions
+///////////////////////////
+
+void TerrainGeneratorBenchmark::set_region_size(const int p_size) {
+	int size = 64;
+	while (size < p_size && size < 2048) {
+		size *= 2;
+	}
+	_region_size = size;
+}
+
+void TerrainGeneratorBenchmark::set_world_size(const int p_regions) {
+	_world_size = CLAMP(p_regions, 1, TerrainGeneratorData::REGION_MAP_SIZE);
+}
+
+void TerrainGeneratorBenchmark::set_vertex_spacing(const real_t p_spacing) {
+	_vertex_spacing = CLAMP(p_spacing, 0.25f, 100.f);
+}
+
+void TerrainGeneratorBenchmark::set_iterations(const int p_iterations) {
+	_iterations = CLAMP(p_iterations, 1, 1000);
+}
+
+void TerrainGeneratorBenchmark::set_query_count(const int p_count) {
+	_query_count = CLAMP(p_count, 1, 100000000);
+}
+
+void TerrainGeneratorBenchmark::set_instance_count(const int p_count) {
+	_instance_count = CLAMP(p_count, 0, 10000000);
+}
+
+// Builds the synthetic world under p_parent, which must be in the tree, and times each case.
+// The terrain and its region files are removed afterwards.
+Dictionary TerrainGeneratorBenchmark::run(Node *p_parent) {
+	Dictionary results;
+	if (!p_parent || !p_parent->is_inside_tree()) {
+		LOG(ERROR, "Benchmark requires a parent node inside the scene tree");
+		return results;
+	}
+	Error err = DirAccess::make_dir_recursive_absolute(_directory);
+	if (err != OK && err != ERR_ALREADY_EXISTS) {
+		LOG(ERROR, "Cannot create directory ", _directory, ", error: ", err);
+		return results;
+	}
+	_clear_directory();
+	LOG(MESG, "Benchmarking ", _world_size, "x", _world_size, " regions of ", _region_size, ", ", _iterations, " iterations");
+
+	TerrainGenerator *terrain = memnew(TerrainGenerator);
+	terrain->set_name("TerrainGeneratorBenchmark");
+	terrain->set_region_size(TerrainGenerator::RegionSize(_region_size));
+	terrain->set_vertex_spacing(_vertex_spacing);
+	terrain->set_tiled_region_files(_tiled_region_files);
+	terrain->set_procedural(_procedural.is_valid() ? _procedural : _get_default_procedural());
+	Node3D *target = memnew(Node3D);
+	target->set_name("TerrainGeneratorBenchmarkTarget");
+	p_parent->add_child(target);
+	p_parent->add_child(terrain);
+	terrain->set_clipmap_target(target);
+	terrain->set_collision_target(target);
+	terrain->set_collision_mode(TerrainGeneratorCollision::DYNAMIC_GAME);
+	TerrainGeneratorData *data = terrain->get_data();
+
+	TypedArray<Vector2i> locations;
+	int half = _world_size / 2;
+	for (int y = 0; y < _world_size; y++) {
+		for (int x = 0; x < _world_size; x++) {
+			locations.push_back(Vector2i(x - half, y - half));
+		}
+	}
+
+	Dictionary cases;
+	auto measure = [](const int p_iterations, const std::function<void(const int)> &p_func) {
+		Timing timing;
+		for (int i = 0; i < p_iterations; i++) {
+			uint64_t start = Time::get_singleton()->get_ticks_usec();
+			p_func(i);
+			timing.add(Time::get_singleton()->get_ticks_usec() - start);
+		}
+		return timing;
+	};
+	uint64_t uploaded = 0;
+	auto upload_start = [&]() { uploaded = TerrainGeneratorProfiler::get_upload_bytes_total(); };
+	auto upload_bytes = [&](const int p_iterations) { return (TerrainGeneratorProfiler::get_upload_bytes_total() - uploaded) / p_iterations; };
+	Dictionary result;
+
+	// Regions
+	upload_start();
+	result = measure(1, [&](const int) { data->generate_regions(locations, true); }).to_dictionary();
+	result["regions"] = locations.size();
+	result["gpu_upload_bytes"] = upload_bytes(1);
+	cases["generate_regions"] = result;
+
+	// Saving clears the dirty tiles, so mark them every iteration to time full saves
+	result = measure(_iterations, [&](const int) {
+		for (int i = 0; i < locations.size(); i++) {
+			TerrainGeneratorRegion *region = data->get_region_ptr(Vector2i(locations[i]));
+			region->set_all_dirty();
+			region->set_modified(true);
+		}
+		data->save_directory(_directory);
+	}).to_dictionary();
+	int64_t file_bytes = 0;
+	for (const String &file : DirAccess::get_files_at(_directory)) {
+		Ref<FileAccess> fa = FileAccess::open(_directory + String("/") + file, FileAccess::READ);
+		file_bytes += fa.is_valid() ? fa->get_length() : 0;
+	}
+	result["file_bytes"] = file_bytes;
+	cases["save_regions"] = result;
+
+	// One edited tile per region, rewritten in place in tiled region files
+	if (_tiled_region_files) {
+		result = measure(_iterations, [&](const int) {
+			for (int i = 0; i < locations.size(); i++) {
+				TerrainGeneratorRegion *region = data->get_region_ptr(Vector2i(locations[i]));
+				region->add_dirty_area(Rect2i(0, 0, TerrainGeneratorRegion::TILE_SIZE, TerrainGeneratorRegion::TILE_SIZE));
+				region->set_modified(true);
+			}
+			data->save_directory(_directory);
+		}).to_dictionary();
+		result["dirty_tiles"] = locations.size();
+		cases["save_regions_partial"] = result;
+	}
+
+	upload_start();
+	result = measure(_iterations, [&](const int) { data->load_directory(_directory); }).to_dictionary();
+	result["gpu_upload_bytes"] = upload_bytes(_iterations);
+	result["resident_bytes"] = data->get_resident_bytes();
+	cases["load_regions"] = result;
+
+	// Texture arrays
+	upload_start();
+	result = measure(_iterations, [&](const int) { data->update_maps(TYPE_MAX, true, false); }).to_dictionary();
+	result["gpu_upload_bytes"] = upload_bytes(_iterations);
+	cases["update_maps_all"] = result;
+
+	TerrainGeneratorRegion *region = data->get_region_ptr(Vector2i(locations[0]));
+	upload_start();
+	result = measure(_iterations, [&](const int) {
+		region->set_edited(true);
+		region->add_update_area(TYPE_HEIGHT, Rect2i(0, 0, TerrainGeneratorRegion::TILE_SIZE, TerrainGeneratorRegion::TILE_SIZE));
+		data->update_maps(TYPE_HEIGHT, false, false);
+		region->set_edited(false);
+	}).to_dictionary();
+	result["gpu_upload_bytes"] = upload_bytes(_iterations);
+	cases["update_maps_tile"] = result;
+
+	// Moving targets, around a circle within the world
+	AABB world_aabb = _get_world_aabb(terrain);
+	Vector3 center = world_aabb.get_center();
+	real_t radius = world_aabb.size.x * 0.25f;
+	auto move_target = [&](const int p_step) {
+		real_t angle = Math::PI * 2.f * real_t(p_step) / real_t(_iterations);
+		target->set_global_position(center + Vector3(Math::cos(angle), 0.f, Math::sin(angle)) * radius);
+	};
+	TerrainGeneratorMesher *mesher = terrain->get_mesher();
+	result = measure(_iterations, [&](const int p_step) {
+		move_target(p_step);
+		mesher->reset_target_position();
+		mesher->snap();
+	}).to_dictionary();
+	cases["mesher_snap"] = result;
+
+	result = measure(_iterations, [&](const int p_step) {
+		move_target(p_step);
+		terrain->get_collision()->update(true);
+	}).to_dictionary();
+	cases["collision_update"] = result;
+
+	// Random positions on the terrain
+	RandomPCG rng(1);
+	PackedVector3Array positions;
+	positions.resize(_query_count);
+	Vector3 *positions_w = positions.ptrw();
+	for (int i = 0; i < _query_count; i++) {
+		positions_w[i] = world_aabb.position + Vector3(rng.randf(), 0.f, rng.randf()) * world_aabb.size;
+	}
+	result = measure(_iterations, [&](const int) { data->get_heights(positions); }).to_dictionary();
+	result["queries"] = _query_count;
+	result["queries_per_second"] = double(_query_count) * 1000.0 / MAX(double(result["avg_ms"]), 0.001);
+	cases["get_heights"] = result;
+
+	result = measure(_iterations, [&](const int) { data->get_normals(positions); }).to_dictionary();
+	result["queries"] = _query_count;
+	result["queries_per_second"] = double(_query_count) * 1000.0 / MAX(double(result["avg_ms"]), 0.001);
+	cases["get_normals"] = result;
+
+	// Instancer
+	if (_instance_count > 0) {
+		positions.resize(MIN(_instance_count, _query_count));
+		PackedRealArray heights = data->get_heights(positions);
+		TypedArray<Transform3D> xforms;
+		for (int i = 0; i < _instance_count; i++) {
+			int index = i % positions.size();
+			Vector3 position = positions[index];
+			position.y = std::isnan(heights[index]) ? 0.f : heights[index];
+			xforms.push_back(Transform3D(Basis().rotated(Vector3(0.f, 1.f, 0.f), rng.randf() * Math::PI * 2.f), position));
+		}
+		terrain->get_instancer()->add_transforms(0, xforms, PackedColorArray(), false);
+
+		result = measure(_iterations, [&](const int) { terrain->get_instancer()->update_mmis(true); }).to_dictionary();
+		result["instances"] = _instance_count;
+		cases["instancer_update_mmis"] = result;
+
+		result = measure(_iterations, [&](const int) { terrain->get_instancer()->update_transforms(world_aabb); }).to_dictionary();
+		result["instances"] = _instance_count;
+		cases["instancer_update_transforms"] = result;
+	}
+
+	// Navigation, over one region at the center
+	real_t region_width = _region_size * _vertex_spacing;
+	AABB nav_aabb = AABB(center - Vector3(region_width, 0.f, region_width) * 0.5f, Vector3(region_width, 0.f, region_width));
+	nav_aabb.position.y = world_aabb.position.y - 1.f;
+	nav_aabb.size.y = world_aabb.size.y + 2.f;
+	// Cold clears the baked tile cache every iteration. Cached reuses the tiles of the last cold bake
+	int faces = 0;
+	TerrainGeneratorMeshBaker *baker = terrain->get_mesh_baker();
+	Timing nav_timing;
+	for (int i = 0; i < _iterations; i++) {
+		baker->clear_cache();
+		uint64_t start = Time::get_singleton()->get_ticks_usec();
+		faces = terrain->generate_nav_mesh_source_geometry(nav_aabb, false).size() / 3;
+		nav_timing.add(Time::get_singleton()->get_ticks_usec() - start);
+	}
+	result = nav_timing.to_dictionary();
+	result["faces"] = faces;
+	cases["nav_mesh_source_geometry_cold"] = result;
+
+	result = measure(_iterations, [&](const int) { faces = terrain->generate_nav_mesh_source_geometry(nav_aabb, false).size() / 3; }).to_dictionary();
+	result["faces"] = faces;
+	result["cache_bytes"] = baker->get_cache_bytes();
+	cases["nav_mesh_source_geometry_cached"] = result;
+
+	Dictionary settings;
+	settings["region_size"] = _region_size;
+	settings["world_size"] = _world_size;
+	settings["vertex_spacing"] = _vertex_spacing;
+	settings["iterations"] = _iterations;
+	settings["query_count"] = _query_count;
+	settings["instance_count"] = _instance_count;
+	settings["tiled_region_files"] = _tiled_region_files;
+	settings["custom_procedural"] = _procedural.is_valid();
+
+	Dictionary system;
+	system["engine_version"] = Engine::get_singleton()->get_version_info()["string"];
+	system["processor_name"] = OS::get_singleton()->get_processor_name();
+	system["processor_count"] = OS::get_singleton()->get_processor_count();
+	system["worker_threads"] = WorkerThreadPool::get_singleton()->get_thread_count();
+	system["rendering_device"] = RD::get_singleton() != nullptr;
+	system["debug_build"] = OS::get_singleton()->is_debug_build();
+
+	results["format_version"] = FORMAT_VERSION;
+	results["timestamp"] = Time::get_singleton()->get_datetime_string_from_system(true);
+	results["settings"] = settings;
+	results["system"] = system;
+	results["cases"] = cases;
+
+	p_parent->remove_child(terrain);
+	memdelete(terrain);
+	p_parent->remove_child(target);
+	memdelete(target);
+	_clear_directory();
+
+	if (!_output_path.is_empty()) {
+		Ref<FileAccess> file = FileAccess::open(_output_path, FileAccess::WRITE);
+		if (file.is_null()) {
+			LOG(ERROR, "Cannot write benchmark results to ", _output_path, ", error: ", FileAccess::get_open_error());
+		} else {
+			file->store_string(JSON::stringify(results, "\t", false));
+			LOG(MESG, "Wrote benchmark results to ", _output_path);
+		}
+	}
+	return results;
+}
+
+///////////////////////////
+// Protected Functions
+///////////////////////////
+
+void TerrainGeneratorBenchmark::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_region_size", "size"), &TerrainGeneratorBenchmark::set_region_size);
+	ClassDB::bind_method(D_METHOD("get_region_size"), &TerrainGeneratorBenchmark::get_region_size);
+	ClassDB::bind_method(D_METHOD("set_world_size", "regions"), &TerrainGeneratorBenchmark::set_world_size);
+	ClassDB::bind_method(D_METHOD("get_world_size"), &TerrainGeneratorBenchmark::get_world_size);
+	ClassDB::bind_method(D_METHOD("set_vertex_spacing", "spacing"), &TerrainGeneratorBenchmark::set_vertex_spacing);
+	ClassDB::bind_method(D_METHOD("get_vertex_spacing"), &TerrainGeneratorBenchmark::get_vertex_spacing);
+	ClassDB::bind_method(D_METHOD("set_iterations", "iterations"), &TerrainGeneratorBenchmark::set_iterations);
+	ClassDB::bind_method(D_METHOD("get_iterations"), &TerrainGeneratorBenchmark::get_iterations);
+	ClassDB::bind_method(D_METHOD("set_query_count", "count"), &TerrainGeneratorBenchmark::set_query_count);
+	ClassDB::bind_method(D_METHOD("get_query_count"), &TerrainGeneratorBenchmark::get_query_count);
+	ClassDB::bind_method(D_METHOD("set_instance_count", "count"), &TerrainGeneratorBenchmark::set_instance_count);
+	ClassDB::bind_method(D_METHOD("get_instance_count"), &TerrainGeneratorBenchmark::get_instance_count);
+	ClassDB::bind_method(D_METHOD("set_tiled_region_files", "enabled"), &TerrainGeneratorBenchmark::set_tiled_region_files);
+	ClassDB::bind_method(D_METHOD("get_tiled_region_files"), &TerrainGeneratorBenchmark::get_tiled_region_files);
+	ClassDB::bind_method(D_METHOD("set_directory", "directory"), &TerrainGeneratorBenchmark::set_directory);
+	ClassDB::bind_method(D_METHOD("get_directory"), &TerrainGeneratorBenchmark::get_directory);
+	ClassDB::bind_method(D_METHOD("set_output_path", "path"), &TerrainGeneratorBenchmark::set_output_path);
+	ClassDB::bind_method(D_METHOD("get_output_path"), &TerrainGeneratorBenchmark::get_output_path);
+	ClassDB::bind_method(D_METHOD("set_procedural", "procedural"), &TerrainGeneratorBenchmark::set_procedural);
+	ClassDB::bind_method(D_METHOD("get_procedural"), &TerrainGeneratorBenchmark::get_procedural);
+	ClassDB::bind_method(D_METHOD("run", "parent"), &TerrainGeneratorBenchmark::run);
+
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "region_size", PROPERTY_HINT_ENUM, "64:64,128:128,256:256,512:512,1024:1024,2048:2048"), "set_region_size", "get_region_size");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "world_size", PROPERTY_HINT_RANGE, "1,32,1"), "set_world_size", "get_world_size");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "vertex_spacing", PROPERTY_HINT_RANGE, "0.25,10.0,0.05,or_greater"), "set_vertex_spacing", "get_vertex_spacing");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "iterations", PROPERTY_HINT_RANGE, "1,1000,1"), "set_iterations", "get_iterations");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "query_count", PROPERTY_HINT_RANGE, "1,100000000,1"), "set_query_count", "get_query_count");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "instance_count", PROPERTY_HINT_RANGE, "0,10000000,1"), "set_instance_count", "get_instance_count");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "tiled_region_files"), "set_tiled_region_files", "get_tiled_region_files");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "directory", PROPERTY_HINT_GLOBAL_DIR), "set_directory", "get_directory");
+	ADD_PROPERTY(PropertyInfo(Variant::STRING, "output_path", PROPERTY_HINT_GLOBAL_SAVE_FILE, "*.json"), "set_output_path", "get_output_path");
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "procedural", PROPERTY_HINT_RESOURCE_TYPE, "TerrainGeneratorProcedural"), "set_procedural", "get_procedural");
+}
@@ -0,0 +1,88 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/object/ref_counted.h>
+
+#include "constants.h"
+#include "terrain_generator_procedural.h"
+
+class TerrainGenerator;
+
+// Times the main terrain subsystems on a synthetic world, so results are reproducible between runs
+// and machines. run() builds a temporary TerrainGenerator under the given node, generates a square of
+// regions with the procedural generator, then times each case and returns the results as a Dictionary,
+// also written as JSON to output_path if set. It works headless, eg. with
+// `godot --headless --script benchmark.gd` and a script like:
+//   extends SceneTree
+//   func _initialize():
+//       var benchmark := TerrainGeneratorBenchmark.new()
+//       benchmark.output_path = "user://benchmark.json"
+//       benchmark.run(root)
+//       quit()
+// Without a RenderingDevice, texture arrays are uploaded whole, so update_maps cases differ from a
+// Forward+ or Mobile run.
+class TerrainGeneratorBenchmark : public RefCounted {
+	GDCLASS(TerrainGeneratorBenchmark, RefCounted);
+	CLASS_NAME();
+
+public: // Constants
+	static inline const char *FORMAT_VERSION = "1";
+
+private:
+	// Times of one case, in usec
+	struct Timing {
+		int iterations = 0;
+		uint64_t total = 0;
+		uint64_t min = UINT64_MAX;
+		uint64_t max = 0;
+
+		void add(const uint64_t p_usec);
+		Dictionary to_dictionary() const;
+	};
+
+	int _region_size = 256;
+	int _world_size = 4; // Regions per side
+	real_t _vertex_spacing = 1.f;
+	int _iterations = 5;
+	int _query_count = 1000000;
+	int _instance_count = 100000;
+	bool _tiled_region_files = true;
+	String _directory = "user://terrain_generator_benchmark";
+	String _output_path;
+	Ref<TerrainGeneratorProcedural> _procedural;
+
+	Ref<TerrainGeneratorProcedural> _get_default_procedural() const;
+	void _clear_directory() const;
+	AABB _get_world_aabb(const TerrainGenerator *p_terrain) const;
+
+public:
+	TerrainGeneratorBenchmark() {}
+	~TerrainGeneratorBenchmark() {}
+
+	void set_region_size(const int p_size);
+	int get_region_size() const { return _region_size; }
+	void set_world_size(const int p_regions);
+	int get_world_size() const { return _world_size; }
+	void set_vertex_spacing(const real_t p_spacing);
+	real_t get_vertex_spacing() const { return _vertex_spacing; }
+	void set_iterations(const int p_iterations);
+	int get_iterations() const { return _iterations; }
+	void set_query_count(const int p_count);
+	int get_query_count() const { return _query_count; }
+	void set_instance_count(const int p_count);
+	int get_instance_count() const { return _instance_count; }
+	void set_tiled_region_files(const bool p_enabled) { _tiled_region_files = p_enabled; }
+	bool get_tiled_region_files() const { return _tiled_region_files; }
+	void set_directory(const String &p_dir) { _directory = p_dir; }
+	String get_directory() const { return _directory; }
+	void set_output_path(const String &p_path) { _output_path = p_path; }
+	String get_output_path() const { return _output_path; }
+	void set_procedural(const Ref<TerrainGeneratorProcedural> &p_procedural) { _procedural = p_procedural; }
+	Ref<TerrainGeneratorProcedural> get_procedural() const { return _procedural; }
+
+	Dictionary run(Node *p_parent);
+
+protected:
+	static void _bind_methods();
+};
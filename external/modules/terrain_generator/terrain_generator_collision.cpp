@@ -6,119 +6,369 @@
 #include <godot/scene/resources/3d/world_3d.h>
 
 #include <godot/scene/main/scene_tree.h>
+#include <algorithm>
 
 #include "constants.h"
 #include "logger.h"
 #include "terrain_generator.h"
 #include "terrain_generator_collision.h"
 #include "terrain_generator_data.h"
+#include "terrain_generator_profiler.h"
 #include "terrain_generator_util.h"
 
 ///////////////////////////
 // Private Functions
 ///////////////////////////
 
-// Calculates shape data from top left position. Assumes descaled and snapped.
-Dictionary TerrainGeneratorCollision::_get_shape_data(const Vector2i &p_position, const int p_size) {
-	IS_DATA_INIT_MESG("Terrain not initialized", Dictionary());
-	TerrainGeneratorData *data = _terrain->get_data();
-	int region_size = _terrain->get_region_size();
+int TerrainGeneratorCollision::_get_grid_width() const {
+	int grid_width = _radius * 2 / _shape_size; // 64*2/16 = 8
+	return int_ceil_pow2(grid_width, 4);
+}
 
-	int hshape_size = p_size + 1; // Calculate last vertex at end
-	PackedRealArray map_data = PackedRealArray();
-	map_data.resize(hshape_size * hshape_size);
-	real_t min_height = FLT_MAX;
-	real_t max_height = FLT_MIN;
+// Optionally could adjust radius to account for corner (sqrt(_shape_size*2))
+bool TerrainGeneratorCollision::_is_in_radius(const Vector2i &p_shape_pos, const Vector2i &p_snapped_pos) const {
+	return (p_shape_pos + V2I(_shape_size / 2)).distance_squared_to(p_snapped_pos) <= int64_t(_radius) * _radius;
+}
 
-	Ref<Image> map, map_x, map_z, map_xz; // height maps
-	Ref<Image> cmap, cmap_x, cmap_z, cmap_xz; // control maps w/ holes
+// Copies one row of heights into a column of the rotated shape array, replacing holes with NAN.
+// A p_step of 0 repeats the first pixel, used where an adjacent region doesn't exist.
+static inline void _copy_row(const float *p_heights, const uint32_t *p_controls, const int p_step, const int p_count,
+		real_t *r_dest, const int p_dest_stride, real_t &r_min, real_t &r_max) {
+	for (int i = 0; i < p_count; i++) {
+		int index = i * p_step;
+		real_t height = p_heights[index];
+		if (is_hole(p_controls[index])) {
+			height = NAN;
+		} else {
+			r_min = MIN(r_min, height);
+			r_max = MAX(r_max, height);
+		}
+		r_dest[i * p_dest_stride] = height;
+	}
+}
 
-	// Get region_loc of top left corner of descaled and grid snapped collision shape position
-	Vector2i region_loc = V2I_DIVIDE_FLOOR(p_position, region_size);
-	Ref<TerrainGeneratorRegion> region = data->get_region(region_loc);
-	if (region.is_null() || (region.is_valid() && region->is_deleted())) {
-		LOG(EXTREME, "Region not found at: ", region_loc, ". Returning blank");
-		return Dictionary();
+// Fills shape heights from its top left position. Assumes descaled and snapped.
+// Reads rows straight from the map buffers so may run on any thread. Leaves heights empty if no region.
+void TerrainGeneratorCollision::_fill_shape_data(const MapSnapshot &p_maps, ShapeData &r_shape) const {
+	r_shape.heights = PackedRealArray();
+	const int region_size = p_maps.get_region_size();
+	if (region_size <= 0) {
+		return;
+	}
+	// Get top left pixel of the region holding the top left corner of the collision shape
+	const Vector2i pos = r_shape.position;
+	const Vector2i region_pos = V2I_DIVIDE_FLOOR(pos, region_size) * region_size;
+	const float *base_heights;
+	const uint32_t *base_controls;
+	if (!p_maps.get_pixel_ptrs(region_pos.x, region_pos.y, base_heights, base_controls)) {
+		return;
 	}
-	map = region->get_map(TYPE_HEIGHT);
-	cmap = region->get_map(TYPE_CONTROL);
 
-	// Get +X, +Z adjacent regions in case we run over
-	region = data->get_region(region_loc + Vector2i(1, 0));
-	if (region.is_valid() && !region->is_deleted()) {
-		map_x = region->get_map(TYPE_HEIGHT);
-		cmap_x = region->get_map(TYPE_CONTROL);
+	const int hshape_size = r_shape.size + 1; // Calculate last vertex at end
+	// Columns and rows before split are in this region, the rest in the +X, +Z adjacent regions
+	const int split_x = MIN(hshape_size, region_pos.x + region_size - pos.x);
+	const int split_z = MIN(hshape_size, region_pos.y + region_size - pos.y);
+	const int offset_x = pos.x - region_pos.x;
+	const int last = region_size - 1;
+	r_shape.heights.resize(hshape_size * hshape_size);
+	real_t *map_data = r_shape.heights.ptrw();
+	real_t min_height = FLT_MAX;
+	real_t max_height = -FLT_MAX;
+
+	for (int z = 0; z < hshape_size; z++) {
+		int global_z = pos.y + z;
+		// Left of split is this region or +Z, right is +X or +XZ.
+		// Missing adjacent regions repeat the last row or column of this region.
+		const float *left_heights, *right_heights;
+		const uint32_t *left_controls, *right_controls;
+		int right_step = 1;
+		if (z < split_z) {
+			int row = (global_z - region_pos.y) * region_size;
+			left_heights = base_heights + row + offset_x;
+			left_controls = base_controls + row + offset_x;
+			if (!p_maps.get_pixel_ptrs(region_pos.x + region_size, global_z, right_heights, right_controls)) {
+				right_heights = base_heights + row + last;
+				right_controls = base_controls + row + last;
+				right_step = 0;
+			}
+		} else {
+			if (!p_maps.get_pixel_ptrs(pos.x, global_z, left_heights, left_controls)) {
+				left_heights = base_heights + last * region_size + offset_x;
+				left_controls = base_controls + last * region_size + offset_x;
+			}
+			if (!p_maps.get_pixel_ptrs(region_pos.x + region_size, global_z, right_heights, right_controls)) {
+				right_heights = base_heights + last * region_size + last;
+				right_controls = base_controls + last * region_size + last;
+				right_step = 0;
+			}
+		}
+
+		// Choose array indexing to match triangulation of heightmapshape with the mesh
+		// https://stackoverflow.com/questions/16684856/rotating-a-2d-pixel-array-by-90-degrees
+		// Normal array index rotated Y=0 - shape rotation Y=0 (xform in _place_shape)
+		// int index = z * hshape_size + x;
+		// Array Index Rotated Y=-90 - must rotate shape Y=+90 (xform in _place_shape)
+		// int index = hshape_size - 1 - z + x * hshape_size;
+		real_t *column = map_data + hshape_size - 1 - z;
+		_copy_row(left_heights, left_controls, 1, split_x, column, hshape_size, min_height, max_height);
+		_copy_row(right_heights, right_controls, right_step, hshape_size - split_x,
+				column + split_x * hshape_size, hshape_size, min_height, max_height);
+	}
+	r_shape.min_height = min_height;
+	r_shape.max_height = max_height;
+}
+
+// Runs on WorkerThreadPool threads. Each only writes its own shape.
+void TerrainGeneratorCollision::_build_shape_task(const uint32_t p_index, ShapeData *p_shapes) {
+	_fill_shape_data(_build_maps, p_shapes[p_index]);
+}
+
+// Waits for and discards any shapes being built
+void TerrainGeneratorCollision::_wait_for_build() {
+	if (_is_building()) {
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(_build_task_id);
+		_build_task_id = -1;
 	}
-	region = data->get_region(region_loc + Vector2i(0, 1));
-	if (region.is_valid() && !region->is_deleted()) {
-		map_z = region->get_map(TYPE_HEIGHT);
-		cmap_z = region->get_map(TYPE_CONTROL);
+	_build_shapes.clear();
+	_build_maps.clear();
+}
+
+// Caches the built shapes and swaps them in, if they're still in the area
+void TerrainGeneratorCollision::_finish_build() {
+	if (!_is_building()) {
+		return;
 	}
-	region = data->get_region(region_loc + Vector2i(1, 1));
-	if (region.is_valid() && !region->is_deleted()) {
-		map_xz = region->get_map(TYPE_HEIGHT);
-		cmap_xz = region->get_map(TYPE_CONTROL);
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(_build_task_id);
+	_build_task_id = -1;
+	_build_maps.clear();
+	int placed = 0;
+	for (const ShapeData &shape : _build_shapes) {
+		bool replacing = shape.shape_id >= 0 && _shape_positions[shape.shape_id] == shape.position;
+		if (shape.stale) {
+			// Maps were edited during the build. Rebuild on the next update
+			_dirty = true;
+			continue;
+		}
+		if (shape.heights.is_empty()) {
+			if (replacing) {
+				_shape_set_disabled(shape.shape_id, true);
+				_shape_positions[shape.shape_id] = V2I_MAX;
+				_shape_stale[shape.shape_id] = false;
+				_inactive_shape_ids.push_back(shape.shape_id);
+			}
+			continue;
+		}
+		_shape_cache[shape.position] = shape;
+		if (!_is_in_radius(shape.position, _last_snapped_pos)) {
+			continue;
+		}
+		int shape_id = shape.shape_id;
+		if (!replacing) {
+			if (_inactive_shape_ids.empty()) {
+				LOG(ERROR, "No more unused shapes! Aborting!");
+				break;
+			}
+			shape_id = _inactive_shape_ids.back();
+			_inactive_shape_ids.pop_back();
+		}
+		_place_shape(shape_id, shape);
+		placed++;
+	}
+	LOG(EXTREME, "Built ", _build_shapes.size(), " collision shapes, placed ", placed, " in ",
+			Time::get_singleton()->get_ticks_usec() - _build_start_usec, " us");
+	_build_shapes.clear();
+
+	// Keep the cache bounded, dropping the shapes farthest from the target first
+	size_t max_cached = _shape_positions.size() * 4;
+	if (_shape_cache.size() > max_cached) {
+		std::vector<std::pair<int64_t, Vector2i>> distances;
+		distances.reserve(_shape_cache.size());
+		for (const std::pair<const Vector2i, ShapeData> &entry : _shape_cache) {
+			distances.push_back({ entry.first.distance_squared_to(_last_snapped_pos), entry.first });
+		}
+		std::nth_element(distances.begin(), distances.begin() + max_cached, distances.end());
+		for (size_t i = max_cached; i < distances.size(); i++) {
+			_shape_cache.erase(distances[i].second);
+		}
 	}
+}
 
-	for (int z = 0; z < hshape_size; z++) {
-		for (int x = 0; x < hshape_size; x++) {
-			// Choose array indexing to match triangulation of heightmapshape with the mesh
-			// https://stackoverflow.com/questions/16684856/rotating-a-2d-pixel-array-by-90-degrees
-			// Normal array index rotated Y=0 - shape rotation Y=0 (xform below)
-			// int index = z * hshape_size + x;
-			// Array Index Rotated Y=-90 - must rotate shape Y=+90 (xform below)
-			int index = hshape_size - 1 - z + x * hshape_size;
-
-			Vector2i shape_pos = p_position + Vector2i(x, z);
-			Vector2i shape_region_loc = V2I_DIVIDE_FLOOR(shape_pos, region_size);
-			int img_x = Math::posmod(shape_pos.x, region_size);
-			bool next_x = shape_region_loc.x > region_loc.x;
-			int img_y = Math::posmod(shape_pos.y, region_size);
-			bool next_z = shape_region_loc.y > region_loc.y;
-
-			// Set heights on local map, or adjacent maps if on the last row/col
-			real_t height = 0.f;
-			if (!next_x && !next_z && map.is_valid()) {
-				height = is_hole(cmap->get_pixel(img_x, img_y).r) ? NAN : map->get_pixel(img_x, img_y).r;
-			} else if (next_x && !next_z) {
-				if (map_x.is_valid()) {
-					height = is_hole(cmap_x->get_pixel(img_x, img_y).r) ? NAN : map_x->get_pixel(img_x, img_y).r;
-				} else {
-					height = is_hole(cmap->get_pixel(region_size - 1, img_y).r) ? NAN : map->get_pixel(region_size - 1, img_y).r;
-				}
-			} else if (!next_x && next_z) {
-				if (map_z.is_valid()) {
-					height = is_hole(cmap_z->get_pixel(img_x, img_y).r) ? NAN : map_z->get_pixel(img_x, img_y).r;
-				} else {
-					height = (is_hole(cmap->get_pixel(img_x, region_size - 1).r)) ? NAN : map->get_pixel(img_x, region_size - 1).r;
-				}
-			} else if (next_x && next_z) {
-				if (map_xz.is_valid()) {
-					height = is_hole(cmap_xz->get_pixel(img_x, img_y).r) ? NAN : map_xz->get_pixel(img_x, img_y).r;
-				} else {
-					height = (is_hole(cmap->get_pixel(region_size - 1, region_size - 1).r)) ? NAN : map->get_pixel(region_size - 1, region_size - 1).r;
+// Keeps shapes in the area around the target, fills empty and stale cells from the cache,
+// and builds the remainder on worker threads. These are swapped in by _finish_build()
+void TerrainGeneratorCollision::_update_dynamic(const Vector2i &p_snapped_pos) {
+	LOG(EXTREME, "---- 1. Defining area as a radius on a grid ----");
+	// Create a 0-N grid, center on snapped_pos
+	int grid_width = _get_grid_width();
+	std::vector<int> grid(grid_width * grid_width, -1);
+	Vector2i grid_offset = -V2I(grid_width / 2); // offset # cells to center of grid
+	Vector2i grid_pos = p_snapped_pos + grid_offset * _shape_size; // Top left of grid
+	LOG(EXTREME, "New Snapped position: ", p_snapped_pos);
+	LOG(EXTREME, "Grid_pos: ", grid_pos);
+	LOG(EXTREME, "Radius: ", _radius, ", Grid_width: ", grid_width, ", Grid_offset: ", grid_offset, ", # cells: ", grid.size());
+
+	LOG(EXTREME, "---- 2. Checking existing shapes ----");
+	// If shape is within area, keep it
+	// Else, disable and mark unused
+	_inactive_shape_ids.clear();
+	for (int i = 0; i < _shape_positions.size(); i++) {
+		Vector2i shape_pos = _shape_positions[i];
+		bool active = shape_pos != V2I_MAX;
+		Vector2i grid_loc = active ? (shape_pos - grid_pos) / _shape_size : V2I(-1);
+		if (active && _is_in_radius(shape_pos, p_snapped_pos) && grid_loc.x >= 0 && grid_loc.y >= 0 &&
+				grid_loc.x < grid_width && grid_loc.y < grid_width) {
+			grid[grid_loc.y * grid_width + grid_loc.x] = i;
+			LOG(EXTREME, "Shape ", i, ": shape_pos: ", shape_pos, ", grid_loc: ", grid_loc, " active");
+		} else {
+			if (active) {
+				_shape_set_disabled(i, true);
+				_shape_positions[i] = V2I_MAX;
+				_shape_stale[i] = false;
+				LOG(EXTREME, "Shape ", i, ": shape_pos: ", shape_pos, " out of bounds, marking inactive");
+			}
+			_inactive_shape_ids.push_back(i);
+		}
+	}
+	LOG(EXTREME, "_inactive_shapes size: ", _inactive_shape_ids.size());
+
+	LOG(EXTREME, "---- 3. Review grid cells in area ----");
+	// If cell has an up to date shape, skip
+	// Else place a cached shape, or queue it to be built
+	_build_maps.create(_terrain->get_data());
+	_build_shapes.clear();
+	int cached = 0;
+	for (int i = 0; i < grid.size(); i++) {
+		Vector2i grid_loc(i % grid_width, i / grid_width);
+		// Unique key: Top left corner of shape, snapped to grid
+		Vector2i shape_pos = grid_pos + grid_loc * _shape_size;
+		if (!_is_in_radius(shape_pos, p_snapped_pos)) {
+			continue;
+		}
+		int shape_id = grid[i];
+		if (shape_id >= 0 && !_shape_stale[shape_id]) {
+			continue;
+		}
+		// Maps may change without maps_edited, eg. set_pixel(), so cached shapes are checked against the regions
+		Rect2i shape_area(shape_pos, V2I(_shape_size + 1));
+		uint64_t map_generation = _terrain->get_data()->get_map_generation(shape_area);
+		auto cached_shape = _shape_cache.find(shape_pos);
+		if (cached_shape != _shape_cache.end() && cached_shape->second.map_generation != map_generation) {
+			_shape_cache.erase(cached_shape);
+			cached_shape = _shape_cache.end();
+		}
+		if (cached_shape != _shape_cache.end()) {
+			if (shape_id < 0) {
+				if (_inactive_shape_ids.empty()) {
+					LOG(ERROR, "No more unused shapes! Aborting!");
+					break;
 				}
+				shape_id = _inactive_shape_ids.back();
+				_inactive_shape_ids.pop_back();
 			}
-			map_data.insert(index, height);
-			if (!std::isnan(height)) {
-				min_height = MIN(min_height, height);
-				max_height = MAX(max_height, height);
+			_place_shape(shape_id, cached_shape->second);
+			cached++;
+			continue;
+		}
+		const float *heights;
+		const uint32_t *controls;
+		int region_size = _build_maps.get_region_size();
+		if (_build_maps.is_empty() || !_build_maps.get_pixel_ptrs(int_divide_floor(shape_pos.x, region_size) * region_size,
+											  int_divide_floor(shape_pos.y, region_size) * region_size, heights, controls)) {
+			LOG(EXTREME, "grid[", i, ":", grid_loc, "] shape_pos : ", shape_pos, " No region found");
+			if (shape_id >= 0) {
+				_shape_set_disabled(shape_id, true);
+				_shape_positions[shape_id] = V2I_MAX;
+				_shape_stale[shape_id] = false;
+				_inactive_shape_ids.push_back(shape_id);
 			}
+			continue;
 		}
+		ShapeData shape;
+		shape.position = shape_pos;
+		shape.size = _shape_size;
+		shape.shape_id = shape_id;
+		shape.map_generation = map_generation;
+		_build_shapes.push_back(shape);
+	}
+	_last_snapped_pos = p_snapped_pos;
+	_dirty = false;
+	LOG(EXTREME, "Setting _last_snapped_pos: ", _last_snapped_pos, ", cached shapes placed: ", cached, ", shapes to build: ", _build_shapes.size());
+
+	if (_build_shapes.empty()) {
+		_build_maps.clear();
+		return;
 	}
+	_build_start_usec = Time::get_singleton()->get_ticks_usec();
+	_build_task_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &TerrainGeneratorCollision::_build_shape_task,
+			_build_shapes.data(), _build_shapes.size(), -1, true, "TerrainGenerator collision shapes");
+}
 
-	// Non rotated shape for normal array index above
+void TerrainGeneratorCollision::_place_shape(const int p_shape_id, const ShapeData &p_shape) {
+	real_t spacing = _terrain->get_vertex_spacing();
+	// Non rotated shape for normal array index
 	//Transform3D xform = Transform3D(Basis(), global_pos);
 	// Rotated shape Y=90 for -90 rotated array index
-	Transform3D xform = Transform3D(Basis(Vector3(0, 1.0, 0), Math::PI * .5), v2iv3(p_position + V2I(p_size / 2)));
-	Dictionary shape_data;
-	shape_data["width"] = hshape_size;
-	shape_data["depth"] = hshape_size;
-	shape_data["heights"] = map_data;
-	shape_data["xform"] = xform;
-	shape_data["min_height"] = min_height;
-	shape_data["max_height"] = max_height;
-	return shape_data;
+	Transform3D xform = Transform3D(Basis(Vector3(0, 1.0, 0), Math::PI * .5), v2iv3(p_shape.position + V2I(p_shape.size / 2)));
+	xform.scale(Vector3(spacing, 1.f, spacing));
+	_shape_set_transform(p_shape_id, xform);
+	_shape_set_disabled(p_shape_id, false);
+	_shape_set_data(p_shape_id, p_shape);
+	if (p_shape_id < _shape_positions.size()) {
+		_shape_positions[p_shape_id] = p_shape.position;
+		_shape_stale[p_shape_id] = false;
+	}
+}
+
+// Drops cached shapes under the edited area and marks active ones for rebuilding
+void TerrainGeneratorCollision::_invalidate_shapes(const AABB &p_area) {
+	if (!_initialized || !is_dynamic_mode()) {
+		return;
+	}
+	real_t spacing = _terrain->get_vertex_spacing();
+	// Descaled area, grown by a vertex as shapes read their neighbor's first row and column
+	Vector2i area_min = Vector2i(Math::floor(p_area.position.x / spacing), Math::floor(p_area.position.z / spacing)) - V2I(1);
+	Vector2i area_max = Vector2i(Math::ceil(p_area.get_end().x / spacing), Math::ceil(p_area.get_end().z / spacing)) + V2I(1);
+	Rect2i area(area_min, area_max - area_min + V2I(1));
+	Vector2i shape_extent = V2I(_shape_size + 1);
+
+	int erased = 0;
+	for (auto it = _shape_cache.begin(); it != _shape_cache.end();) {
+		if (area.intersects(Rect2i(it->first, shape_extent))) {
+			it = _shape_cache.erase(it);
+			erased++;
+		} else {
+			++it;
+		}
+	}
+	for (int i = 0; i < _shape_positions.size(); i++) {
+		if (_shape_positions[i] != V2I_MAX && area.intersects(Rect2i(_shape_positions[i], shape_extent))) {
+			_shape_stale[i] = true;
+			_dirty = true;
+		}
+	}
+	for (ShapeData &shape : _build_shapes) {
+		if (area.intersects(Rect2i(shape.position, shape_extent))) {
+			shape.stale = true;
+			_dirty = true;
+		}
+	}
+	LOG(EXTREME, "Edited area ", area, " invalidated ", erased, " cached shapes");
+}
+
+// Regions were streamed in or out. Only shapes over them are dropped, and empty cells refilled
+void TerrainGeneratorCollision::_invalidate_regions(const TypedArray<Vector2i> &p_locations) {
+	if (!_initialized) {
+		return;
+	}
+	if (!is_dynamic_mode()) {
+		build();
+		return;
+	}
+	real_t region_width = _terrain->get_region_size() * _terrain->get_vertex_spacing();
+	for (int i = 0; i < p_locations.size(); i++) {
+		Vector2i loc = p_locations[i];
+		_invalidate_shapes(AABB(Vector3(loc.x * region_width, 0.f, loc.y * region_width), Vector3(region_width, 0.f, region_width)));
+	}
+	_dirty = true;
 }
 
 void TerrainGeneratorCollision::_shape_set_disabled(const int p_shape_id, const bool p_disabled) {
@@ -149,14 +399,20 @@ Vector3 TerrainGeneratorCollision::_shape_get_position(const int p_shape_id) con
 	}
 }
 
-void TerrainGeneratorCollision::_shape_set_data(const int p_shape_id, const Dictionary &p_dict) {
+void TerrainGeneratorCollision::_shape_set_data(const int p_shape_id, const ShapeData &p_shape) {
 	if (is_editor_mode()) {
 		CollisionShape3D *shape = _shapes[p_shape_id];
 		Ref<HeightMapShape3D> hshape = shape->get_shape();
-		hshape->set_map_data(p_dict["heights"]);
+		hshape->set_map_data(p_shape.heights);
 	} else {
 		RID shape_rid = PS->body_get_shape(_static_body_rid, p_shape_id);
-		PS->shape_set_data(shape_rid, p_dict);
+		Dictionary shape_data;
+		shape_data["width"] = p_shape.size + 1;
+		shape_data["depth"] = p_shape.size + 1;
+		shape_data["heights"] = p_shape.heights;
+		shape_data["min_height"] = p_shape.min_height;
+		shape_data["max_height"] = p_shape.max_height;
+		PS->shape_set_data(shape_rid, shape_data);
 	}
 }
 
@@ -241,8 +497,7 @@ void TerrainGeneratorCollision::build() {
 	int shape_count;
 	int hshape_size;
 	if (is_dynamic_mode()) {
-		int grid_width = _radius * 2 / _shape_size;
-		grid_width = int_ceil_pow2(grid_width, 4);
+		int grid_width = _get_grid_width();
 		shape_count = grid_width * grid_width;
 		hshape_size = _shape_size + 1;
 		LOG(DEBUG, "Grid width: ", grid_width);
@@ -278,6 +533,10 @@ void TerrainGeneratorCollision::build() {
 			LOG(DEBUG, "Adding shape: ", i, ", rid: ", shape_rid.get_id(), " pos: ", _shape_get_position(i));
 		}
 	}
+	if (is_dynamic_mode()) {
+		_shape_positions.assign(shape_count, V2I_MAX);
+		_shape_stale.assign(shape_count, false);
+	}
 
 	_initialized = true;
 	update();
@@ -285,6 +544,7 @@ void TerrainGeneratorCollision::build() {
 
 void TerrainGeneratorCollision::update(const bool p_rebuild) {
 	IS_INIT(VOID);
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::COLLISION);
 	if (!_initialized) {
 		return;
 	}
@@ -292,131 +552,78 @@ void TerrainGeneratorCollision::update(const bool p_rebuild) {
 		build();
 		return;
 	}
-	int time = Time::get_singleton()->get_ticks_usec();
-	real_t spacing = _terrain->get_vertex_spacing();
+	uint64_t time = Time::get_singleton()->get_ticks_usec();
 
 	if (is_dynamic_mode()) {
+		// Swap in shapes built on worker threads when ready. A rebuild waits for them
+		if (_is_building()) {
+			if (!p_rebuild && !WorkerThreadPool::get_singleton()->is_group_task_completed(_build_task_id)) {
+				return;
+			}
+			_finish_build();
+		}
+		if (p_rebuild) {
+			// Maps may have changed without maps_edited, so nothing cached can be trusted
+			_shape_cache.clear();
+			_shape_stale.assign(_shape_stale.size(), true);
+			_dirty = true;
+		}
+
 		// Snap descaled position to a _shape_size grid (eg. multiples of 16)
-		Vector2i snapped_pos = _snap_to_grid(_terrain->get_collision_target_position() / spacing);
+		Vector2i snapped_pos = _snap_to_grid(_terrain->get_collision_target_position() / _terrain->get_vertex_spacing());
 		LOG(EXTREME, "Updating collision at ", snapped_pos);
 
-		// Skip if location hasn't moved to next step
-		if (!p_rebuild && (_last_snapped_pos - snapped_pos).length_squared() < (_shape_size * _shape_size)) {
+		// Skip if location hasn't moved to next step and nothing was edited
+		if (!_dirty && (_last_snapped_pos - snapped_pos).length_squared() < (_shape_size * _shape_size)) {
 			return;
 		}
-
-		LOG(EXTREME, "---- 1. Defining area as a radius on a grid ----");
-		// Create a 0-N grid, center on snapped_pos
-		PackedInt32Array grid;
-		int grid_width = _radius * 2 / _shape_size; // 64*2/16 = 8
-		grid_width = int_ceil_pow2(grid_width, 4);
-		grid.resize(grid_width * grid_width);
-		grid.fill(-1);
-		Vector2i grid_offset = -V2I(grid_width / 2); // offset # cells to center of grid
-		Vector2i shape_offset = V2I(_shape_size / 2); // offset meters to top left corner of shape
-		Vector2i grid_pos = snapped_pos + grid_offset * _shape_size; // Top left of grid
-		LOG(EXTREME, "New Snapped position: ", snapped_pos);
-		LOG(EXTREME, "Grid_pos: ", grid_pos);
-		LOG(EXTREME, "Radius: ", _radius, ", Grid_width: ", grid_width, ", Grid_offset: ", grid_offset, ", # cells: ", grid.size());
-		LOG(EXTREME, "Shape_size: ", _shape_size, ", shape_offset: ", shape_offset);
-
-		LOG(EXTREME, "---- 2. Checking existing shapes ----");
-		// If shape is within area, skip
-		// Else, mark unused
-
-		// Stores index into _shapes array
-		TypedArray<int> inactive_shape_ids;
-
-		real_t radius_sqr = real_t(_radius * _radius);
-		int shape_count = is_editor_mode() ? _shapes.size() : PS->body_get_shape_count(_static_body_rid);
-		for (int i = 0; i < shape_count; i++) {
-			// Descaled global position of shape center
-			Vector3 shape_center = _shape_get_position(i) / spacing;
-			// Unique key: Top left corner of shape, snapped to grid
-			Vector2i shape_pos = _snap_to_grid(v3v2i(shape_center) - shape_offset);
-			// Optionally could adjust radius to account for corner (sqrt(_shape_size*2))
-			if (!p_rebuild && (shape_center.x < FLT_MAX && v3v2i(shape_center).distance_squared_to(snapped_pos) <= radius_sqr)) {
-				// Get index into shape array
-				Vector2i grid_loc = (shape_pos - grid_pos) / _shape_size;
-				grid.insert(grid_loc.y * grid_width + grid_loc.x, i);
-				_shape_set_disabled(i, false);
-				LOG(EXTREME, "Shape ", i, ": shape_center: ", shape_center.x < FLT_MAX ? shape_center : V3(-999), ", shape_pos: ", shape_pos,
-						", grid_loc: ", grid_loc, ", index: ", (grid_loc.y * grid_width + grid_loc.x), " active");
-			} else {
-				inactive_shape_ids.push_back(i);
-				_shape_set_disabled(i, true);
-				LOG(EXTREME, "Shape ", i, ": shape_center: ", shape_center.x < FLT_MAX ? shape_center : V3(-999), ", shape_pos: ", shape_pos,
-						" out of bounds, marking inactive");
-			}
+		_update_dynamic(snapped_pos);
+		if (p_rebuild) {
+			_finish_build();
 		}
-		LOG(EXTREME, "_inactive_shapes size: ", inactive_shape_ids.size());
-
-		LOG(EXTREME, "---- 3. Review grid cells in area ----");
-		// If cell is full, skip
-		// Else assign shape and form it
-
-		for (int i = 0; i < grid.size(); i++) {
-			Vector2i grid_loc(i % grid_width, i / grid_width);
-			// Unique key: Top left corner of shape, snapped to grid
-			Vector2i shape_pos = grid_pos + grid_loc * _shape_size;
-
-			if ((shape_pos + shape_offset).distance_squared_to(snapped_pos) > radius_sqr) {
-				LOG(EXTREME, "grid[", i, ":", grid_loc, "] shape_pos : ", shape_pos, " out of circle, skipping");
-				continue;
-			}
-			if (!p_rebuild && grid[i] >= 0) {
-				Vector2i center_pos = v3v2i(_shape_get_position(i));
-				LOG(EXTREME, "grid[", i, ":", grid_loc, "] shape_pos : ", shape_pos, " act ", center_pos - shape_offset, " Has active shape id: ", grid[i]);
-				continue;
-			} else {
-				if (inactive_shape_ids.size() == 0) {
-					LOG(ERROR, "No more unused shapes! Aborting!");
-					break;
-				}
-				Dictionary shape_data = _get_shape_data(shape_pos, _shape_size);
-				if (shape_data.is_empty()) {
-					LOG(EXTREME, "grid[", i, ":", grid_loc, "] shape_pos : ", shape_pos, " No region found");
-					continue;
-				}
-				int shape_id = inactive_shape_ids.pop_back();
-				Transform3D xform = shape_data["xform"];
-				LOG(EXTREME, "grid[", i, ":", grid_loc, "] shape_pos : ", shape_pos, " act ", v3v2i(xform.origin) - shape_offset, " placing shape id ", shape_id);
-				xform.scale(Vector3(spacing, 1.f, spacing));
-				_shape_set_transform(shape_id, xform);
-				_shape_set_disabled(shape_id, false);
-				_shape_set_data(shape_id, shape_data);
-			}
-		}
-		_last_snapped_pos = snapped_pos;
-		LOG(EXTREME, "Setting _last_snapped_pos: ", _last_snapped_pos);
-		LOG(EXTREME, "inactive_shape_ids size: ", inactive_shape_ids.size());
 
 	} else {
-		// Full collision
-		int shape_count = _terrain->get_data()->get_region_count();
+		// Full collision, one shape per region built in parallel
+		TerrainGeneratorData *data = _terrain->get_data();
 		int region_size = _terrain->get_region_size();
-		TypedArray<Vector2i> region_locs = _terrain->get_data()->get_region_locations();
+		TypedArray<Vector2i> region_locs = data->get_region_locations();
+		if (region_locs.is_empty()) {
+			return;
+		}
+		_build_maps.create(data);
+		_build_shapes.resize(region_locs.size());
 		for (int i = 0; i < region_locs.size(); i++) {
-			Vector2i region_loc = region_locs[i];
-			Vector2i shape_pos = region_loc * region_size;
-			Dictionary shape_data = _get_shape_data(shape_pos, region_size);
-			if (shape_data.is_empty()) {
-				LOG(ERROR, "Can't get shape data for ", region_loc);
+			ShapeData &shape = _build_shapes[i];
+			shape = ShapeData();
+			shape.position = Vector2i(region_locs[i]) * region_size;
+			shape.size = region_size;
+		}
+		WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+		WorkerThreadPool::GroupID task_id = wtp->add_template_group_task(this, &TerrainGeneratorCollision::_build_shape_task,
+				_build_shapes.data(), _build_shapes.size(), -1, true, "TerrainGenerator collision shapes");
+		wtp->wait_for_group_task_completion(task_id);
+		for (int i = 0; i < _build_shapes.size(); i++) {
+			if (_build_shapes[i].heights.is_empty()) {
+				LOG(ERROR, "Can't get shape data for ", region_locs[i]);
 				continue;
 			}
-			Transform3D xform = shape_data["xform"];
-			xform.scale(Vector3(spacing, 1.f, spacing));
-			_shape_set_transform(i, xform);
-			_shape_set_disabled(i, false);
-			_shape_set_data(i, shape_data);
+			_place_shape(i, _build_shapes[i]);
 		}
+		_build_shapes.clear();
+		_build_maps.clear();
 	}
 	LOG(EXTREME, "Collision update time: ", Time::get_singleton()->get_ticks_usec() - time, " us");
 }
 
 void TerrainGeneratorCollision::destroy() {
+	_wait_for_build();
 	_initialized = false;
 	_last_snapped_pos = V2I_MAX;
+	_dirty = false;
+	_shape_positions.clear();
+	_shape_stale.clear();
+	_inactive_shape_ids.clear();
+	_shape_cache.clear();
 
 	// Physics Server
 	if (_static_body_rid.is_valid()) {
@@ -589,6 +796,7 @@ void TerrainGeneratorCollision::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_physics_material", "material"), &TerrainGeneratorCollision::set_physics_material);
 	ClassDB::bind_method(D_METHOD("get_physics_material"), &TerrainGeneratorCollision::get_physics_material);
 	ClassDB::bind_method(D_METHOD("get_rid"), &TerrainGeneratorCollision::get_rid);
+	ClassDB::bind_method(D_METHOD("get_cached_shape_count"), &TerrainGeneratorCollision::get_cached_shape_count);
 
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "mode", PROPERTY_HINT_ENUM, "Disabled,Dynamic / Game,Dynamic / Editor,Full / Game,Full / Editor"), "set_mode", "get_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "shape_size", PROPERTY_HINT_RANGE, "8,64,8"), "set_shape_size", "get_shape_size");
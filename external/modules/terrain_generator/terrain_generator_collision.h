@@ -5,9 +5,12 @@
 #include <godot/scene/3d/physics/collision_shape_3d.h>
 #include <godot/scene/resources/physics_material.h>
 #include <godot/scene/3d/physics/static_body_3d.h>
+#include <godot/core/object/worker_thread_pool.h>
+#include <unordered_map>
 #include <vector>
 
 #include "constants.h"
+#include "map_snapshot.h"
 #include "terrain_generator_util.h"
 
 class TerrainGenerator;
@@ -15,6 +18,7 @@ class TerrainGenerator;
 class TerrainGeneratorCollision : public Object {
 	GDCLASS(TerrainGeneratorCollision, Object);
 	CLASS_NAME();
+	friend TerrainGenerator;
 
 public: // Constants
 	enum CollisionMode {
@@ -26,6 +30,18 @@ public: // Constants
 	};
 
 private:
+	// Heights of one HeightMapShape3D, filled on worker threads
+	struct ShapeData {
+		Vector2i position = V2I_MAX; // Descaled, grid snapped top left corner
+		int size = 0;
+		int shape_id = -1; // Shape to replace, or -1 for any inactive shape
+		bool stale = false; // Maps were edited while building
+		uint64_t map_generation = 0; // Of the regions read when queued, see TerrainGeneratorData::get_map_generation()
+		PackedRealArray heights; // Empty if there is no region
+		real_t min_height = 0.f;
+		real_t max_height = 0.f;
+	};
+
 	TerrainGenerator *_terrain = nullptr;
 
 	// Public settings
@@ -45,14 +61,35 @@ private:
 	bool _initialized = false;
 	Vector2i _last_snapped_pos = V2I_MAX;
 
+	// Dynamic collision
+	std::vector<Vector2i> _shape_positions; // Per shape id, top left corner or V2I_MAX if inactive
+	std::vector<bool> _shape_stale; // Per shape id, maps under it were edited
+	std::vector<int> _inactive_shape_ids;
+	std::unordered_map<Vector2i, ShapeData, Vector2iHash> _shape_cache; // Built shapes by position
+	bool _dirty = false; // Shapes need rebuilding even if the target hasn't moved
+	MapSnapshot _build_maps; // Maps read by the build task
+	std::vector<ShapeData> _build_shapes;
+	WorkerThreadPool::GroupID _build_task_id = -1;
+	uint64_t _build_start_usec = 0;
+
 	Vector2i _snap_to_grid(const Vector2i &p_pos) const;
 	Vector2i _snap_to_grid(const Vector3 &p_pos) const;
-	Dictionary _get_shape_data(const Vector2i &p_position, const int p_size);
+	int _get_grid_width() const;
+	bool _is_in_radius(const Vector2i &p_shape_pos, const Vector2i &p_snapped_pos) const;
+	void _fill_shape_data(const MapSnapshot &p_maps, ShapeData &r_shape) const;
+	void _build_shape_task(const uint32_t p_index, ShapeData *p_shapes);
+	bool _is_building() const { return _build_task_id >= 0; }
+	void _wait_for_build();
+	void _finish_build();
+	void _update_dynamic(const Vector2i &p_snapped_pos);
+	void _place_shape(const int p_shape_id, const ShapeData &p_shape);
+	void _invalidate_shapes(const AABB &p_area);
+	void _invalidate_regions(const TypedArray<Vector2i> &p_locations);
 
 	void _shape_set_disabled(const int p_shape_id, const bool p_disabled);
 	void _shape_set_transform(const int p_shape_id, const Transform3D &p_xform);
 	Vector3 _shape_get_position(const int p_shape_id) const;
-	void _shape_set_data(const int p_shape_id, const Dictionary &p_dict);
+	void _shape_set_data(const int p_shape_id, const ShapeData &p_shape);
 
 	void _reload_physics_material();
 
@@ -84,6 +121,7 @@ public:
 	void set_physics_material(const Ref<PhysicsMaterial> &p_mat);
 	Ref<PhysicsMaterial> get_physics_material() { return _physics_material; }
 	RID get_rid() const;
+	int get_cached_shape_count() const { return _shape_cache.size(); }
 
 protected:
 	static void _bind_methods();
@@ -7,9 +7,14 @@
 #include <godot/core/core_bind.h>
 #include <godot/core/io/file_access.h>
 #include <godot/core/io/resource_saver.h>
+#include <godot/core/os/time.h>
+#include <godot/core/templates/hashfuncs.h>
+#include <algorithm>
 
 #include "logger.h"
 #include "terrain_generator_data.h"
+#include "terrain_generator_profiler.h"
+#include "terrain_generator_region_file.h"
 
 ///////////////////////////
 // Private Functions
@@ -17,6 +22,7 @@
 
 void TerrainGeneratorData::_clear() {
 	LOG(INFO, "Clearing data");
+	_stop_streaming();
 	_region_map_dirty = true;
 	_region_map.clear();
 	_region_map.resize(REGION_MAP_SIZE * REGION_MAP_SIZE);
@@ -44,6 +50,214 @@ void TerrainGeneratorData::_copy_paste_dfr(const TerrainGeneratorRegion *p_src_r
 	_terrain->get_instancer()->copy_paste_dfr(p_src_region, p_src_rect, p_dst_region);
 }
 
+// Validates a region loaded from p_path and prepares it to be added
+Error TerrainGeneratorData::_setup_loaded_region(const Ref<TerrainGeneratorRegion> &p_region, const Vector2i &p_region_loc, const String &p_path) {
+	if (p_region.is_null()) {
+		LOG(ERROR, "Cannot load region at ", p_path);
+		return FAILED;
+	}
+	if (_regions.is_empty()) {
+		_terrain->set_region_size((TerrainGenerator::RegionSize)p_region->get_region_size());
+	} else {
+		if (_terrain->get_region_size() != (TerrainGenerator::RegionSize)p_region->get_region_size()) {
+			LOG(ERROR, "Region size mismatch. First loaded: ", _terrain->get_region_size(), " next: ",
+					p_region->get_region_size(), " in file: ", p_path);
+			return FAILED;
+		}
+	}
+	p_region->take_over_path(p_path);
+	p_region->set_location(p_region_loc);
+	p_region->set_version(CURRENT_VERSION); // Sends upgrade warning if old version
+	return OK;
+}
+
+// Loads a region resource (*.res) or region file (*.tgr). p_parallel is false on worker threads.
+Ref<TerrainGeneratorRegion> TerrainGeneratorData::_load_region_file(const String &p_path, const bool p_parallel) const {
+	if (p_path.get_extension() == TerrainGeneratorRegionFile::EXTENSION) {
+		return TerrainGeneratorRegionFile::load_region(p_path, p_parallel);
+	}
+	return CoreBind::ResourceLoader::get_singleton()->load(p_path, "TerrainGeneratorRegion", CoreBind::ResourceLoader::CACHE_MODE_IGNORE);
+}
+
+// Returns the region file paths in p_dir by location. If a region has both formats, the one
+// selected by TerrainGenerator::tiled_region_files is used.
+std::unordered_map<Vector2i, String, Vector2iHash> TerrainGeneratorData::_get_region_files(const String &p_dir) const {
+	std::unordered_map<Vector2i, String, Vector2iHash> paths;
+	String preferred = _terrain->get_tiled_region_files() ? TerrainGeneratorRegionFile::EXTENSION : "res";
+	PackedStringArray files = Util::get_files(p_dir, "TerrainGenerator*.res");
+	files.append_array(Util::get_files(p_dir, "TerrainGenerator*." + String(TerrainGeneratorRegionFile::EXTENSION)));
+	for (int i = 0; i < files.size(); i++) {
+		String fname = files[i];
+		Vector2i loc = Util::filename_to_location(fname);
+		if (loc.x == INT32_MAX) {
+			LOG(ERROR, "Cannot get region location from file name: ", fname);
+			continue;
+		}
+		auto it = paths.find(loc);
+		if (it == paths.end() || fname.get_extension() == preferred) {
+			paths[loc] = p_dir + String("/") + fname;
+		}
+	}
+	return paths;
+}
+
+void TerrainGeneratorData::_remove_region_file(const String &p_dir, const String &p_fname) const {
+	String path = p_dir + String("/") + p_fname;
+	if (!FileAccess::exists(path)) {
+		return;
+	}
+	Ref<DirAccess> da = DirAccess::open(p_dir);
+	if (da.is_null()) {
+		LOG(ERROR, "Cannot open directory for writing: ", p_dir, " error: ", DirAccess::get_open_error());
+		return;
+	}
+	Error err = da->remove(p_fname);
+	if (err != OK) {
+		LOG(ERROR, "Could not remove file: ", p_fname, ", error code: ", err);
+		return;
+	}
+	LOG(INFO, "File ", path, " deleted");
+}
+
+// Sends the area of a region map queued by add_update_area() to its texture array layer. Maps of
+// edited regions that don't track areas, as after undo, are sent whole. Returns true if sent.
+bool TerrainGeneratorData::_update_layer(TerrainGeneratorRegion *p_region, const MapType p_map_type, const int p_layer) {
+	GeneratedTexture *texture = nullptr;
+	switch (p_map_type) {
+		case TYPE_HEIGHT:
+			texture = &_generated_height_maps;
+			break;
+		case TYPE_CONTROL:
+			texture = &_generated_control_maps;
+			break;
+		case TYPE_COLOR:
+			texture = &_generated_color_maps;
+			break;
+		default:
+			return false;
+	}
+	Rect2i area = p_region->take_update_area(p_map_type);
+	if (area.has_area()) {
+		texture->update_area(p_region->get_map(p_map_type), p_layer, area);
+		return true;
+	} else if (!p_region->is_update_tracked()) {
+		texture->update(p_region->get_map(p_map_type), p_layer);
+		return true;
+	}
+	return false;
+}
+
+// Returns true if the image and texture arrays match _region_locations, so single layers can be
+// added or removed without rebuilding every array
+bool TerrainGeneratorData::_are_layers_valid() const {
+	int count = _region_locations.size();
+	return !_region_map_dirty && _height_maps.size() == count && _control_maps.size() == count && _color_maps.size() == count &&
+			!_generated_height_maps.is_dirty() && _generated_height_maps.get_layer_count() == count &&
+			!_generated_control_maps.is_dirty() && _generated_control_maps.get_layer_count() == count &&
+			!_generated_color_maps.is_dirty() && _generated_color_maps.get_layer_count() == count;
+}
+
+// Texture arrays get spare layers while streaming so regions can stream in without recreating the
+// arrays. Each time they run out, capacity grows to 1.5x the resident and loading regions, up to
+// resident_region_budget, so memory follows what is actually resident.
+int TerrainGeneratorData::_get_layer_capacity() const {
+	if (_terrain && is_streaming()) {
+		int count = _region_locations.size() + int(_stream_tasks.size());
+		int capacity = MIN(count + MAX(count / 2, MIN_SPARE_LAYERS), _terrain->get_resident_region_budget());
+		return MAX(capacity, _region_locations.size());
+	}
+	return 0;
+}
+
+// Runs on a WorkerThreadPool thread. Only the given task is touched until the main thread
+// has waited on it in update_streaming()
+void TerrainGeneratorData::_stream_load_task(StreamTask *p_task) {
+	p_task->region = _load_region_file(p_task->path, false);
+	p_task->load_usec = Time::get_singleton()->get_ticks_usec() - p_task->start_usec;
+}
+
+void TerrainGeneratorData::_stop_streaming() {
+	if (!_stream_tasks.empty()) {
+		LOG(INFO, "Waiting for ", _stream_tasks.size(), " region loading tasks");
+	}
+	for (StreamTask *task : _stream_tasks) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(task->task_id);
+		memdelete(task);
+	}
+	_stream_tasks.clear();
+	_stream_queue.clear();
+	_stream_files.clear();
+	_stream_center = V2I_MAX;
+	_stream_center2 = V2I_MAX;
+}
+
+// Adds a streamed region as the last region_id. Returns false if the arrays must be rebuilt.
+bool TerrainGeneratorData::_stream_in(const Ref<TerrainGeneratorRegion> &p_region) {
+	Vector2i region_loc = p_region->get_location();
+	bool layers_valid = _are_layers_valid();
+	p_region->sanitize_maps();
+	p_region->set_deleted(false);
+	_regions[region_loc] = p_region;
+	_region_locations.push_back(region_loc);
+	update_master_heights(p_region->get_height_range());
+	if (!layers_valid) {
+		_region_map_dirty = true;
+		return false;
+	}
+	int region_id = _region_locations.size() - 1;
+	_region_map.set(get_region_map_index(region_loc), region_id + 1);
+	_height_maps.push_back(p_region->get_height_map());
+	_control_maps.push_back(p_region->get_control_map());
+	_color_maps.push_back(p_region->get_color_map());
+	bool uploaded = _generated_height_maps.set_layer(p_region->get_height_map(), region_id);
+	uploaded = _generated_control_maps.set_layer(p_region->get_control_map(), region_id) && uploaded;
+	uploaded = _generated_color_maps.set_layer(p_region->get_color_map(), region_id) && uploaded;
+	return uploaded;
+}
+
+// Removes a region from memory, leaving its file on disk. The last region_id is moved into the
+// freed layer to keep the arrays packed. Returns false if the arrays must be rebuilt.
+bool TerrainGeneratorData::_stream_out(const Vector2i &p_region_loc) {
+	int region_id = _region_locations.find(p_region_loc);
+	if (region_id < 0) {
+		_regions.erase(p_region_loc);
+		return true;
+	}
+	bool layers_valid = _are_layers_valid();
+	int mesh_count = _terrain->get_assets()->get_mesh_count();
+	for (int m = 0; m < mesh_count; m++) {
+		_terrain->get_instancer()->_destroy_mmi_by_location(p_region_loc, m);
+	}
+	if (!layers_valid) {
+		_region_locations.remove_at(region_id);
+		_regions.erase(p_region_loc);
+		_region_map_dirty = true;
+		return false;
+	}
+	int last_id = _region_locations.size() - 1;
+	_region_map.set(get_region_map_index(p_region_loc), 0);
+	if (region_id != last_id) {
+		Vector2i last_loc = _region_locations[last_id];
+		_region_locations.set(region_id, last_loc);
+		_height_maps.set(region_id, _height_maps[last_id]);
+		_control_maps.set(region_id, _control_maps[last_id]);
+		_color_maps.set(region_id, _color_maps[last_id]);
+		_region_map.set(get_region_map_index(last_loc), region_id + 1);
+		_generated_height_maps.update(_height_maps[region_id], region_id);
+		_generated_control_maps.update(_control_maps[region_id], region_id);
+		_generated_color_maps.update(_color_maps[region_id], region_id);
+	}
+	_region_locations.remove_at(last_id);
+	_height_maps.remove_at(last_id);
+	_control_maps.remove_at(last_id);
+	_color_maps.remove_at(last_id);
+	_generated_height_maps.remove_layer();
+	_generated_control_maps.remove_layer();
+	_generated_color_maps.remove_layer();
+	_regions.erase(p_region_loc);
+	return true;
+}
+
 ///////////////////////////
 // Public Functions
 ///////////////////////////
@@ -179,6 +393,28 @@ void TerrainGeneratorData::change_region_size(int p_new_size) {
 	_terrain->get_instancer()->update_mmis(true);
 }
 
+// Combines the map generations of the regions overlapping a descaled area. Generations are unique,
+// so any map change, or any region added or removed, since the value was taken gives another value.
+uint64_t TerrainGeneratorData::get_map_generation(const Rect2i &p_area) const {
+	if (_region_size <= 0) {
+		return 0;
+	}
+	Vector2i start = V2I_DIVIDE_FLOOR(p_area.position, _region_size);
+	Vector2i end = V2I_DIVIDE_FLOOR(p_area.get_end() - V2I(1), _region_size);
+	uint64_t generation = 0;
+	for (int z = start.y; z <= end.y; z++) {
+		for (int x = start.x; x <= end.x; x++) {
+			const TerrainGeneratorRegion *region = get_region_ptr(Vector2i(x, z));
+			if (region && !region->is_deleted()) {
+				generation = hash_murmur3_one_64(region->get_map_generation(), generation);
+			} else {
+				generation = hash_murmur3_one_64(0, generation);
+			}
+		}
+	}
+	return generation;
+}
+
 void TerrainGeneratorData::set_region_modified(const Vector2i &p_region_loc, const bool p_modified) {
 	TerrainGeneratorRegion *region = get_region_ptr(p_region_loc);
 	if (!region) {
@@ -225,13 +461,62 @@ Ref<TerrainGeneratorRegion> TerrainGeneratorData::add_region_blank(const Vector2
 	region->set_location(p_region_loc);
 	region->set_region_size(_region_size);
 	region->set_vertex_spacing(_vertex_spacing);
+	Ref<TerrainGeneratorProcedural> procedural = _terrain->get_procedural();
+	if (procedural.is_valid() && procedural->get_generate_blank_regions() && get_region_map_index(p_region_loc) >= 0) {
+		procedural->generate_region(region);
+	}
 	if (add_region(region, p_update) == OK) {
 		region->set_modified(true);
+		update_master_heights(region->get_height_range());
 		return region;
 	}
 	return Ref<TerrainGeneratorRegion>();
 }
 
+// Generates the regions with TerrainGenerator::procedural, adding them or replacing the maps of
+// existing regions. Regions are generated one at a time, each using all worker threads.
+void TerrainGeneratorData::generate_regions(const TypedArray<Vector2i> &p_region_locs, const bool p_update) {
+	Ref<TerrainGeneratorProcedural> procedural = _terrain->get_procedural();
+	if (procedural.is_null()) {
+		LOG(ERROR, "TerrainGenerator::procedural is not set");
+		return;
+	}
+	LOG(INFO, "Generating ", p_region_locs.size(), " regions");
+	AABB generated_area;
+	for (int i = 0; i < p_region_locs.size(); i++) {
+		Vector2i region_loc = p_region_locs[i];
+		if (get_region_map_index(region_loc) < 0) {
+			LOG(ERROR, "Location ", region_loc, " out of bounds. Max: ",
+					-REGION_MAP_SIZE / 2, " to ", REGION_MAP_SIZE / 2 - 1);
+			continue;
+		}
+		Ref<TerrainGeneratorRegion> region = get_region(region_loc);
+		bool is_new = region.is_null() || region->is_deleted();
+		if (is_new) {
+			region.instantiate();
+			region->set_location(region_loc);
+			region->set_region_size(_region_size);
+			region->set_vertex_spacing(_vertex_spacing);
+		}
+		if (procedural->generate_region(region) != OK) {
+			continue;
+		}
+		if (is_new && add_region(region, false) != OK) {
+			continue;
+		}
+		update_master_heights(region->get_height_range());
+		Vector2 range = region->get_height_range();
+		real_t size = _region_size * _vertex_spacing;
+		AABB area = AABB(Vector3(region_loc.x * size, range.x, region_loc.y * size), Vector3(size, range.y - range.x, size));
+		generated_area = generated_area.has_surface() ? generated_area.merge(area) : area;
+	}
+	if (p_update && generated_area.has_surface()) {
+		update_maps(TYPE_MAX, true, true);
+		_terrain->get_instancer()->update_mmis(true);
+		add_edited_area(generated_area);
+	}
+}
+
 /** Adds a TerrainGeneratorRegion to the terrain
  * Marks region as modified
  *	p_update - rebuild the maps if true. Set to false if bulk adding many regions.
@@ -316,37 +601,42 @@ void TerrainGeneratorData::save_directory(const String &p_dir) {
 
 // You may need to do a file system scan to update FileSystem panel
 void TerrainGeneratorData::save_region(const Vector2i &p_region_loc, const String &p_dir, const bool p_16_bit) {
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::REGION_IO);
 	Ref<TerrainGeneratorRegion> region = get_region(p_region_loc);
 	if (region.is_null()) {
 		LOG(ERROR, "No region found at: ", p_region_loc);
 		return;
 	}
-	String fname = Util::location_to_filename(p_region_loc);
+	bool tiled = _terrain->get_tiled_region_files();
+	String fname = Util::location_to_filename(p_region_loc, tiled ? TerrainGeneratorRegionFile::EXTENSION : "res");
+	String other_fname = Util::location_to_filename(p_region_loc, tiled ? "res" : TerrainGeneratorRegionFile::EXTENSION);
 	String path = p_dir + String("/") + fname;
 	// If region marked for deletion, remove from disk and from _regions, but don't free in case stored in undo
 	if (region->is_deleted()) {
 		LOG(DEBUG, "Removing ", p_region_loc, " from _regions");
 		_regions.erase(p_region_loc);
+		_stream_files.erase(p_region_loc);
 		LOG(DEBUG, "File to be deleted: ", path);
-		if (!FileAccess::exists(path)) {
+		if (!FileAccess::exists(path) && !FileAccess::exists(p_dir + String("/") + other_fname)) {
 			LOG(INFO, "File to delete ", path, " doesn't exist. (Maybe from add, undo, save)");
 			return;
 		}
-		Ref<DirAccess> da = DirAccess::open(p_dir);
-		if (da.is_null()) {
-			LOG(ERROR, "Cannot open directory for writing: ", p_dir, " error: ", DirAccess::get_open_error());
-			return;
-		}
-		Error err = da->remove(fname);
-		if (err != OK) {
-			LOG(ERROR, "Could not remove file: ", fname, ", error code: ", err);
-		}
-		LOG(INFO, "File ", path, " deleted");
+		_remove_region_file(p_dir, fname);
+		_remove_region_file(p_dir, other_fname);
 		return;
 	}
 	Error err = region->save(path, p_16_bit);
 	if (!(err == OK || err == ERR_SKIP)) {
 		LOG(ERROR, "Could not save file: ", path, ", error: ", VariantUtilityFunctions::error_string(err), " (", err, ")");
+		return;
+	}
+	if (err == OK) {
+		// The region is now in the other format, so the file with the previous format is stale
+		_remove_region_file(p_dir, other_fname);
+	}
+	// Saving clears modified, making the region evictable, so it must be loadable again from here
+	if (is_streaming()) {
+		_stream_files[p_region_loc] = path;
 	}
 }
 
@@ -357,40 +647,41 @@ void TerrainGeneratorData::load_directory(const String &p_dir) {
 	}
 
 	LOG(INFO, "Loading region files from ", p_dir);
-	PackedStringArray files = Util::get_files(p_dir, "TerrainGenerator*.res");
-	if (files.size() == 0) {
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::REGION_IO);
+	std::unordered_map<Vector2i, String, Vector2iHash> files = _get_region_files(p_dir);
+	if (files.empty()) {
 		LOG(INFO, "No TerrainGenerator region files found in: ", p_dir);
 		return;
 	}
 
 	_clear();
-	for (int i = 0; i < files.size(); i++) {
-		String fname = files[i];
-		String path = p_dir + String("/") + fname;
-		LOG(DEBUG, "Loading region from ", path);
-		Vector2i loc = Util::filename_to_location(fname);
-		if (loc.x == INT32_MAX) {
-			LOG(ERROR, "Cannot get region location from file name: ", fname);
-			continue;
+	if (_terrain->get_region_streaming()) {
+		_stream_files = files;
+		LOG(INFO, "Streaming ", _stream_files.size(), " regions from ", p_dir);
+		// Region size is only known from the files, so load one now. The rest stream in
+		// around the targets from update_streaming()
+		const auto &first = *_stream_files.begin();
+		Ref<TerrainGeneratorRegion> region = _load_region_file(first.second);
+		if (_setup_loaded_region(region, first.first, first.second) == OK) {
+			add_region(region, false);
 		}
-		Ref<TerrainGeneratorRegion> region = CoreBind::ResourceLoader::get_singleton()->load(path, "TerrainGeneratorRegion", CoreBind::ResourceLoader::CACHE_MODE_IGNORE);
+		update_maps(TYPE_MAX, true, false);
+		return;
+	}
+
+	for (const auto &it : files) {
+		const Vector2i &loc = it.first;
+		const String &path = it.second;
+		LOG(DEBUG, "Loading region from ", path);
+		Ref<TerrainGeneratorRegion> region = _load_region_file(path);
 		if (region.is_null()) {
 			LOG(ERROR, "Cannot load region at ", path);
 			continue;
 		}
 		LOG(INFO, "Loaded region: ", loc, " size: ", region->get_region_size());
-		if (_regions.is_empty()) {
-			_terrain->set_region_size((TerrainGenerator::RegionSize)region->get_region_size());
-		} else {
-			if (_terrain->get_region_size() != (TerrainGenerator::RegionSize)region->get_region_size()) {
-				LOG(ERROR, "Region size mismatch. First loaded: ", _terrain->get_region_size(), " next: ",
-						region->get_region_size(), " in file: ", path);
-				return;
-			}
+		if (_setup_loaded_region(region, loc, path) != OK) {
+			return;
 		}
-		region->take_over_path(path);
-		region->set_location(loc);
-		region->set_version(CURRENT_VERSION); // Sends upgrade warning if old version
 		add_region(region, false);
 	}
 	update_maps(TYPE_MAX, true, false);
@@ -399,29 +690,187 @@ void TerrainGeneratorData::load_directory(const String &p_dir) {
 //TODO have load_directory call load_region, or make a load_file that loads a specific path
 void TerrainGeneratorData::load_region(const Vector2i &p_region_loc, const String &p_dir, const bool p_update) {
 	LOG(INFO, "Loading region from location ", p_region_loc);
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::REGION_IO);
 	String path = p_dir + String("/") + Util::location_to_filename(p_region_loc);
+	String tiled_path = p_dir + String("/") + Util::location_to_filename(p_region_loc, TerrainGeneratorRegionFile::EXTENSION);
+	bool has_tiled = FileAccess::exists(tiled_path);
+	if (has_tiled && (_terrain->get_tiled_region_files() || !FileAccess::exists(path))) {
+		path = tiled_path;
+	}
 	if (!FileAccess::exists(path)) {
 		LOG(ERROR, "File ", path, " doesn't exist");
 		return;
 	}
-	Ref<TerrainGeneratorRegion> region = CoreBind::ResourceLoader::get_singleton()->load(path, "TerrainGeneratorRegion", CoreBind::ResourceLoader::CACHE_MODE_IGNORE);
-	if (region.is_null()) {
-		LOG(ERROR, "Cannot load region at ", path);
+	Ref<TerrainGeneratorRegion> region = _load_region_file(path);
+	if (_setup_loaded_region(region, p_region_loc, path) != OK) {
 		return;
 	}
-	if (_regions.is_empty()) {
-		_terrain->set_region_size((TerrainGenerator::RegionSize)region->get_region_size());
+	add_region(region, p_update);
+}
+
+/**
+ * Streams regions in and out around the clipmap and collision targets. Called every physics frame
+ * when TerrainGenerator::region_streaming is enabled.
+ * Regions within streaming_distance of either target are queued nearest first and loaded on the
+ * WorkerThreadPool. Finished loads are added here on the main thread, uploading only their own texture
+ * layers. When the resident count would exceed resident_region_budget, the farthest regions outside
+ * streaming_distance are evicted. Modified regions are never evicted so edits aren't lost before saving.
+ * Changes are announced with regions_streamed and the map signals, but not region_map_changed.
+ */
+void TerrainGeneratorData::update_streaming() {
+	if (!is_streaming()) {
+		return;
+	}
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::STREAMING);
+	WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+	bool rebuild = false;
+	TypedArray<Vector2i> loaded;
+	TypedArray<Vector2i> evicted;
+
+	// Add regions finished loading on worker threads
+	for (int i = int(_stream_tasks.size()) - 1; i >= 0; i--) {
+		StreamTask *task = _stream_tasks[i];
+		if (!wtp->is_task_completed(task->task_id)) {
+			continue;
+		}
+		wtp->wait_for_task_completion(task->task_id);
+		_stream_tasks[i] = _stream_tasks.back();
+		_stream_tasks.pop_back();
+		_stream_latency_usec = (_stream_latency_usec == 0) ? task->load_usec : (_stream_latency_usec * 7 + task->load_usec) / 8;
+		if (task->region.is_null()) {
+			LOG(ERROR, "Cannot load region at ", task->path, ". Removing from streaming");
+			_stream_files.erase(task->location);
+		} else if (get_region_map_index(task->location) < 0) {
+			LOG(ERROR, "Region ", task->location, " in ", task->path, " is outside of the region map. Removing from streaming");
+			_stream_files.erase(task->location);
+		} else if (_regions.has(task->location)) {
+			// Includes regions deleted but not yet saved, which must not come back
+			LOG(DEBUG, "Region ", task->location, " was added or deleted while loading. Discarding streamed copy");
+		} else if (_setup_loaded_region(task->region, task->location, task->path) == OK) {
+			LOG(DEBUG, "Streamed in region ", task->location, " in ", task->load_usec, " us");
+			rebuild = !_stream_in(task->region) || rebuild;
+			loaded.push_back(task->location);
+			_stream_loaded_count++;
+		}
+		memdelete(task);
+	}
+
+	// Rebuild the queue when the targets enter a new region
+	const int distance = _terrain->get_streaming_distance();
+	Vector2i center = get_region_location(_terrain->get_clipmap_target_position());
+	Vector2i center2 = get_region_location(_terrain->get_collision_target_position());
+	auto get_distance = [&](const Vector2i &p_loc) -> int {
+		Vector2i d1 = (p_loc - center).abs();
+		Vector2i d2 = (p_loc - center2).abs();
+		return MIN(MAX(d1.x, d1.y), MAX(d2.x, d2.y));
+	};
+	if (center != _stream_center || center2 != _stream_center2 || !loaded.is_empty()) {
+		_stream_center = center;
+		_stream_center2 = center2;
+		_stream_queue.clear();
+		for (const auto &it : _stream_files) {
+			const Vector2i &loc = it.first;
+			if (get_distance(loc) > distance || _regions.has(loc) || get_region_map_index(loc) < 0) {
+				continue;
+			}
+			bool in_flight = false;
+			for (const StreamTask *task : _stream_tasks) {
+				in_flight = in_flight || task->location == loc;
+			}
+			if (!in_flight) {
+				_stream_queue.push_back(loc);
+			}
+		}
+		std::sort(_stream_queue.begin(), _stream_queue.end(), [&](const Vector2i &a, const Vector2i &b) {
+			return get_distance(a) > get_distance(b);
+		});
+	}
+
+	// Evict the farthest regions outside of the streaming distance to make room
+	const int budget = _terrain->get_resident_region_budget();
+	int resident = _region_locations.size() + _stream_tasks.size();
+	int excess = resident + MIN(int(_stream_queue.size()), MAX_STREAM_TASKS) - budget;
+	if (excess > 0) {
+		std::vector<Vector2i> candidates;
+		for (int i = 0; i < _region_locations.size(); i++) {
+			Vector2i loc = _region_locations[i];
+			TerrainGeneratorRegion *region = get_region_ptr(loc);
+			// Only regions with a file on disk can stream back in
+			if (region && !region->is_modified() && !region->is_edited() && get_distance(loc) > distance &&
+					_stream_files.count(loc)) {
+				candidates.push_back(loc);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [&](const Vector2i &a, const Vector2i &b) {
+			return get_distance(a) > get_distance(b);
+		});
+		for (int i = 0; i < MIN(excess, int(candidates.size())); i++) {
+			LOG(DEBUG, "Evicting region ", candidates[i]);
+			rebuild = !_stream_out(candidates[i]) || rebuild;
+			evicted.push_back(candidates[i]);
+			_stream_evicted_count++;
+			resident--;
+		}
+	}
+
+	// Start loading the nearest queued regions
+	while (!_stream_queue.empty() && int(_stream_tasks.size()) < MAX_STREAM_TASKS && resident < budget) {
+		StreamTask *task = memnew(StreamTask);
+		task->location = _stream_queue.back();
+		task->path = _stream_files[task->location];
+		task->start_usec = Time::get_singleton()->get_ticks_usec();
+		_stream_queue.pop_back();
+		LOG(DEBUG, "Queueing region ", task->location, " for loading from ", task->path);
+		task->task_id = wtp->add_template_task(this, &TerrainGeneratorData::_stream_load_task, task, false, "TerrainGenerator region load");
+		_stream_tasks.push_back(task);
+		resident++;
+	}
+
+	if (loaded.is_empty() && evicted.is_empty()) {
+		return;
+	}
+	if (!evicted.is_empty()) {
+		calc_height_range();
+	}
+	// Emits regions_streamed rather than region_map_changed, so collision and baked tiles are only
+	// dropped over the streamed regions instead of everywhere
+	if (rebuild) {
+		LOG(DEBUG, "Texture arrays out of capacity or out of sync. Rebuilding");
+		_streaming_update = true;
+		update_maps(TYPE_MAX, true, false);
+		_streaming_update = false;
 	} else {
-		if (_terrain->get_region_size() != (TerrainGenerator::RegionSize)region->get_region_size()) {
-			LOG(ERROR, "Region size mismatch. First loaded: ", _terrain->get_region_size(), " next: ",
-					region->get_region_size(), " in file: ", path);
-			return;
+		emit_signal("height_maps_changed");
+		emit_signal("control_maps_changed");
+		emit_signal("color_maps_changed");
+		emit_signal("maps_changed");
+	}
+	emit_signal("regions_streamed", loaded, evicted);
+	for (int i = 0; i < loaded.size(); i++) {
+		_terrain->get_instancer()->_update_mmis(Vector2i(loaded[i]));
+		emit_signal("region_loaded", loaded[i]);
+	}
+	for (int i = 0; i < evicted.size(); i++) {
+		emit_signal("region_evicted", evicted[i]);
+	}
+}
+
+// Returns the memory used by the maps of all active regions
+int64_t TerrainGeneratorData::get_resident_bytes() const {
+	int64_t bytes = 0;
+	for (int i = 0; i < _region_locations.size(); i++) {
+		TerrainGeneratorRegion *region = get_region_ptr(Vector2i(_region_locations[i]));
+		if (!region) {
+			continue;
+		}
+		for (int t = 0; t < TYPE_MAX; t++) {
+			Image *map = region->get_map_ptr(MapType(t));
+			if (map) {
+				bytes += map->get_data_size();
+			}
 		}
 	}
-	region->take_over_path(path);
-	region->set_location(p_region_loc);
-	region->set_version(CURRENT_VERSION); // Sends upgrade warning if old version
-	add_region(region, p_update);
+	return bytes;
 }
 
 TypedArray<Image> TerrainGeneratorData::get_maps(const MapType p_map_type) const {
@@ -446,6 +895,7 @@ TypedArray<Image> TerrainGeneratorData::get_maps(const MapType p_map_type) const
 }
 
 void TerrainGeneratorData::update_maps(const MapType p_map_type, const bool p_all_regions, const bool p_generate_mipmaps) {
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::UPDATE_MAPS);
 	// Generate region color mipmaps
 	if (p_generate_mipmaps && (p_map_type == TYPE_COLOR || p_map_type == TYPE_MAX)) {
 		LOG(EXTREME, "Regenerating color mipmaps");
@@ -505,7 +955,9 @@ void TerrainGeneratorData::update_maps(const MapType p_map_type, const bool p_al
 			}
 		}
 		any_changed = true;
-		emit_signal("region_map_changed");
+		if (!_streaming_update) {
+			emit_signal("region_map_changed");
+		}
 	}
 
 	// Rebuild height maps if dirty
@@ -523,7 +975,7 @@ void TerrainGeneratorData::update_maps(const MapType p_map_type, const bool p_al
 				return;
 			}
 		}
-		_generated_height_maps.create(_height_maps);
+		_generated_height_maps.create(_height_maps, _get_layer_capacity());
 		calc_height_range();
 		any_changed = true;
 		emit_signal("height_maps_changed");
@@ -540,7 +992,7 @@ void TerrainGeneratorData::update_maps(const MapType p_map_type, const bool p_al
 				_control_maps.push_back(region->get_control_map());
 			}
 		}
-		_generated_control_maps.create(_control_maps);
+		_generated_control_maps.create(_control_maps, _get_layer_capacity());
 		any_changed = true;
 		emit_signal("control_maps_changed");
 	}
@@ -556,7 +1008,7 @@ void TerrainGeneratorData::update_maps(const MapType p_map_type, const bool p_al
 				_color_maps.push_back(region->get_color_map());
 			}
 		}
-		_generated_color_maps.create(_color_maps);
+		_generated_color_maps.create(_color_maps, _get_layer_capacity());
 		any_changed = true;
 		emit_signal("color_maps_changed");
 	}
@@ -564,35 +1016,28 @@ void TerrainGeneratorData::update_maps(const MapType p_map_type, const bool p_al
 	// If no maps have been rebuilt, update only individual regions in the array.
 	// Regions marked Edited have been changed by TerrainGeneratorEditor::_operate_map or undo / redo processing.
 	if (!any_changed) {
+		bool updated[TYPE_MAX] = { false, false, false };
 		for (int i = 0; i < _region_locations.size(); i++) {
 			Vector2i region_loc = _region_locations[i];
 			TerrainGeneratorRegion *region = get_region_ptr(region_loc);
 			if (region && region->is_edited()) {
 				int region_id = get_region_id(region_loc);
-				switch (p_map_type) {
-					case TYPE_HEIGHT:
-						_generated_height_maps.update(region->get_height_map(), region_id);
-						emit_signal("height_maps_changed");
-						break;
-					case TYPE_CONTROL:
-						_generated_control_maps.update(region->get_control_map(), region_id);
-						emit_signal("control_maps_changed");
-						break;
-					case TYPE_COLOR:
-						_generated_color_maps.update(region->get_color_map(), region_id);
-						emit_signal("color_maps_changed");
-						break;
-					default:
-						_generated_height_maps.update(region->get_height_map(), region_id);
-						_generated_control_maps.update(region->get_control_map(), region_id);
-						_generated_color_maps.update(region->get_color_map(), region_id);
-						emit_signal("height_maps_changed");
-						emit_signal("control_maps_changed");
-						emit_signal("color_maps_changed");
-						break;
+				for (int m = 0; m < TYPE_MAX; m++) {
+					if (p_map_type == TYPE_MAX || p_map_type == m) {
+						updated[m] = _update_layer(region, MapType(m), region_id) || updated[m];
+					}
 				}
 			}
 		}
+		if (updated[TYPE_HEIGHT]) {
+			emit_signal("height_maps_changed");
+		}
+		if (updated[TYPE_CONTROL]) {
+			emit_signal("control_maps_changed");
+		}
+		if (updated[TYPE_COLOR]) {
+			emit_signal("color_maps_changed");
+		}
 	}
 	emit_signal("maps_changed");
 }
@@ -620,6 +1065,7 @@ void TerrainGeneratorData::set_pixel(const MapType p_map_type, const Vector3 &p_
 	if (map) {
 		map->set_pixelv(img_pos, p_pixel);
 		region->set_modified(true);
+		region->add_dirty_area(Rect2i(img_pos, Vector2i(1, 1)));
 	}
 }
 
@@ -686,6 +1132,42 @@ Vector3 TerrainGeneratorData::get_normal(const Vector3 &p_global_position) const
 	return normal;
 }
 
+// Returns a snapshot of the current maps for repeated bulk queries, which may run on any thread
+Ref<TerrainGeneratorMapSnapshot> TerrainGeneratorData::get_map_snapshot() const {
+	Ref<TerrainGeneratorMapSnapshot> snapshot;
+	snapshot.instantiate();
+	snapshot->update(this);
+	return snapshot;
+}
+
+/**
+ * Bulk versions of get_height(), get_normal() and get_control() for many positions at once.
+ * The maps are read directly through a MapSnapshot, avoiding the per call region lookup and Color
+ * conversion of get_pixel(). Each call creates a new snapshot, so for repeated queries or queries
+ * from other threads, get one with get_map_snapshot() on the main thread and reuse it.
+ * get_controls() returns the control bits as ints; -1 (UINT32_MAX) where there is no region.
+ */
+PackedRealArray TerrainGeneratorData::get_heights(const PackedVector3Array &p_global_positions) const {
+	PackedRealArray heights;
+	heights.resize(p_global_positions.size());
+	MapSnapshot(this).get_heights(p_global_positions.ptr(), heights.ptrw(), p_global_positions.size());
+	return heights;
+}
+
+PackedVector3Array TerrainGeneratorData::get_normals(const PackedVector3Array &p_global_positions) const {
+	PackedVector3Array normals;
+	normals.resize(p_global_positions.size());
+	MapSnapshot(this).get_normals(p_global_positions.ptr(), normals.ptrw(), p_global_positions.size());
+	return normals;
+}
+
+PackedInt32Array TerrainGeneratorData::get_controls(const PackedVector3Array &p_global_positions) const {
+	PackedInt32Array controls;
+	controls.resize(p_global_positions.size());
+	MapSnapshot(this).get_controls(p_global_positions.ptr(), reinterpret_cast<uint32_t *>(controls.ptrw()), p_global_positions.size());
+	return controls;
+}
+
 bool TerrainGeneratorData::is_in_slope(const Vector3 &p_global_position, const Vector2 &p_slope_range, const bool p_invert) const {
 	// If slope is full range, it's disabled
 	const Vector2 slope_range = CLAMP(p_slope_range, V2_ZERO, Vector2(90.f, 90.f));
@@ -818,6 +1300,22 @@ void TerrainGeneratorData::add_edited_area(const AABB &p_area) {
 	} else {
 		_edited_area = p_area;
 	}
+	// Mark the region tiles under the area for partial saves, with a pixel margin for rounding
+	if (_region_size > 0) {
+		Vector2i start = Vector2i(Math::floor(p_area.position.x / _vertex_spacing), Math::floor(p_area.position.z / _vertex_spacing)) - Vector2i(1, 1);
+		Vector2i end = Vector2i(Math::ceil(p_area.get_end().x / _vertex_spacing), Math::ceil(p_area.get_end().z / _vertex_spacing)) + Vector2i(1, 1);
+		Vector2i start_loc = V2I_DIVIDE_FLOOR(start, _region_size).maxi(-REGION_MAP_SIZE / 2);
+		Vector2i end_loc = V2I_DIVIDE_FLOOR(end, _region_size).mini(REGION_MAP_SIZE / 2 - 1);
+		for (int y = start_loc.y; y <= end_loc.y; y++) {
+			for (int x = start_loc.x; x <= end_loc.x; x++) {
+				TerrainGeneratorRegion *region = get_region_ptr(Vector2i(x, y));
+				if (region) {
+					Vector2i offset = Vector2i(x, y) * _region_size;
+					region->add_dirty_area(Rect2i(start - offset, end - start + Vector2i(1, 1)));
+				}
+			}
+		}
+	}
 	emit_signal("maps_edited", p_area);
 }
 
@@ -1158,6 +1656,7 @@ void TerrainGeneratorData::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("add_region_blankp", "global_position", "update"), &TerrainGeneratorData::add_region_blankp, DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("add_region_blank", "region_location", "update"), &TerrainGeneratorData::add_region_blank, DEFVAL(true));
+	ClassDB::bind_method(D_METHOD("generate_regions", "region_locations", "update"), &TerrainGeneratorData::generate_regions, DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("add_region", "region", "update"), &TerrainGeneratorData::add_region, DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("remove_regionp", "global_position", "update"), &TerrainGeneratorData::remove_regionp, DEFVAL(true));
 	ClassDB::bind_method(D_METHOD("remove_regionl", "region_location", "update"), &TerrainGeneratorData::remove_regionl, DEFVAL(true));
@@ -1168,6 +1667,14 @@ void TerrainGeneratorData::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("load_directory", "directory"), &TerrainGeneratorData::load_directory);
 	ClassDB::bind_method(D_METHOD("load_region", "region_location", "directory", "update"), &TerrainGeneratorData::load_region, DEFVAL(true));
 
+	ClassDB::bind_method(D_METHOD("update_streaming"), &TerrainGeneratorData::update_streaming);
+	ClassDB::bind_method(D_METHOD("is_streaming"), &TerrainGeneratorData::is_streaming);
+	ClassDB::bind_method(D_METHOD("get_streaming_queue_size"), &TerrainGeneratorData::get_streaming_queue_size);
+	ClassDB::bind_method(D_METHOD("get_streaming_load_latency"), &TerrainGeneratorData::get_streaming_load_latency);
+	ClassDB::bind_method(D_METHOD("get_streaming_loaded_count"), &TerrainGeneratorData::get_streaming_loaded_count);
+	ClassDB::bind_method(D_METHOD("get_streaming_evicted_count"), &TerrainGeneratorData::get_streaming_evicted_count);
+	ClassDB::bind_method(D_METHOD("get_resident_bytes"), &TerrainGeneratorData::get_resident_bytes);
+
 	ClassDB::bind_method(D_METHOD("get_height_maps"), &TerrainGeneratorData::get_height_maps);
 	ClassDB::bind_method(D_METHOD("get_control_maps"), &TerrainGeneratorData::get_control_maps);
 	ClassDB::bind_method(D_METHOD("get_color_maps"), &TerrainGeneratorData::get_color_maps);
@@ -1206,6 +1713,10 @@ void TerrainGeneratorData::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_control_auto", "global_position"), &TerrainGeneratorData::get_control_auto);
 
 	ClassDB::bind_method(D_METHOD("get_normal", "global_position"), &TerrainGeneratorData::get_normal);
+	ClassDB::bind_method(D_METHOD("get_map_snapshot"), &TerrainGeneratorData::get_map_snapshot);
+	ClassDB::bind_method(D_METHOD("get_heights", "global_positions"), &TerrainGeneratorData::get_heights);
+	ClassDB::bind_method(D_METHOD("get_normals", "global_positions"), &TerrainGeneratorData::get_normals);
+	ClassDB::bind_method(D_METHOD("get_controls", "global_positions"), &TerrainGeneratorData::get_controls);
 	ClassDB::bind_method(D_METHOD("is_in_slope", "global_position", "slope_range", "invert"), &TerrainGeneratorData::is_in_slope, DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("get_texture_id", "global_position"), &TerrainGeneratorData::get_texture_id);
 	ClassDB::bind_method(D_METHOD("get_mesh_vertex", "lod", "filter", "global_position"), &TerrainGeneratorData::get_mesh_vertex);
@@ -1229,4 +1740,8 @@ void TerrainGeneratorData::_bind_methods() {
 	ADD_SIGNAL(MethodInfo("control_maps_changed"));
 	ADD_SIGNAL(MethodInfo("color_maps_changed"));
 	ADD_SIGNAL(MethodInfo("maps_edited", PropertyInfo(Variant::AABB, "edited_area")));
+	ADD_SIGNAL(MethodInfo("regions_streamed", PropertyInfo(Variant::ARRAY, "loaded_locations", PROPERTY_HINT_ARRAY_TYPE, "Vector2i"),
+			PropertyInfo(Variant::ARRAY, "evicted_locations", PROPERTY_HINT_ARRAY_TYPE, "Vector2i")));
+	ADD_SIGNAL(MethodInfo("region_loaded", PropertyInfo(Variant::VECTOR2I, "region_location")));
+	ADD_SIGNAL(MethodInfo("region_evicted", PropertyInfo(Variant::VECTOR2I, "region_location")));
 }
@@ -2,9 +2,15 @@
 
 #pragma once
 
+#include <godot/core/object/worker_thread_pool.h>
+#include <unordered_map>
+#include <vector>
+
 #include "constants.h"
 #include "generated_texture.h"
+#include "map_snapshot.h"
 #include "terrain_generator.h"
+#include "terrain_generator_procedural.h"
 #include "terrain_generator_region.h"
 
 class TerrainGenerator;
@@ -13,11 +19,14 @@ class TerrainGeneratorData : public Object {
 	GDCLASS(TerrainGeneratorData, Object);
 	CLASS_NAME();
 	friend TerrainGenerator;
+	friend MapSnapshot;
 
 public: // Constants
-	static inline const real_t CURRENT_VERSION = 0.93f;
+	static inline const real_t CURRENT_VERSION = 0.94f;
 	static inline const int REGION_MAP_SIZE = 32;
 	static inline const Vector2i REGION_MAP_VSIZE = Vector2i(REGION_MAP_SIZE, REGION_MAP_SIZE);
+	static inline const int MAX_STREAM_TASKS = 4;
+	static inline const int MIN_SPARE_LAYERS = MAX_STREAM_TASKS; // Texture array layers added when streaming runs out
 
 	enum HeightFilter {
 		HEIGHT_FILTER_NEAREST,
@@ -67,14 +76,47 @@ private:
 	// 32x32 grid with region_id:int at its location, no region = 0, region_ids >= 1
 	PackedInt32Array _region_map;
 	bool _region_map_dirty = true;
+	bool _streaming_update = false; // Set while update_streaming() rebuilds, which emits regions_streamed instead of region_map_changed
 
 	// These contain the TextureArray RIDs from the RenderingServer
 	GeneratedTexture _generated_height_maps;
 	GeneratedTexture _generated_control_maps;
 	GeneratedTexture _generated_color_maps;
 
+	// Streaming
+	// With TerrainGenerator::region_streaming enabled, load_directory() only indexes the region files.
+	// update_streaming() then loads regions on the WorkerThreadPool around the clipmap and collision
+	// targets, and evicts the farthest unmodified regions once resident_region_budget is exceeded.
+	struct StreamTask {
+		Vector2i location;
+		String path;
+		Ref<TerrainGeneratorRegion> region; // Written by the worker thread
+		uint64_t start_usec = 0;
+		uint64_t load_usec = 0;
+		WorkerThreadPool::TaskID task_id = WorkerThreadPool::INVALID_TASK_ID;
+	};
+	std::unordered_map<Vector2i, String, Vector2iHash> _stream_files; // Region files on disk by location
+	std::vector<Vector2i> _stream_queue; // Locations waiting for a task, nearest last
+	std::vector<StreamTask *> _stream_tasks; // In flight on the WorkerThreadPool
+	Vector2i _stream_center = V2I_MAX;
+	Vector2i _stream_center2 = V2I_MAX;
+	uint64_t _stream_latency_usec = 0; // Running average of worker load time
+	uint64_t _stream_loaded_count = 0;
+	uint64_t _stream_evicted_count = 0;
+
 	// Functions
 	void _clear();
+	Error _setup_loaded_region(const Ref<TerrainGeneratorRegion> &p_region, const Vector2i &p_region_loc, const String &p_path);
+	Ref<TerrainGeneratorRegion> _load_region_file(const String &p_path, const bool p_parallel = true) const;
+	std::unordered_map<Vector2i, String, Vector2iHash> _get_region_files(const String &p_dir) const;
+	void _remove_region_file(const String &p_dir, const String &p_fname) const;
+	bool _update_layer(TerrainGeneratorRegion *p_region, const MapType p_map_type, const int p_layer);
+	bool _are_layers_valid() const;
+	int _get_layer_capacity() const;
+	void _stream_load_task(StreamTask *p_task);
+	void _stop_streaming();
+	bool _stream_in(const Ref<TerrainGeneratorRegion> &p_region);
+	bool _stream_out(const Vector2i &p_region_loc);
 	void _copy_paste_dfr(const TerrainGeneratorRegion *p_src_region, const Rect2i &p_src_rect, const Rect2i &p_dst_rect, const TerrainGeneratorRegion *p_dst_region);
 
 public:
@@ -106,6 +148,7 @@ public:
 	template <typename T> // Catch invalid types. See note below in implementation.
 	TerrainGeneratorRegion *get_region_ptr(const T &p_region_loc) const = delete;
 	Ref<TerrainGeneratorRegion> get_regionp(const Vector3 &p_global_position) const;
+	uint64_t get_map_generation(const Rect2i &p_area) const;
 
 	void set_region_modified(const Vector2i &p_region_loc, const bool p_modified = true);
 	bool is_region_modified(const Vector2i &p_region_loc) const;
@@ -115,6 +158,7 @@ public:
 	Ref<TerrainGeneratorRegion> add_region_blankp(const Vector3 &p_global_position, const bool p_update = true);
 	Ref<TerrainGeneratorRegion> add_region_blank(const Vector2i &p_region_loc, const bool p_update = true);
 	Error add_region(const Ref<TerrainGeneratorRegion> &p_region, const bool p_update = true);
+	void generate_regions(const TypedArray<Vector2i> &p_region_locs, const bool p_update = true);
 	void remove_regionp(const Vector3 &p_global_position, const bool p_update = true);
 	void remove_regionl(const Vector2i &p_region_loc, const bool p_update = true);
 	void remove_region(const Ref<TerrainGeneratorRegion> &p_region, const bool p_update = true);
@@ -125,6 +169,15 @@ public:
 	void load_directory(const String &p_dir);
 	void load_region(const Vector2i &p_region_loc, const String &p_dir, const bool p_update = true);
 
+	// Streaming
+	void update_streaming();
+	bool is_streaming() const { return !_stream_files.empty(); }
+	int get_streaming_queue_size() const { return _stream_queue.size() + _stream_tasks.size(); }
+	int64_t get_streaming_load_latency() const { return _stream_latency_usec; }
+	int get_streaming_loaded_count() const { return _stream_loaded_count; }
+	int get_streaming_evicted_count() const { return _stream_evicted_count; }
+	int64_t get_resident_bytes() const;
+
 	// Maps
 	TypedArray<Image> get_height_maps() const { return _height_maps; }
 	TypedArray<Image> get_control_maps() const { return _control_maps; }
@@ -165,6 +218,10 @@ public:
 	bool get_control_auto(const Vector3 &p_global_position) const;
 
 	Vector3 get_normal(const Vector3 &p_global_position) const;
+	Ref<TerrainGeneratorMapSnapshot> get_map_snapshot() const;
+	PackedRealArray get_heights(const PackedVector3Array &p_global_positions) const;
+	PackedVector3Array get_normals(const PackedVector3Array &p_global_positions) const;
+	PackedInt32Array get_controls(const PackedVector3Array &p_global_positions) const;
 	bool is_in_slope(const Vector3 &p_global_position, const Vector2 &p_slope_range, const bool p_invert = false) const;
 	Vector3 get_texture_id(const Vector3 &p_global_position) const;
 	Vector3 get_mesh_vertex(const int32_t p_lod, const HeightFilter p_filter, const Vector3 &p_global_position) const;
@@ -182,6 +182,8 @@ void TerrainGeneratorEditor::_operate_map(const Vector3 &p_global_position, cons
 	// rebuild at the end of the last _operate() call, but until painting is finished we only
 	// need to track if _added_removed_locations has changed between now and the end of the loop
 	int regions_added_removed = _added_removed_locations.size();
+	// Map pixels changed by this operation in each region, for partial texture and mipmap updates
+	std::unordered_map<Vector2i, Rect2i, Vector2iHash> updated_areas;
 
 	for (real_t x = 0.f; x < brush_size; x += vertex_spacing) {
 		for (real_t y = 0.f; y < brush_size; y += vertex_spacing) {
@@ -318,8 +320,6 @@ void TerrainGeneratorEditor::_operate_map(const Vector3 &p_global_position, cons
 						break;
 				}
 				dest = Color(destf, 0.f, 0.f, 1.f);
-				region->update_height(destf);
-				data->update_master_height(destf);
 				edited_position.y = destf;
 				edited_area = edited_area.expand(edited_position);
 
@@ -523,18 +523,31 @@ void TerrainGeneratorEditor::_operate_map(const Vector3 &p_global_position, cons
 						break;
 				}
 			}
-			backup_region(region);
+			_backup_tile(region.ptr(), map_type, map_pixel_position);
 			map->set_pixelv(map_pixel_position, dest);
+			if (map_type == TYPE_HEIGHT) {
+				region->update_height(dest.r);
+				data->update_master_height(dest.r);
+			}
+			Rect2i pixel_area = Rect2i(map_pixel_position, Vector2i(1, 1));
+			auto area = updated_areas.find(region_loc);
+			if (area == updated_areas.end()) {
+				updated_areas[region_loc] = pixel_area;
+			} else {
+				area->second = area->second.merge(pixel_area);
+			}
 		}
 	}
-	// Regenerate color mipmaps for edited regions
-	if (map_type == TYPE_COLOR) {
-		for (int i = 0; i < _edited_regions.size(); i++) {
-			Ref<TerrainGeneratorRegion> region = _edited_regions[i];
-			if (region.is_valid()) {
-				region->get_map(map_type)->generate_mipmaps();
-			}
+	// Queue the changed areas for texture array updates, regenerating color mipmaps only over them
+	for (const auto &it : updated_areas) {
+		TerrainGeneratorRegion *region = data->get_region_ptr(it.first);
+		if (!region) {
+			continue;
+		}
+		if (map_type == TYPE_COLOR) {
+			Util::update_mipmaps(region->get_color_map(), it.second);
 		}
+		region->add_update_area(map_type, it.second);
 	}
 	// If no added or removed regions, update only changed texture array layers from the edited regions in the rendering server
 	if (_added_removed_locations.size() == regions_added_removed) {
@@ -548,10 +561,25 @@ void TerrainGeneratorEditor::_operate_map(const Vector3 &p_global_position, cons
 	if (_tool == HOLES || _tool == HEIGHT || _tool == SCULPT) {
 		_terrain->get_instancer()->update_transforms(edited_area);
 	}
-	// Update Dynamic / Editor collision
+	// Update Dynamic / Editor collision. Shapes in edited_area were invalidated by maps_edited
 	if (_terrain->get_collision_mode() == TerrainGeneratorCollision::DYNAMIC_EDITOR) {
-		_terrain->get_collision()->update(true);
+		_terrain->get_collision()->update();
+	}
+}
+
+// Marks the region edited on first touch, and copies the map tile containing the pixel for undo
+void TerrainGeneratorEditor::_backup_tile(TerrainGeneratorRegion *p_region, const MapType p_map_type, const Vector2i &p_pixel) {
+	if (!p_region->is_edited()) {
+		LOG(DEBUG, "Storing undo data for region: ", p_region->get_location());
+		Ref<TerrainGeneratorRegion> region(p_region);
+		if (!_edited_regions.has(region)) {
+			_edited_regions.push_back(region);
+		}
+		p_region->set_edited(true);
+		p_region->set_modified(true);
+		_undo_delta->capture_region(p_region, false);
 	}
+	_undo_delta->capture_tile(p_region, p_map_type, p_pixel);
 }
 
 void TerrainGeneratorEditor::_store_undo() {
@@ -563,9 +591,15 @@ void TerrainGeneratorEditor::_store_undo() {
 	Dictionary redo_data;
 	// Store current locations; Original backed up in start_operation()
 	redo_data["region_locations"] = _terrain->get_data()->get_region_locations().duplicate();
-	// Store original and current backups of edited regions
+	// Store removed regions for undo, and edited or added regions for redo
 	_undo_data["edited_regions"] = _original_regions;
 	redo_data["edited_regions"] = _edited_regions;
+	// Store the changed map tiles and instances, shared by undo and redo
+	if (_undo_delta.is_valid() && !_undo_delta->is_empty()) {
+		_undo_data["delta"] = _undo_delta;
+		redo_data["delta"] = _undo_delta;
+		redo_data["redo"] = true;
+	}
 
 	// Store regions that were removed or added
 	if (_added_removed_locations.size() > 0) {
@@ -629,6 +663,12 @@ void TerrainGeneratorEditor::_apply_undo(const Dictionary &p_data) {
 		}
 	}
 
+	Ref<TerrainGeneratorUndoDelta> delta = p_data.get("delta", Variant());
+	if (delta.is_valid()) {
+		LOG(DEBUG, "Applying ", delta->get_tile_count(), " map tiles");
+		delta->apply(data, p_data.get("redo", false));
+	}
+
 	if (p_data.has("edited_area")) {
 		LOG(DEBUG, "Edited area: ", p_data["edited_area"]);
 		data->add_edited_area(p_data["edited_area"]);
@@ -683,6 +723,14 @@ void TerrainGeneratorEditor::_apply_undo(const Dictionary &p_data) {
 			}
 		}
 	}
+	if (delta.is_valid()) {
+		for (const Vector2i &region_loc : delta->get_region_locations()) {
+			TerrainGeneratorRegion *region = data->get_region_ptr(region_loc);
+			if (region) {
+				region->set_edited(false);
+			}
+		}
+	}
 	_terrain->get_instancer()->update_mmis(true);
 	if (_terrain->get_plugin()->has_method("update_grid")) {
 		LOG(DEBUG, "Calling GDScript update_grid()");
@@ -690,6 +738,35 @@ void TerrainGeneratorEditor::_apply_undo(const Dictionary &p_data) {
 	}
 }
 
+// Expires the oldest deltas once the undo history exceeds TerrainGenerator::undo_memory_budget.
+// Deltas freed by the undo manager, eg. when the redo branch is discarded, are dropped. The newest
+// delta is always kept.
+void TerrainGeneratorEditor::_trim_undo_history() {
+	std::deque<ObjectID> history;
+	for (const ObjectID &id : _undo_history) {
+		if (ObjectDB::get_instance(id)) {
+			history.push_back(id);
+		}
+	}
+	_undo_history.swap(history);
+	uint64_t budget = uint64_t(_terrain->get_undo_memory_budget()) * 1024 * 1024;
+	uint64_t bytes = 0;
+	int keep = 0;
+	for (auto it = _undo_history.rbegin(); it != _undo_history.rend(); ++it, keep++) {
+		TerrainGeneratorUndoDelta *delta = Object::cast_to<TerrainGeneratorUndoDelta>(ObjectDB::get_instance(*it));
+		bytes += delta->get_bytes();
+		if (keep > 0 && bytes > budget) {
+			break;
+		}
+	}
+	while (int(_undo_history.size()) > keep) {
+		TerrainGeneratorUndoDelta *delta = Object::cast_to<TerrainGeneratorUndoDelta>(ObjectDB::get_instance(_undo_history.front()));
+		LOG(INFO, "Undo history exceeds ", _terrain->get_undo_memory_budget(), " MB, discarding oldest undo data");
+		delta->expire();
+		_undo_history.pop_front();
+	}
+}
+
 ///////////////////////////
 // Public Functions
 ///////////////////////////
@@ -778,6 +855,7 @@ void TerrainGeneratorEditor::start_operation(const Vector3 &p_global_position) {
 	_original_regions = TypedArray<TerrainGeneratorRegion>(); // New pointers instead of clear
 	_edited_regions = TypedArray<TerrainGeneratorRegion>();
 	_added_removed_locations = TypedArray<Vector2i>();
+	_undo_delta.instantiate();
 	// Reset counter at start to ensure first click places an instance
 	_terrain->get_instancer()->reset_density_counter();
 	_terrain->get_data()->clear_edited_area();
@@ -814,15 +892,37 @@ void TerrainGeneratorEditor::operate(const Vector3 &p_global_position, const rea
 	}
 }
 
+// Stores the whole region for undo before it is changed: instances, height range and every map tile
 void TerrainGeneratorEditor::backup_region(const Ref<TerrainGeneratorRegion> &p_region) {
-	// Backup region once at the start of an operation. Once Edited is set, this is skipped
-	if (_is_operating && p_region.is_valid() && !p_region->is_edited()) {
-		LOG(DEBUG, "Storing original copy of region: ", p_region->get_location());
-		_original_regions.push_back(p_region->duplicate(true));
-		_edited_regions.push_back(p_region);
+	if (!_is_operating || p_region.is_null() || _undo_delta.is_null()) {
+		return;
+	}
+	backup_region_instances(p_region);
+	int region_size = p_region->get_region_size();
+	for (int m = 0; m < TYPE_MAX; m++) {
+		for (int y = 0; y < region_size; y += TerrainGeneratorUndoDelta::TILE_SIZE) {
+			for (int x = 0; x < region_size; x += TerrainGeneratorUndoDelta::TILE_SIZE) {
+				_undo_delta->capture_tile(p_region.ptr(), MapType(m), Vector2i(x, y));
+			}
+		}
+	}
+}
+
+// Stores only the region instances and height range for undo, before they are changed. Cheaper than
+// backup_region() for edits that don't touch the maps.
+void TerrainGeneratorEditor::backup_region_instances(const Ref<TerrainGeneratorRegion> &p_region) {
+	if (!_is_operating || p_region.is_null() || _undo_delta.is_null()) {
+		return;
+	}
+	if (!p_region->is_edited()) {
+		LOG(DEBUG, "Storing undo data for region: ", p_region->get_location());
+		if (!_edited_regions.has(p_region)) {
+			_edited_regions.push_back(p_region);
+		}
 		p_region->set_edited(true);
 		p_region->set_modified(true);
 	}
+	_undo_delta->capture_region(p_region.ptr(), true);
 }
 
 // Called on left mouse button released
@@ -835,12 +935,16 @@ void TerrainGeneratorEditor::stop_operation() {
 		for (int i = 0; i < _edited_regions.size(); i++) {
 			Ref<TerrainGeneratorRegion> region = _edited_regions[i];
 			region->set_edited(false);
-			// Make duplicate for redo backup
-			_edited_regions[i] = region->duplicate(true);
+		}
+		if (_undo_delta.is_valid()) {
+			_undo_delta->finish(_terrain->get_data());
+			_undo_history.push_back(_undo_delta->get_instance_id());
 		}
 		_store_undo();
+		_trim_undo_history();
 	}
 	_undo_data.clear();
+	_undo_delta.unref();
 	_original_regions = TypedArray<TerrainGeneratorRegion>(); //New pointers instead of clear
 	_edited_regions = TypedArray<TerrainGeneratorRegion>();
 	_added_removed_locations = TypedArray<Vector2i>();
@@ -848,6 +952,18 @@ void TerrainGeneratorEditor::stop_operation() {
 	_is_operating = false;
 }
 
+// Total memory used by undo data still held by the undo manager
+uint64_t TerrainGeneratorEditor::get_undo_bytes() const {
+	uint64_t bytes = 0;
+	for (const ObjectID &id : _undo_history) {
+		TerrainGeneratorUndoDelta *delta = Object::cast_to<TerrainGeneratorUndoDelta>(ObjectDB::get_instance(id));
+		if (delta) {
+			bytes += delta->get_bytes();
+		}
+	}
+	return bytes;
+}
+
 ///////////////////////////
 // Protected Functions
 ///////////////////////////
@@ -886,7 +1002,9 @@ void TerrainGeneratorEditor::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("is_operating"), &TerrainGeneratorEditor::is_operating);
 	ClassDB::bind_method(D_METHOD("operate", "position", "camera_direction"), &TerrainGeneratorEditor::operate);
 	ClassDB::bind_method(D_METHOD("backup_region", "region"), &TerrainGeneratorEditor::backup_region);
+	ClassDB::bind_method(D_METHOD("backup_region_instances", "region"), &TerrainGeneratorEditor::backup_region_instances);
 	ClassDB::bind_method(D_METHOD("stop_operation"), &TerrainGeneratorEditor::stop_operation);
+	ClassDB::bind_method(D_METHOD("get_undo_bytes"), &TerrainGeneratorEditor::get_undo_bytes);
 
 	ClassDB::bind_method(D_METHOD("apply_undo", "data"), &TerrainGeneratorEditor::_apply_undo);
 }
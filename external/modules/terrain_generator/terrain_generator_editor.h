@@ -4,9 +4,11 @@
 
 #include <godot/core/io/image.h>
 #include <godot/scene/resources/image_texture.h>
+#include <deque>
 
 #include "terrain_generator.h"
 #include "terrain_generator_region.h"
+#include "terrain_generator_undo_delta.h"
 
 
 class TerrainGeneratorEditor : public Object {
@@ -76,9 +78,11 @@ private:
 	Array _operation_movement_history;
 	bool _is_operating = false;
 	uint64_t _last_region_bounds_error = 0;
-	TypedArray<TerrainGeneratorRegion> _original_regions; // Queue for undo
-	TypedArray<TerrainGeneratorRegion> _edited_regions; // Queue for redo
+	TypedArray<TerrainGeneratorRegion> _original_regions; // Removed regions, queue for undo
+	TypedArray<TerrainGeneratorRegion> _edited_regions; // Edited and added regions, queue for redo
 	TypedArray<Vector2i> _added_removed_locations; // Queue for added/removed locations
+	Ref<TerrainGeneratorUndoDelta> _undo_delta; // Map tiles and instances changed by this operation
+	std::deque<ObjectID> _undo_history; // Deltas held by the undo manager, oldest first
 	AABB _modified_area;
 	Dictionary _undo_data; // See _get_undo_data for definition
 	uint64_t _last_pen_tick = 0;
@@ -90,8 +94,10 @@ private:
 	bool _is_in_bounds(const Point2i &p_pixel, const Point2i &p_size) const;
 	Vector2 _get_uv_position(const Vector3 &p_global_position, const int p_region_size, const real_t p_vertex_spacing) const;
 	Vector2 _get_rotated_uv(const Vector2 &p_uv, const real_t p_angle) const;
+	void _backup_tile(TerrainGeneratorRegion *p_region, const MapType p_map_type, const Vector2i &p_pixel);
 	void _store_undo();
 	void _apply_undo(const Dictionary &p_data);
+	void _trim_undo_history();
 
 public:
 	TerrainGeneratorEditor() {}
@@ -111,7 +117,9 @@ public:
 	bool is_operating() const { return _is_operating; }
 	void operate(const Vector3 &p_global_position, const real_t p_camera_direction);
 	void backup_region(const Ref<TerrainGeneratorRegion> &p_region);
+	void backup_region_instances(const Ref<TerrainGeneratorRegion> &p_region);
 	void stop_operation();
+	uint64_t get_undo_bytes() const;
 
 protected:
 	static void _bind_methods();
@@ -5,6 +5,7 @@
 #include "constants.h"
 #include "logger.h"
 #include "terrain_generator_instancer.h"
+#include "terrain_generator_profiler.h"
 #include "terrain_generator_region.h"
 #include "terrain_generator_util.h"
 
@@ -15,6 +16,7 @@
 // Creates MMIs based on stored Multimesh data
 void TerrainGeneratorInstancer::_update_mmis(const Vector2i &p_region_loc, const int p_mesh_id) {
 	IS_DATA_INIT(VOID);
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::INSTANCER);
 	LOG(INFO, "Updating MMIs for ", (p_region_loc.x == INT32_MAX) ? "all regions" : "region " + String(p_region_loc),
 			(p_mesh_id == -1) ? ", all meshes" : ", mesh " + String::num_int64(p_mesh_id));
 
@@ -32,18 +34,16 @@ void TerrainGeneratorInstancer::_update_mmis(const Vector2i &p_region_loc, const
 			LOG(WARN, "Errant null region found at: ", region_loc);
 			continue;
 		}
-		Dictionary mesh_inst_dict = region->get_instances();
+		InstanceStore *store = region->get_instance_store();
 
 		// For specified mesh id in that region, or -1 for all
-		Array mesh_types;
+		std::vector<int> mesh_ids;
 		if (p_mesh_id < 0) {
-			mesh_types = mesh_inst_dict.keys();
-		} else {
-			mesh_types.push_back(p_mesh_id);
+			mesh_ids = store->get_mesh_ids();
+		} else if (store->has_mesh(p_mesh_id)) {
+			mesh_ids.push_back(p_mesh_id);
 		}
-		for (int m = 0; m < mesh_types.size(); m++) {
-			int mesh_id = mesh_types[m];
-
+		for (const int mesh_id : mesh_ids) {
 			// Verify mesh id is valid and has some meshes
 			Ref<TerrainGeneratorMeshAsset> ma = _terrain->get_assets()->get_mesh_asset(mesh_id);
 			if (ma.is_valid()) {
@@ -59,23 +59,17 @@ void TerrainGeneratorInstancer::_update_mmis(const Vector2i &p_region_loc, const
 				continue;
 			}
 
-			Dictionary cell_inst_dict = mesh_inst_dict[mesh_id];
-			Array cell_locations = cell_inst_dict.keys();
-			for (int c = 0; c < cell_locations.size(); c++) {
+			for (auto &cell_it : *store->get_cells(mesh_id)) {
 				// Get instances
-				Vector2i cell = cell_locations[c];
-				Array triple = cell_inst_dict[cell];
-				if (triple.size() < 3) {
-					LOG(WARN, "Triple is empty");
-					continue;
-				}
-				TypedArray<Transform3D> xforms = triple[0];
-				PackedColorArray colors = triple[1];
-				bool modified = triple[2];
-				if (xforms.size() == 0) {
+				const Vector2i &cell = cell_it.first;
+				InstanceStore::Cell &cell_data = cell_it.second;
+				bool modified = cell_data.modified;
+				if (cell_data.is_empty()) {
 					LOG(WARN, "Empty cell in region ", region_loc, " cell ", cell);
 					continue;
 				}
+				// MultiMesh buffer shared by all LODs, filled on first use
+				PackedFloat32Array buffer;
 
 				// Create MMI container if needed
 				String rname("Region" + Util::location_to_string(region_loc));
@@ -142,7 +136,11 @@ void TerrainGeneratorInstancer::_update_mmis(const Vector2i &p_region_loc, const
 						// Reuse LOD MM as shadow impostor
 						mm = shadow_impostor_source_mm;
 					} else {
-						mm = _create_multimesh(mesh_id, lod, xforms, colors);
+						if (buffer.is_empty()) {
+							buffer.resize(cell_data.size() * InstanceStore::BUFFER_FLOATS);
+							cell_data.fill_buffer(buffer.ptrw());
+						}
+						mm = _create_multimesh(mesh_id, lod, buffer);
 					}
 					if (mm.is_null()) {
 						continue;
@@ -170,10 +168,9 @@ void TerrainGeneratorInstancer::_update_mmis(const Vector2i &p_region_loc, const
 					t.origin.x += region_loc.x * region_size * vertex_spacing;
 					t.origin.z += region_loc.y * region_size * vertex_spacing;
 					mmi->set_global_transform(t);
-
-					// Clear the cell modified state
-					triple[2] = false;
 				}
+				// Clear the cell modified state
+				cell_data.modified = false;
 
 				// Set all LOD mmi AABB to match LOD0 to ensure no gaps between transitions.
 				AABB mmi_custom_aabb = AABB();
@@ -237,33 +234,9 @@ void TerrainGeneratorInstancer::_update_vertex_spacing(const real_t p_vertex_spa
 			continue;
 		}
 
-		// For all mesh_ids in region
-		Dictionary mesh_inst_dict = region->get_instances();
+		// Descale, then Scale all mesh_ids in region to the new value
 		LOG(DEBUG, "Updating MMIs from: ", region_loc);
-		Array mesh_types = mesh_inst_dict.keys();
-		for (int m = 0; m < mesh_types.size(); m++) {
-			int mesh_id = mesh_types[m];
-			Dictionary cell_inst_dict = mesh_inst_dict[mesh_id];
-			Array cell_locations = cell_inst_dict.keys();
-			for (int c = 0; c < cell_locations.size(); c++) {
-				// Get instances
-				Vector2i cell = cell_locations[c];
-				Array triple = cell_inst_dict[cell];
-				TypedArray<Transform3D> xforms = triple[0];
-				// Descale, then Scale to the new value
-				for (int i = 0; i < xforms.size(); i++) {
-					Transform3D t = xforms[i];
-					t.origin.x /= old_spacing;
-					t.origin.x *= p_vertex_spacing;
-					t.origin.z /= old_spacing;
-					t.origin.z *= p_vertex_spacing;
-					xforms[i] = t;
-				}
-				triple[0] = xforms;
-				triple[2] = true;
-				cell_inst_dict[cell] = triple;
-			}
-		}
+		region->get_instance_store()->scale_origins(p_vertex_spacing / old_spacing);
 		// After all transforms are updated, set the new region vertex spacing value
 		region->set_vertex_spacing(p_vertex_spacing);
 		region->set_modified(true);
@@ -346,13 +319,14 @@ void TerrainGeneratorInstancer::_backup_region(const Ref<TerrainGeneratorRegion>
 		return;
 	}
 	if (_terrain && _terrain->get_editor() && _terrain->get_editor()->is_operating()) {
-		_terrain->get_editor()->backup_region(p_region);
+		_terrain->get_editor()->backup_region_instances(p_region);
 	} else {
 		p_region->set_modified(true);
 	}
 }
 
-Ref<MultiMesh> TerrainGeneratorInstancer::_create_multimesh(const int p_mesh_id, const int p_lod, const TypedArray<Transform3D> &p_xforms, const PackedColorArray &p_colors) const {
+// Expects a buffer of InstanceStore::BUFFER_FLOATS per instance, see InstanceStore::Cell::fill_buffer()
+Ref<MultiMesh> TerrainGeneratorInstancer::_create_multimesh(const int p_mesh_id, const int p_lod, const PackedFloat32Array &p_buffer) const {
 	Ref<MultiMesh> mm;
 	IS_INIT(mm);
 	Ref<TerrainGeneratorMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
@@ -369,14 +343,9 @@ Ref<MultiMesh> TerrainGeneratorInstancer::_create_multimesh(const int p_mesh_id,
 	mm->set_transform_format(MultiMesh::TRANSFORM_3D);
 	mm->set_use_colors(true);
 	mm->set_mesh(mesh);
-	if (p_xforms.size() > 0) {
-		mm->set_instance_count(p_xforms.size());
-		for (int i = 0; i < p_xforms.size(); i++) {
-			mm->set_instance_transform(i, p_xforms[i]);
-			if (i < p_colors.size()) {
-				mm->set_instance_color(i, p_colors[i]);
-			}
-		}
+	if (p_buffer.size() >= InstanceStore::BUFFER_FLOATS) {
+		mm->set_instance_count(p_buffer.size() / InstanceStore::BUFFER_FLOATS);
+		mm->set_buffer(p_buffer);
 	}
 	return mm;
 }
@@ -390,6 +359,38 @@ Vector2i TerrainGeneratorInstancer::_get_cell(const Vector3 &p_global_position,
 	return cell;
 }
 
+// Returns the range of cells in a region that overlap the global rect, as cell coordinates.
+// Empty if the rect doesn't overlap the region.
+Rect2i TerrainGeneratorInstancer::_get_cell_rect(const Vector2i &p_region_loc, const Rect2 &p_global_rect) const {
+	IS_INIT(Rect2i());
+	int region_size = _terrain->get_region_size();
+	real_t vertex_spacing = _terrain->get_vertex_spacing();
+	Vector2 region_offset = Vector2(p_region_loc * region_size) * vertex_spacing;
+	Vector2i start = Vector2i(((p_global_rect.position - region_offset) / vertex_spacing).floor());
+	Vector2i end = Vector2i(((p_global_rect.get_end() - region_offset) / vertex_spacing).floor());
+	int cells = region_size / CELL_SIZE;
+	start = V2I_DIVIDE_FLOOR(start, CELL_SIZE).clamp(V2I_ZERO, V2I(cells));
+	end = V2I_DIVIDE_FLOOR(end, CELL_SIZE).clamp(V2I(-1), V2I(cells - 1));
+	return Rect2i(start, end - start + V2I(1));
+}
+
+// Returns the locations of existing regions that overlap the global rect
+std::vector<Vector2i> TerrainGeneratorInstancer::_get_region_locations(const Rect2 &p_global_rect) const {
+	std::vector<Vector2i> region_locations;
+	IS_DATA_INIT(region_locations);
+	TerrainGeneratorData *data = _terrain->get_data();
+	Vector2i start = data->get_region_location(Vector3(p_global_rect.position.x, 0.f, p_global_rect.position.y));
+	Vector2i end = data->get_region_location(Vector3(p_global_rect.get_end().x, 0.f, p_global_rect.get_end().y));
+	for (int y = start.y; y <= end.y; y++) {
+		for (int x = start.x; x <= end.x; x++) {
+			if (data->has_region(Vector2i(x, y))) {
+				region_locations.push_back(Vector2i(x, y));
+			}
+		}
+	}
+	return region_locations;
+}
+
 // Get appropriate terrain height. Could find terrain (excluding slope or holes) or optional collision
 Array TerrainGeneratorInstancer::_get_usable_height(const Vector3 &p_global_position, const Vector2 &p_slope_range, const bool p_invert, const bool p_on_collision) const {
 	IS_DATA_INIT(Array());
@@ -431,6 +432,33 @@ Array TerrainGeneratorInstancer::_get_usable_height(const Vector3 &p_global_posi
 	return triple;
 }
 
+// Appends transforms in region space to the cells they fall in
+void TerrainGeneratorInstancer::_append_region(const Ref<TerrainGeneratorRegion> &p_region, const int p_mesh_id,
+		const std::vector<Transform3D> &p_xforms, const std::vector<Color> &p_colors, const bool p_update) {
+	if (p_region.is_null()) {
+		LOG(ERROR, "Null region provided. Doing nothing.");
+		return;
+	}
+	if (p_xforms.empty()) {
+		LOG(ERROR, "No transforms to add. Doing nothing.");
+		return;
+	}
+
+	_backup_region(p_region);
+
+	InstanceStore::CellMap &cells = p_region->get_instance_store()->get_or_create_cells(p_mesh_id);
+	int region_size = p_region->get_region_size();
+	for (size_t i = 0; i < p_xforms.size(); i++) {
+		Vector2i cell_loc = _get_cell(p_xforms[i].origin, region_size);
+		InstanceStore::Cell &cell = cells[cell_loc];
+		cell.append(p_xforms[i], (i < p_colors.size()) ? p_colors[i] : COLOR_WHITE);
+		cell.modified = true;
+	}
+	if (p_update) {
+		_update_mmis(p_region->get_location(), p_mesh_id);
+	}
+}
+
 ///////////////////////////
 // Public Functions
 ///////////////////////////
@@ -485,10 +513,9 @@ void TerrainGeneratorInstancer::clear_by_region(const Ref<TerrainGeneratorRegion
 	}
 	Vector2i region_loc = p_region->get_location();
 	LOG(INFO, "Deleting Multimeshes w/ mesh_id: ", p_mesh_id, " in region: ", region_loc);
-	Dictionary mesh_inst_dict = p_region->get_instances();
-	if (mesh_inst_dict.has(p_mesh_id)) {
+	if (p_region->get_instance_store()->has_mesh(p_mesh_id)) {
 		_backup_region(p_region);
-		mesh_inst_dict.erase(p_mesh_id);
+		p_region->get_instance_store()->erase_mesh(p_mesh_id);
 	}
 	_destroy_mmi_by_location(region_loc, p_mesh_id);
 }
@@ -628,113 +655,73 @@ void TerrainGeneratorInstancer::remove_instances(const Vector3 &p_global_positio
 	TerrainGeneratorData *data = _terrain->get_data();
 	int region_size = _terrain->get_region_size();
 	real_t vertex_spacing = _terrain->get_vertex_spacing();
+	real_t remove_chance = CLAMP(0.175f * strength, 0.005f, 10.f);
 
-	// Build list of potential regions to search, rather than searching the entire terrain, calculate possible regions covered
-	// and check if they are valid; if so add that location to the dictionary keys.
-	Dictionary r_locs;
-	// Calculate step distance to ensure every region is checked inside the bounds of brush size.
-	real_t step = brush_size / ceil(brush_size / real_t(region_size) / vertex_spacing);
-	for (real_t x = p_global_position.x - half_brush_size; x <= p_global_position.x + half_brush_size; x += step) {
-		for (real_t z = p_global_position.z - half_brush_size; z <= p_global_position.z + half_brush_size; z += step) {
-			Vector2i region_loc = data->get_region_location(Vector3(x, 0.f, z));
-			if (data->has_region(region_loc)) {
-				r_locs[region_loc] = 1;
-			}
-		}
-	}
-
-	Array region_queue = r_locs.keys();
-	if (region_queue.size() == 0) {
-		return;
-	}
-
-	for (int r = 0; r < region_queue.size(); r++) {
-		Vector2i region_loc = region_queue[r];
+	// Search only the regions and cells the brush covers, rather than the entire terrain
+	Rect2 brush_rect = Rect2(p_global_position.x - half_brush_size, p_global_position.z - half_brush_size,
+			2.f * half_brush_size, 2.f * half_brush_size);
+	std::vector<Vector2i> region_queue = _get_region_locations(brush_rect);
+	for (const Vector2i &region_loc : region_queue) {
 		Ref<TerrainGeneratorRegion> region = data->get_region(region_loc);
 		if (region.is_null()) {
 			LOG(WARN, "Errant null region found at: ", region_loc);
 			continue;
 		}
-
-		Dictionary mesh_inst_dict = region->get_instances();
-		Array mesh_types = mesh_inst_dict.keys();
-		if (mesh_types.size() == 0) {
+		InstanceStore *store = region->get_instance_store();
+		if (store->is_empty()) {
 			continue;
 		}
 		Vector3 global_local_offset = Vector3(region_loc.x * region_size * vertex_spacing, 0.f, region_loc.y * region_size * vertex_spacing);
 		Vector2 localised_ring_center = Vector2(p_global_position.x - global_local_offset.x, p_global_position.z - global_local_offset.z);
+		Rect2i cell_rect = _get_cell_rect(region_loc, brush_rect);
 		// For this mesh id, or all mesh ids
 		for (int m = (modifier_shift ? 0 : mesh_id); m <= (modifier_shift ? mesh_count - 1 : mesh_id); m++) {
 			// Ensure this region has this mesh
-			if (!mesh_inst_dict.has(m)) {
-				continue;
-			}
-			Dictionary cell_inst_dict = mesh_inst_dict[m];
-			Array cell_locations = cell_inst_dict.keys();
-			// This shouldnt be empty
-			if (cell_locations.size() == 0) {
-				LOG(WARN, "Region at: ", region_loc, " has instance dictionary for mesh id: ", m, " but has no cells.")
-				continue;
-			}
-			// Check potential cells rather than searching the entire region, whilst marginally
-			// slower if there are very few cells for the given mesh present. It is significantly
-			// faster when a large number of cells are present.
-			Dictionary c_locs;
-			// Calculate step distance to ensure every cell is checked inside the bounds of brush size.
-			real_t cell_step = brush_size / ceil(brush_size / real_t(CELL_SIZE) / vertex_spacing);
-			for (real_t x = p_global_position.x - half_brush_size; x <= p_global_position.x + half_brush_size; x += cell_step) {
-				for (real_t z = p_global_position.z - half_brush_size; z <= p_global_position.z + half_brush_size; z += cell_step) {
-					Vector3 cell_pos = Vector3(x, 0.f, z) - global_local_offset;
-					// Manually calculate cell pos without modulus, locations not in the current region will not be found.
-					Vector2i cell_loc;
-					cell_loc.x = VariantUtilityFunctions::floori(cell_pos.x / vertex_spacing) / CELL_SIZE;
-					cell_loc.y = VariantUtilityFunctions::floori(cell_pos.z / vertex_spacing) / CELL_SIZE;
-					if (cell_locations.has(cell_loc)) {
-						c_locs[cell_loc] = 1;
-					}
-				}
-			}
-			Array cell_queue = c_locs.keys();
-			if (cell_queue.size() == 0) {
+			InstanceStore::CellMap *cells = store->get_cells(m);
+			if (!cells) {
 				continue;
 			}
 			Ref<TerrainGeneratorMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(m);
 			real_t mesh_height_offset = mesh_asset->get_height_offset();
-			for (int c = 0; c < cell_queue.size(); c++) {
-				Vector2i cell = cell_queue[c];
-				Array triple = cell_inst_dict[cell];
-				TypedArray<Transform3D> xforms = triple[0];
-				PackedColorArray colors = triple[1];
-				TypedArray<Transform3D> updated_xforms;
-				PackedColorArray updated_colors;
-				// Remove transforms if inside ring radius
-				for (int i = 0; i < xforms.size(); i++) {
-					Transform3D t = xforms[i];
-					// Use localised ring center
-					real_t radial_distance = localised_ring_center.distance_to(Vector2(t.origin.x, t.origin.z));
-					Vector3 height_offset = t.basis.get_column(1) * mesh_height_offset;
-					if (radial_distance < radius &&
-							VariantUtilityFunctions::randf() < CLAMP(0.175f * strength, 0.005f, 10.f) &&
-							data->is_in_slope(t.origin + global_local_offset - height_offset, slope_range, invert)) {
-						_backup_region(region);
+			std::vector<Vector2i> emptied_cells;
+			std::vector<bool> remove;
+			for (int y = cell_rect.position.y; y < cell_rect.get_end().y; y++) {
+				for (int x = cell_rect.position.x; x < cell_rect.get_end().x; x++) {
+					auto cell_it = cells->find(Vector2i(x, y));
+					if (cell_it == cells->end()) {
 						continue;
-					} else {
-						updated_xforms.push_back(t);
-						updated_colors.push_back(colors[i]);
 					}
-				}
-				if (updated_xforms.size() > 0) {
-					triple[0] = updated_xforms;
-					triple[1] = updated_colors;
-					triple[2] = true;
-					cell_inst_dict[cell] = triple;
-				} else {
-					cell_inst_dict.erase(cell);
-					_destroy_mmi_by_cell(region_loc, m, cell);
+					InstanceStore::Cell &cell = cell_it->second;
+					// Flag transforms inside ring radius
+					remove.assign(cell.size(), false);
+					bool removed = false;
+					for (int i = 0; i < cell.size(); i++) {
+						Transform3D t = cell.get_xform(i);
+						// Use localised ring center
+						real_t radial_distance = localised_ring_center.distance_to(Vector2(t.origin.x, t.origin.z));
+						Vector3 height_offset = t.basis.get_column(1) * mesh_height_offset;
+						if (radial_distance < radius &&
+								VariantUtilityFunctions::randf() < remove_chance &&
+								data->is_in_slope(t.origin + global_local_offset - height_offset, slope_range, invert)) {
+							remove[i] = true;
+							removed = true;
+						}
+					}
+					if (!removed) {
+						continue;
+					}
+					_backup_region(region);
+					cell.remove_if(remove);
+					cell.modified = true;
+					if (cell.is_empty()) {
+						emptied_cells.push_back(cell_it->first);
+					}
 				}
 			}
-			if (cell_inst_dict.is_empty()) {
-				mesh_inst_dict.erase(m);
+			// Invalidates cells
+			for (const Vector2i &cell : emptied_cells) {
+				store->erase_cell(m, cell);
+				_destroy_mmi_by_cell(region_loc, m, cell);
 			}
 		}
 		_update_mmis(region_loc);
@@ -767,12 +754,13 @@ void TerrainGeneratorInstancer::add_transforms(const int p_mesh_id, const TypedA
 		return;
 	}
 
-	Dictionary xforms_dict;
-	Dictionary colors_dict;
 	Ref<TerrainGeneratorMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(p_mesh_id);
+	TerrainGeneratorData *data = _terrain->get_data();
 
-	// Separate incoming transforms/colors by region Dict{ region_loc => Array() }
+	// Separate incoming transforms/colors by region
 	LOG(INFO, "Separating ", p_xforms.size(), " transforms and ", p_colors.size(), " colors into regions");
+	std::unordered_map<Vector2i, std::vector<Transform3D>, Vector2iHash> xforms_by_region;
+	std::unordered_map<Vector2i, std::vector<Color>, Vector2iHash> colors_by_region;
 	for (int i = 0; i < p_xforms.size(); i++) {
 		// Get adjusted xform/color
 		Transform3D trns = p_xforms[i];
@@ -783,26 +771,26 @@ void TerrainGeneratorInstancer::add_transforms(const int p_mesh_id, const TypedA
 		}
 
 		// Store by region offset
-		Vector2i region_loc = _terrain->get_data()->get_region_location(trns.origin);
-		if (!xforms_dict.has(region_loc)) {
-			xforms_dict[region_loc] = TypedArray<Transform3D>();
-			colors_dict[region_loc] = PackedColorArray();
-		}
-		TypedArray<Transform3D> xforms = xforms_dict[region_loc];
-		PackedColorArray colors = colors_dict[region_loc];
-		xforms.push_back(trns);
-		colors.push_back(col);
-		colors_dict[region_loc] = colors; // Note similar bug as godot-cpp#1149 needs this for PCA
+		Vector2i region_loc = data->get_region_location(trns.origin);
+		xforms_by_region[region_loc].push_back(trns);
+		colors_by_region[region_loc].push_back(col);
 	}
 
-	// Merge incoming transforms with existing transforms
-	Array region_locations = xforms_dict.keys();
-	for (int i = 0; i < region_locations.size(); i++) {
-		Vector2i region_loc = region_locations[i];
-		TypedArray<Transform3D> xforms = xforms_dict[region_loc];
-		PackedColorArray colors = colors_dict[region_loc];
-		//LOG(MESG, "Appending ", xforms.size(), " xforms, ", colors, " colors to region location: ", region_loc);
-		append_location(region_loc, p_mesh_id, xforms, colors, p_update);
+	// Merge incoming transforms with existing transforms, offsetting transforms to region space
+	int region_size = _terrain->get_region_size();
+	real_t vertex_spacing = _terrain->get_vertex_spacing();
+	for (auto &it : xforms_by_region) {
+		Vector2i region_loc = it.first;
+		Ref<TerrainGeneratorRegion> region = data->get_region(region_loc);
+		if (region.is_null()) {
+			continue;
+		}
+		Vector3 global_local_offset = Vector3(region_loc.x * region_size * vertex_spacing, 0.f, region_loc.y * region_size * vertex_spacing);
+		std::vector<Transform3D> &xforms = it.second;
+		for (Transform3D &t : xforms) {
+			t.origin -= global_local_offset;
+		}
+		_append_region(region, p_mesh_id, xforms, colors_by_region[region_loc], p_update);
 	}
 }
 
@@ -817,78 +805,42 @@ void TerrainGeneratorInstancer::append_location(const Vector2i &p_region_loc, co
 	int region_size = region->get_region_size();
 	real_t vertex_spacing = _terrain->get_vertex_spacing();
 	Vector2 global_local_offset = Vector2(p_region_loc.x * region_size * vertex_spacing, p_region_loc.y * region_size * vertex_spacing);
-	TypedArray<Transform3D> localised_xforms;
+	std::vector<Transform3D> localised_xforms;
+	std::vector<Color> colors;
+	localised_xforms.reserve(p_xforms.size());
+	colors.reserve(p_xforms.size());
 	for (int i = 0; i < p_xforms.size(); i++) {
 		Transform3D t = p_xforms[i];
 		// Localise the transform to "region space"
 		t.origin.x -= global_local_offset.x;
 		t.origin.z -= global_local_offset.y;
 		localised_xforms.push_back(t);
+		colors.push_back((i < p_colors.size()) ? p_colors[i] : COLOR_WHITE);
 	}
-	append_region(region, p_mesh_id, localised_xforms, p_colors, p_update);
+	_append_region(region, p_mesh_id, localised_xforms, colors, p_update);
 }
 
 // append_region requires all transforms are in region space, 0 - region_size * vertex_spacing
 void TerrainGeneratorInstancer::append_region(const Ref<TerrainGeneratorRegion> &p_region, const int p_mesh_id,
 		const TypedArray<Transform3D> &p_xforms, const PackedColorArray &p_colors, const bool p_update) {
-	if (p_region.is_null()) {
-		LOG(ERROR, "Null region provided. Doing nothing.");
-		return;
-	}
-	if (p_xforms.size() == 0) {
-		LOG(ERROR, "No transforms to add. Doing nothing.");
-		return;
-	}
-
-	_backup_region(p_region);
-
-	Dictionary cell_locations = p_region->get_instances()[p_mesh_id];
-	int region_size = p_region->get_region_size();
-
+	std::vector<Transform3D> xforms;
+	std::vector<Color> colors;
+	xforms.reserve(p_xforms.size());
+	colors.reserve(p_xforms.size());
 	for (int i = 0; i < p_xforms.size(); i++) {
-		Transform3D xform = p_xforms[i];
-		Color col = p_colors[i];
-		Vector2i cell = _get_cell(xform.origin, region_size);
-
-		// Get current instance arrays or create if none
-		Array triple = cell_locations[cell];
-		bool modified = true;
-		if (triple.size() != 3) {
-			LOG(DEBUG, "No data at ", p_region->get_location(), ":", cell, ". Creating triple");
-			triple.resize(3);
-			triple[0] = TypedArray<Transform3D>();
-			triple[1] = PackedColorArray();
-			triple[2] = modified;
-		}
-		TypedArray<Transform3D> xforms = triple[0];
-		PackedColorArray colors = triple[1];
-		xforms.push_back(xform);
-		colors.push_back(col);
-
-		// Must write back since there are copy constructors somewhere
-		// see godot-cpp#1149
-		triple[0] = xforms;
-		triple[1] = colors;
-		triple[2] = modified;
-		cell_locations[cell] = triple;
-	}
-
-	// Write back dictionary. See above comments
-	p_region->get_instances()[p_mesh_id] = cell_locations;
-	if (p_update) {
-		_update_mmis(p_region->get_location(), p_mesh_id);
+		xforms.push_back(p_xforms[i]);
+		colors.push_back((i < p_colors.size()) ? p_colors[i] : COLOR_WHITE);
 	}
+	_append_region(p_region, p_mesh_id, xforms, colors, p_update);
 }
 
 // Review all transforms in one area and adjust their transforms w/ the current height
 void TerrainGeneratorInstancer::update_transforms(const AABB &p_aabb) {
 	IS_DATA_INIT_MESG("Instancer isn't initialized.", VOID);
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::INSTANCER);
 	Rect2 rect = aabb2rect(p_aabb);
 	LOG(EXTREME, "Updating transforms within ", rect);
-	Vector2 global_position = rect.get_center();
-	Vector2 size = rect.get_size();
-	Vector2 half_size = size * 0.5f + Vector2(1.f, 1.f); // 1m margin
-	if (size == V2_ZERO) {
+	if (rect.get_size() == V2_ZERO) {
 		return;
 	}
 
@@ -897,106 +849,77 @@ void TerrainGeneratorInstancer::update_transforms(const AABB &p_aabb) {
 	int region_size = _terrain->get_region_size();
 	real_t vertex_spacing = _terrain->get_vertex_spacing();
 
-	// Build list of valid regions within AABB; add the locations as dictionary keys.
-	Dictionary r_locs;
-	// Calculate step distance to ensure every region is checked inside the bounds of AABB size.
-	Vector2 step = Vector2(size.x / ceil(size.x / real_t(region_size) / vertex_spacing), size.y / ceil(size.y / real_t(region_size) / vertex_spacing));
-	for (real_t x = global_position.x - half_size.x; x <= global_position.x + half_size.x; x += step.x) {
-		for (real_t z = global_position.y - half_size.y; z <= global_position.y + half_size.y; z += step.y) {
-			Vector2i region_loc = data->get_region_location(Vector3(x, 0.f, z));
-			if (data->has_region(region_loc)) {
-				r_locs[region_loc] = 0;
-			}
-		}
-	}
-
-	Array region_queue = r_locs.keys();
-	if (region_queue.size() == 0) {
-		return;
-	}
-
-	for (int r = 0; r < region_queue.size(); r++) {
-		Vector2i region_loc = region_queue[r];
+	// Search only the regions and cells within the AABB, rather than the entire terrain
+	Rect2 search_rect = rect.grow(1.f); // 1m margin
+	std::vector<Vector2i> region_queue = _get_region_locations(search_rect);
+	for (const Vector2i &region_loc : region_queue) {
 		Ref<TerrainGeneratorRegion> region = data->get_region(region_loc);
-		_backup_region(region);
-
-		Dictionary mesh_inst_dict = region->get_instances();
-		Array mesh_types = mesh_inst_dict.keys();
-		if (mesh_types.size() == 0) {
+		if (region.is_null()) {
+			continue;
+		}
+		InstanceStore *store = region->get_instance_store();
+		if (store->is_empty()) {
 			continue;
 		}
 		Vector3 global_local_offset = Vector3(region_loc.x * region_size * vertex_spacing, 0.f, region_loc.y * region_size * vertex_spacing);
-
-		// For this mesh id, or all mesh ids
-		for (int m = 0; m < mesh_types.size(); m++) {
-			// Check potential cells rather than searching the entire region, whilst marginally
-			// slower if there are very few cells for the given mesh present it is significantly
-			// faster when a very large number of cells are present.
-			int region_mesh_id = mesh_types[m];
-			Dictionary cell_inst_dict = mesh_inst_dict[region_mesh_id];
-			Array cell_locations = cell_inst_dict.keys();
-			if (cell_locations.size() == 0) {
-				continue;
-			}
-			Dictionary c_locs;
-			// Calculate step distance to ensure every cell is checked inside the bounds of brush size.
-			Vector2 cell_step = Vector2(size.x / ceil(size.x / real_t(CELL_SIZE) / vertex_spacing), size.y / ceil(size.y / real_t(CELL_SIZE) / vertex_spacing));
-			for (real_t x = global_position.x - half_size.x; x <= global_position.x + half_size.x; x += cell_step.x) {
-				for (real_t z = global_position.y - half_size.y; z <= global_position.y + half_size.y; z += cell_step.y) {
-					Vector3 cell_pos = Vector3(x, 0.f, z) - global_local_offset;
-					// Manually calculate cell pos without modulus, locations not in the current region will not be found.
-					Vector2i cell_loc;
-					cell_loc.x = VariantUtilityFunctions::floori(cell_pos.x / vertex_spacing) / CELL_SIZE;
-					cell_loc.y = VariantUtilityFunctions::floori(cell_pos.z / vertex_spacing) / CELL_SIZE;
-					if (cell_locations.has(cell_loc)) {
-						c_locs[cell_loc] = 0;
+		Rect2i cell_rect = _get_cell_rect(region_loc, search_rect);
+
+		// For all mesh ids
+		for (const int mesh_id : store->get_mesh_ids()) {
+			InstanceStore::CellMap *cells = store->get_cells(mesh_id);
+			Ref<TerrainGeneratorMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(mesh_id);
+			real_t mesh_height_offset = mesh_asset.is_valid() ? mesh_asset->get_height_offset() : 0.f;
+			std::vector<Vector2i> emptied_cells;
+			std::vector<bool> remove;
+			for (int y = cell_rect.position.y; y < cell_rect.get_end().y; y++) {
+				for (int x = cell_rect.position.x; x < cell_rect.get_end().x; x++) {
+					auto cell_it = cells->find(Vector2i(x, y));
+					if (cell_it == cells->end()) {
+						continue;
 					}
-				}
-			}
-			Array cell_queue = c_locs.keys();
-			if (cell_queue.size() == 0) {
-				continue;
-			}
-			Ref<TerrainGeneratorMeshAsset> mesh_asset = _terrain->get_assets()->get_mesh_asset(mesh_types[m]);
-			real_t mesh_height_offset = mesh_asset->get_height_offset();
-			for (int c = 0; c < cell_queue.size(); c++) {
-				Vector2i cell = cell_queue[c];
-				Array triple = cell_inst_dict[cell];
-				TypedArray<Transform3D> xforms = triple[0];
-				PackedColorArray colors = triple[1];
-				TypedArray<Transform3D> updated_xforms;
-				PackedColorArray updated_colors;
-				for (int i = 0; i < xforms.size(); i++) {
-					Transform3D t = xforms[i];
-					Vector3 global_origin(t.origin + global_local_offset);
-					if (rect.has_point(Vector2(global_origin.x, global_origin.z))) {
+					InstanceStore::Cell &cell = cell_it->second;
+					remove.assign(cell.size(), false);
+					bool removed = false;
+					for (int i = 0; i < cell.size(); i++) {
+						Transform3D t = cell.get_xform(i);
+						Vector3 global_origin(t.origin + global_local_offset);
+						if (!rect.has_point(Vector2(global_origin.x, global_origin.z))) {
+							continue;
+						}
 						Vector3 height_offset = t.basis.get_column(1) * mesh_height_offset;
 						t.origin -= height_offset;
 						Array height_data = _get_usable_height(global_origin, Vector2(0.f, 90.f), false, on_collision);
 						if (height_data.size() != 3) {
+							// Removed if a hole erased it
+							_backup_region(region);
+							cell.modified = true;
+							remove[i] = true;
+							removed = true;
 							continue;
 						}
-						t.origin.y = height_data[0];
-
+						real_t height = height_data[0];
+						if (Math::is_equal_approx(height, t.origin.y)) {
+							continue;
+						}
+						_backup_region(region);
+						cell.modified = true;
+						t.origin.y = height;
 						t.origin += height_offset;
+						cell.set_xform(i, t);
+					}
+					if (removed) {
+						cell.remove_if(remove);
+						if (cell.is_empty()) {
+							emptied_cells.push_back(cell_it->first);
+						}
 					}
-					updated_xforms.push_back(t);
-					updated_colors.push_back(colors[i]);
-				}
-				if (updated_xforms.size() > 0) {
-					triple[0] = updated_xforms;
-					triple[1] = updated_colors;
-					triple[2] = true;
-					cell_inst_dict[cell] = triple;
-				} else {
-					// Removed if a hole erased everything
-					cell_inst_dict.erase(cell);
-					_destroy_mmi_by_cell(region_loc, m, cell);
-				}
-				if (cell_inst_dict.is_empty()) {
-					mesh_inst_dict.erase(region_mesh_id);
 				}
 			}
+			// Invalidates cells
+			for (const Vector2i &cell : emptied_cells) {
+				store->erase_cell(mesh_id, cell);
+				_destroy_mmi_by_cell(region_loc, mesh_id, cell);
+			}
 		}
 		_update_mmis(region_loc);
 	}
@@ -1025,38 +948,33 @@ void TerrainGeneratorInstancer::copy_paste_dfr(const TerrainGeneratorRegion *p_s
 	// Get all Cell locations in rect, which is already in region space.
 	Vector2i cell_start = p_src_rect.get_position() / CELL_SIZE;
 	Vector2i steps = p_src_rect.get_size() / CELL_SIZE;
-	Dictionary cells_to_copy;
-	for (int x = cell_start.x; x < cell_start.x + steps.x; x++) {
-		for (int y = cell_start.y; y < cell_start.y + steps.y; y++) {
-			cells_to_copy[Vector2i(x, y)] = 0;
-		}
-	}
 
 	// For each mesh, for each cell, if in rect, convert xforms to target region space, append to target region.
-	Dictionary mesh_inst_dict = p_src_region->get_instances();
-	Array mesh_types = mesh_inst_dict.keys();
-	for (int m = 0; m < mesh_types.size(); m++) {
-		TypedArray<Transform3D> xforms;
-		PackedColorArray colors;
-		Dictionary cell_inst_dict = p_src_region->get_instances()[m];
-		Array cell_locs = cell_inst_dict.keys();
-		for (int c = 0; c < cell_locs.size(); c++) {
-			if (cells_to_copy.has(cell_locs[c])) {
-				Array triple = cell_inst_dict[cell_locs[c]];
-				TypedArray<Transform3D> cell_xforms = triple[0];
-				PackedColorArray cell_colors = triple[1];
-				for (int i = 0; i < cell_xforms.size(); i++) {
-					Transform3D t = cell_xforms[i];
+	const InstanceStore *src_store = p_src_region->get_instance_store();
+	for (const int mesh_id : src_store->get_mesh_ids()) {
+		const InstanceStore::CellMap *cells = src_store->get_cells(mesh_id);
+		std::vector<Transform3D> xforms;
+		std::vector<Color> colors;
+		for (int x = cell_start.x; x < cell_start.x + steps.x; x++) {
+			for (int y = cell_start.y; y < cell_start.y + steps.y; y++) {
+				auto cell_it = cells->find(Vector2i(x, y));
+				if (cell_it == cells->end()) {
+					continue;
+				}
+				const InstanceStore::Cell &cell = cell_it->second;
+				const Color *cell_colors = cell.colors.ptr();
+				for (int i = 0; i < cell.size(); i++) {
+					Transform3D t = cell.get_xform(i);
 					t.origin += dst_translate;
 					xforms.push_back(t);
 					colors.push_back(cell_colors[i]);
 				}
 			}
 		}
-		if (xforms.size() == 0) {
+		if (xforms.empty()) {
 			continue;
 		}
-		append_region(Ref<TerrainGeneratorRegion>(p_dst_region), m, xforms, colors, false);
+		_append_region(Ref<TerrainGeneratorRegion>(const_cast<TerrainGeneratorRegion *>(p_dst_region)), mesh_id, xforms, colors, false);
 	}
 }
 
@@ -1077,31 +995,11 @@ void TerrainGeneratorInstancer::swap_ids(const int p_src_id, const int p_dst_id)
 				continue;
 			}
 
-			// mesh_inst_dict could have src, src+dst, dst or nothing. All 4 must be considered
-			Dictionary mesh_inst_dict = region->get_instances();
-			Dictionary cells_inst_dict_src;
-			Dictionary cells_inst_dict_dst;
-			// Extract src dict
-			if (mesh_inst_dict.has(p_src_id)) {
+			// The store could have src, src+dst, dst or nothing. All 4 are handled by swap_meshes()
+			InstanceStore *store = region->get_instance_store();
+			if (store->has_mesh(p_src_id) || store->has_mesh(p_dst_id)) {
 				_backup_region(region);
-				cells_inst_dict_src = mesh_inst_dict[p_src_id];
-				mesh_inst_dict.erase(p_src_id);
-			}
-			// Extract dest dict
-			if (mesh_inst_dict.has(p_dst_id)) {
-				_backup_region(region);
-				cells_inst_dict_dst = mesh_inst_dict[p_dst_id];
-				mesh_inst_dict.erase(p_dst_id);
-			}
-			// If src exists, insert into dst slot
-			if (!cells_inst_dict_src.is_empty()) {
-				_backup_region(region);
-				mesh_inst_dict[p_dst_id] = cells_inst_dict_src;
-			}
-			// If dst exists, insert into src slot
-			if (!cells_inst_dict_dst.is_empty()) {
-				_backup_region(region);
-				mesh_inst_dict[p_src_id] = cells_inst_dict_dst;
+				store->swap_meshes(p_src_id, p_dst_id);
 			}
 			LOG(MESG, "Swapped mesh_ids for region: ", region_loc);
 		}
@@ -1128,24 +1026,13 @@ void TerrainGeneratorInstancer::dump_data() {
 			continue;
 		}
 		LOG(MESG, "Region: ", region_loc);
-		Dictionary mesh_inst_dict = region->get_instances();
-		Array mesh_ids = mesh_inst_dict.keys();
-		for (int m = 0; m < mesh_ids.size(); m++) {
-			int mesh_id = mesh_ids[m];
+		const InstanceStore *store = region->get_instance_store();
+		for (const int mesh_id : store->get_mesh_ids()) {
 			LOG(MESG, "Mesh ID: ", mesh_id);
-			Dictionary cell_inst_dict = mesh_inst_dict[mesh_id];
-			Array cells = cell_inst_dict.keys();
-			for (int c = 0; c < cells.size(); c++) {
-				Vector2i cell = cells[c];
-				Array triple = cell_inst_dict[cell];
-				if (triple.size() != 3) {
-					LOG(WARN, "Malformed triple at cell ", cell, ": ", triple);
-					continue;
-				}
-				Array xforms = triple[0];
-				Array colors = triple[1];
-				bool modified = triple[2];
-				LOG(MESG, "Mesh: ", mesh_id, " cell: ", cell, " xforms: ", xforms.size(), " colors: ", colors.size(), " modified: ", modified);
+			for (const auto &it : *store->get_cells(mesh_id)) {
+				const InstanceStore::Cell &cell = it.second;
+				LOG(MESG, "Mesh: ", mesh_id, " cell: ", it.first, " xforms: ", cell.xforms.size() / InstanceStore::XFORM_FLOATS,
+						" colors: ", cell.colors.size(), " modified: ", cell.modified);
 			}
 		}
 	}
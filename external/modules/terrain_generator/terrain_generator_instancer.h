@@ -5,6 +5,7 @@
 #include <godot/scene/resources/multimesh.h>
 #include <godot/scene/3d/multimesh_instance_3d.h>
 #include <unordered_map>
+#include <vector>
 
 #include "constants.h"
 #include "terrain_generator_region.h"
@@ -12,11 +13,13 @@
 
 class TerrainGenerator;
 class TerrainGeneratorAssets;
+class TerrainGeneratorData;
 
 class TerrainGeneratorInstancer : public Object {
 	GDCLASS(TerrainGeneratorInstancer, Object);
 	CLASS_NAME();
 	friend TerrainGenerator;
+	friend TerrainGeneratorData;
 
 public: // Constants
 	static inline const int CELL_SIZE = 32;
@@ -25,7 +28,7 @@ private:
 	TerrainGenerator *_terrain = nullptr;
 
 	// MM Resources stored in TerrainGeneratorRegion::_instances as
-	// Region::_instances{mesh_id:int} -> cell{v2i} -> [ TypedArray<Transform3D>, PackedColorArray, modified:bool ]
+	// Region::_instances{mesh_id:int} -> cell{v2i} -> InstanceStore::Cell{ xforms, colors, modified }
 
 	// MMI Objects attached to tree, freed in destructor, stored as
 	// _mmi_nodes{region_loc} -> mesh{v2i(mesh_id,lod)} -> cell{v2i} -> MultiMeshInstance3D
@@ -46,8 +49,12 @@ private:
 	void _destroy_mmi_by_cell(const Vector2i &p_region_loc, const int p_mesh_id, const Vector2i p_cell);
 	void _destroy_mmi_by_location(const Vector2i &p_region_loc, const int p_mesh_id);
 	void _backup_region(const Ref<TerrainGeneratorRegion> &p_region);
-	Ref<MultiMesh> _create_multimesh(const int p_mesh_id, const int p_lod, const TypedArray<Transform3D> &p_xforms = TypedArray<Transform3D>(), const PackedColorArray &p_colors = PackedColorArray()) const;
+	Ref<MultiMesh> _create_multimesh(const int p_mesh_id, const int p_lod, const PackedFloat32Array &p_buffer = PackedFloat32Array()) const;
 	Vector2i _get_cell(const Vector3 &p_global_position, const int p_region_size);
+	Rect2i _get_cell_rect(const Vector2i &p_region_loc, const Rect2 &p_global_rect) const;
+	std::vector<Vector2i> _get_region_locations(const Rect2 &p_global_rect) const;
+	void _append_region(const Ref<TerrainGeneratorRegion> &p_region, const int p_mesh_id, const std::vector<Transform3D> &p_xforms,
+			const std::vector<Color> &p_colors, const bool p_update);
 	Array _get_usable_height(const Vector3 &p_global_position, const Vector2 &p_slope_range, const bool p_invert, const bool p_on_collision) const;
 
 public:
@@ -0,0 +1,413 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TG_BAKER_SSE
+#endif
+
+#include <godot/core/object/worker_thread_pool.h>
+#include <godot/core/os/time.h>
+
+#include "logger.h"
+#include "terrain_generator.h"
+#include "terrain_generator_mesh_baker.h"
+#include "terrain_generator_util.h"
+
+///////////////////////////
+// Private Functions
+///////////////////////////
+
+// Copies every p_stride pixel of a map row into vertex heights and controls, with holes set to NAN.
+// Four vertices at a time with SSE at full resolution, the rest in the scalar loop.
+static void _copy_vertex_row(const float *p_heights, const uint32_t *p_controls, const int p_stride,
+		real_t *r_heights, uint32_t *r_controls, const int p_count) {
+	int i = 0;
+#if defined(TG_BAKER_SSE) && !defined(REAL_T_IS_DOUBLE)
+	if (p_stride == 1) {
+		const __m128i hole_bit = _mm_set1_epi32(enc_hole(true));
+		const __m128 nan = _mm_set1_ps(NAN);
+		for (; i + 4 <= p_count; i += 4) {
+			__m128i controls = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p_controls + i));
+			__m128 holes = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(controls, hole_bit), hole_bit));
+			__m128 heights = _mm_loadu_ps(p_heights + i);
+			_mm_storeu_ps(r_heights + i, _mm_or_ps(_mm_and_ps(holes, nan), _mm_andnot_ps(holes, heights)));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(r_controls + i), controls);
+		}
+	}
+#endif
+	for (; i < p_count; i++) {
+		uint32_t control = p_controls[i * p_stride];
+		r_controls[i] = control;
+		r_heights[i] = is_hole(control) ? real_t(NAN) : real_t(p_heights[i * p_stride]);
+	}
+}
+
+uint64_t TerrainGeneratorMeshBaker::Tile::get_bytes() const {
+	return vertices.size() * sizeof(Vector3) + indices.size() * sizeof(int32_t) +
+			border_vertices.size() * sizeof(std::pair<Vector2i, int32_t>);
+}
+
+// Splits the bake area into tiles on a TILE_SIZE grid. Whole terrain bakes don't cross region boundaries.
+void TerrainGeneratorMeshBaker::_get_tile_areas(const BakeJob &p_job, std::vector<Rect2i> &r_areas) const {
+	std::vector<Rect2i> areas;
+	const AABB &aabb = p_job.settings.global_aabb;
+	if (!aabb.has_volume()) {
+		// Bake whole mesh, e.g. bake_mesh and painted navigation
+		int32_t region_size = p_job.maps.get_region_size();
+		TypedArray<Vector2i> region_locations = _terrain->get_data()->get_region_locations();
+		for (int r = 0; r < region_locations.size(); r++) {
+			areas.push_back(Rect2i(Vector2i(region_locations[r]) * region_size, V2I(region_size)));
+		}
+	} else {
+		// Bake within an AABB, e.g. runtime navigation baker
+		real_t spacing = p_job.maps.get_vertex_spacing();
+		int32_t z_start = (int32_t)Math::ceil(aabb.position.z / spacing);
+		int32_t z_end = (int32_t)Math::floor(aabb.get_end().z / spacing) + 1;
+		int32_t x_start = (int32_t)Math::ceil(aabb.position.x / spacing);
+		int32_t x_end = (int32_t)Math::floor(aabb.get_end().x / spacing) + 1;
+		// Align to the lod step so cells line up across tiles
+		x_start = int_divide_floor(x_start, p_job.step) * p_job.step;
+		z_start = int_divide_floor(z_start, p_job.step) * p_job.step;
+		areas.push_back(Rect2i(x_start, z_start, x_end - x_start, z_end - z_start));
+	}
+
+	for (const Rect2i &area : areas) {
+		if (!area.has_area()) {
+			continue;
+		}
+		Vector2i start = V2I_DIVIDE_FLOOR(area.position, TILE_SIZE);
+		Vector2i end = V2I_DIVIDE_FLOOR(area.get_end() - V2I(1), TILE_SIZE);
+		for (int z = start.y; z <= end.y; z++) {
+			for (int x = start.x; x <= end.x; x++) {
+				Rect2i tile_area = Rect2i(Vector2i(x, z) * TILE_SIZE, V2I(TILE_SIZE)).intersection(area);
+				if (tile_area.has_area()) {
+					r_areas.push_back(tile_area);
+				}
+			}
+		}
+	}
+}
+
+// Equivalent to TerrainGeneratorData::get_mesh_vertex() on a descaled vertex
+real_t TerrainGeneratorMeshBaker::_sample_height(const MapSnapshot &p_maps, const BakeJob &p_job, const int p_x, const int p_z,
+		const uint32_t p_control) const {
+	// Outside of regions the control is UINT32_MAX, also read as a hole
+	if (is_hole(p_control)) {
+		return NAN;
+	}
+	real_t height = p_maps.get_height_pixel(p_x, p_z);
+	if (p_job.settings.filter == TerrainGeneratorData::HEIGHT_FILTER_MINIMUM) {
+		int32_t half = p_job.step / 2;
+		for (int32_t dz = -half; dz < half; dz++) {
+			for (int32_t dx = -half; dx < half; dx++) {
+				if (is_hole(p_maps.get_control_pixel(p_x + dx, p_z + dz))) {
+					return NAN;
+				}
+				real_t h = p_maps.get_height_pixel(p_x + dx, p_z + dz);
+				if (h < height) {
+					height = h;
+				}
+			}
+		}
+	}
+	return height;
+}
+
+// Runs on WorkerThreadPool threads. Each only writes its own tile.
+// Generates two triangles per cell: Top 124, Bottom 143
+//		1  __  2
+//		  |\ |
+//		  | \|
+//		3  --  4
+// Vertices are shared between the triangles of the tile. If on the region edge, the edge heights are
+// duplicated into separate vertices.
+void TerrainGeneratorMeshBaker::_bake_tile(const uint32_t p_index, BakeJob *p_job) {
+	Tile &tile = *p_job->tiles[p_job->bake_ids[p_index]];
+	const MapSnapshot &maps = p_job->maps;
+	const BakeSettings &settings = p_job->settings;
+	const int32_t step = p_job->step;
+	const real_t spacing = maps.get_vertex_spacing();
+	const bool clip = settings.global_aabb.has_volume();
+	const real_t min_y = settings.global_aabb.position.y;
+	const real_t max_y = settings.global_aabb.get_end().y;
+	const Rect2i area = tile.area;
+	const int cols = (area.size.x + step - 1) / step;
+	const int rows = (area.size.y + step - 1) / step;
+	const int width = cols + 1;
+
+	// Sample all vertices of the tile once. Runs of vertices within one region row are copied
+	// straight from the maps, unless the minimum filter needs the pixels between them.
+	const bool copy_rows = step == 1 || settings.filter != TerrainGeneratorData::HEIGHT_FILTER_MINIMUM;
+	const int region_size = maps.get_region_size();
+	std::vector<real_t> heights(width * (rows + 1));
+	std::vector<uint32_t> controls(width * (rows + 1));
+	for (int vz = 0; vz <= rows; vz++) {
+		int z = area.position.y + vz * step;
+		for (int vx = 0; vx <= cols;) {
+			int x = area.position.x + vx * step;
+			int i = vz * width + vx;
+			const float *row_heights = nullptr;
+			const uint32_t *row_controls = nullptr;
+			if (copy_rows && maps.get_pixel_ptrs(x, z, row_heights, row_controls)) {
+				int row_pixels = region_size - (x & (region_size - 1));
+				int count = MIN(cols + 1 - vx, (row_pixels + step - 1) / step);
+				_copy_vertex_row(row_heights, row_controls, step, &heights[i], &controls[i], count);
+				vx += count;
+				continue;
+			}
+			controls[i] = maps.get_control_pixel(x, z);
+			heights[i] = _sample_height(maps, *p_job, x, z, controls[i]);
+			vx++;
+		}
+	}
+
+	std::vector<int32_t> vertex_ids(heights.size(), -1);
+	auto get_vertex = [&](const int p_i, const real_t p_height, const bool p_duplicate) -> int32_t {
+		if (!p_duplicate && vertex_ids[p_i] >= 0) {
+			return vertex_ids[p_i];
+		}
+		int vx = p_i % width;
+		int vz = p_i / width;
+		Vector2i pos = area.position + Vector2i(vx, vz) * step;
+		int32_t id = tile.vertices.size();
+		tile.vertices.push_back(Vector3(pos.x * spacing, p_height, pos.y * spacing));
+		if (!p_duplicate) {
+			vertex_ids[p_i] = id;
+			if (vx == 0 || vz == 0 || vx == cols || vz == rows) {
+				tile.border_vertices.push_back({ pos, id });
+			}
+		}
+		return id;
+	};
+
+	tile.vertices.clear();
+	tile.indices.clear();
+	tile.border_vertices.clear();
+	tile.vertices.reserve(heights.size());
+	tile.indices.reserve(cols * rows * 6);
+	for (int cz = 0; cz < rows; cz++) {
+		for (int cx = 0; cx < cols; cx++) {
+			int i1 = cz * width + cx;
+			int i2 = i1 + 1;
+			int i3 = i1 + width;
+			int i4 = i3 + 1;
+			real_t h1 = heights[i1];
+			if (std::isnan(h1) || (clip && (h1 < min_y || h1 > max_y))) {
+				continue;
+			}
+			bool nan2 = std::isnan(heights[i2]);
+			bool nan3 = std::isnan(heights[i3]);
+			bool nan4 = std::isnan(heights[i4]);
+			real_t h2 = nan2 ? h1 : heights[i2];
+			real_t h3 = nan3 ? h1 : heights[i3];
+			real_t h4 = !nan4 ? heights[i4] : (!nan2 ? h2 : (!nan3 ? h3 : h1));
+
+			uint32_t ctrl1 = controls[i1];
+			uint32_t ctrl2 = controls[i2];
+			uint32_t ctrl3 = controls[i3];
+			uint32_t ctrl4 = controls[i4];
+			// Holes are only where the control map is valid and the bit is set
+			bool hole1 = ctrl1 != UINT32_MAX && is_hole(ctrl1);
+			bool hole2 = ctrl2 != UINT32_MAX && is_hole(ctrl2);
+			bool hole3 = ctrl3 != UINT32_MAX && is_hole(ctrl3);
+			bool hole4 = ctrl4 != UINT32_MAX && is_hole(ctrl4);
+			// Navigation is where the control map is valid and the bit is set, or it's the region edge and nav1 is set
+			bool nav1 = ctrl1 != UINT32_MAX && is_nav(ctrl1);
+			bool nav2 = (ctrl2 != UINT32_MAX && is_nav(ctrl2)) || (nan2 && nav1);
+			bool nav3 = (ctrl3 != UINT32_MAX && is_nav(ctrl3)) || (nan3 && nav1);
+			bool nav4 = (ctrl4 != UINT32_MAX && is_nav(ctrl4)) || (nan4 && nav1);
+			bool bottom = !(hole1 || hole4 || hole3) && (!settings.require_nav || (nav1 && nav4 && nav3));
+			bool top = !(hole1 || hole2 || hole4) && (!settings.require_nav || (nav1 && nav2 && nav4));
+			if (!bottom && !top) {
+				continue;
+			}
+
+			int32_t v1 = get_vertex(i1, h1, false);
+			int32_t v4 = get_vertex(i4, h4, nan4);
+			// Bottom 143 triangle
+			if (bottom) {
+				int32_t v3 = get_vertex(i3, h3, nan3);
+				tile.indices.push_back(v1);
+				tile.indices.push_back(v4);
+				tile.indices.push_back(v3);
+			}
+			// Top 124 triangle
+			if (top) {
+				int32_t v2 = get_vertex(i2, h2, nan2);
+				tile.indices.push_back(v1);
+				tile.indices.push_back(v2);
+				tile.indices.push_back(v4);
+			}
+		}
+	}
+}
+
+// Appends all tiles into one indexed array, merging the vertices shared on tile borders
+void TerrainGeneratorMeshBaker::_merge_tiles(const BakeJob &p_job, PackedVector3Array &r_vertices, PackedInt32Array &r_indices) const {
+	int64_t vertex_count = 0;
+	int64_t index_count = 0;
+	for (const std::shared_ptr<Tile> &tile : p_job.tiles) {
+		vertex_count += tile->vertices.size();
+		index_count += tile->indices.size();
+	}
+	r_vertices.resize(vertex_count);
+	r_indices.resize(index_count);
+	Vector3 *vertices = r_vertices.ptrw();
+	int32_t *indices = r_indices.ptrw();
+	vertex_count = 0;
+	index_count = 0;
+
+	std::unordered_map<Vector2i, int32_t, Vector2iHash> border_ids;
+	std::vector<int32_t> remap;
+	for (const std::shared_ptr<Tile> &tile : p_job.tiles) {
+		remap.assign(tile->vertices.size(), -1);
+		for (const std::pair<Vector2i, int32_t> &border : tile->border_vertices) {
+			auto found = border_ids.find(border.first);
+			if (found != border_ids.end()) {
+				remap[border.second] = found->second;
+			}
+		}
+		for (int i = 0; i < tile->vertices.size(); i++) {
+			if (remap[i] < 0) {
+				remap[i] = vertex_count;
+				vertices[vertex_count++] = tile->vertices[i];
+			}
+		}
+		for (const std::pair<Vector2i, int32_t> &border : tile->border_vertices) {
+			border_ids.emplace(border.first, remap[border.second]);
+		}
+		for (const int32_t index : tile->indices) {
+			indices[index_count++] = remap[index];
+		}
+	}
+	r_vertices.resize(vertex_count);
+}
+
+// Drops the least recently used tiles until the cache is within CACHE_MAX_BYTES. Assumes locked
+void TerrainGeneratorMeshBaker::_trim_cache() {
+	while (_cache_bytes > CACHE_MAX_BYTES && !_cache.empty()) {
+		auto oldest = _cache.begin();
+		for (auto it = _cache.begin(); it != _cache.end(); ++it) {
+			if (it->second.last_used < oldest->second.last_used) {
+				oldest = it;
+			}
+		}
+		_cache_bytes -= oldest->second.tile->get_bytes();
+		_cache.erase(oldest);
+	}
+}
+
+///////////////////////////
+// Public Functions
+///////////////////////////
+
+/**
+ * Bakes indexed triangles of the terrain, in global coordinates.
+ * p_use_cache: Reuse tiles baked with the same settings that haven't been edited since, and keep new ones.
+ * Main thread only, as the maps are read from the live regions.
+ */
+void TerrainGeneratorMeshBaker::bake(const BakeSettings &p_settings, const bool p_use_cache,
+		PackedVector3Array &r_vertices, PackedInt32Array &r_indices) {
+	r_vertices.clear();
+	r_indices.clear();
+	ERR_FAIL_COND(_terrain == nullptr || _terrain->get_data() == nullptr);
+	uint64_t start_time = Time::get_singleton()->get_ticks_usec();
+	BakeJob job;
+	job.settings = p_settings;
+	job.step = 1 << CLAMP(p_settings.lod, 0, 8);
+	job.maps.create(_terrain->get_data());
+	if (job.maps.is_empty()) {
+		return;
+	}
+	std::vector<Rect2i> areas;
+	_get_tile_areas(job, areas);
+
+	uint64_t epoch = 0;
+	job.tiles.resize(areas.size());
+	std::vector<uint64_t> generations(areas.size(), 0);
+	{
+		MutexLock lock(_cache_mutex);
+		epoch = _cache_epoch;
+		for (int i = 0; i < areas.size(); i++) {
+			if (p_use_cache) {
+				// Cells extend up to a step past the tile, and the minimum filter reads half a step around vertices
+				generations[i] = _terrain->get_data()->get_map_generation(areas[i].grow(job.step + 1));
+				auto cached = _cache.find(areas[i].position);
+				if (cached != _cache.end() && cached->second.tile->area == areas[i] && cached->second.settings == p_settings &&
+						cached->second.map_generation == generations[i]) {
+					cached->second.last_used = ++_use_count;
+					job.tiles[i] = cached->second.tile;
+					continue;
+				}
+			}
+			job.tiles[i] = std::make_shared<Tile>();
+			job.tiles[i]->area = areas[i];
+			job.bake_ids.push_back(i);
+		}
+	}
+
+	if (!job.bake_ids.empty()) {
+		WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+		WorkerThreadPool::GroupID task_id = wtp->add_template_group_task(this, &TerrainGeneratorMeshBaker::_bake_tile,
+				&job, job.bake_ids.size(), -1, true, "TerrainGenerator mesh bake");
+		wtp->wait_for_group_task_completion(task_id);
+	}
+	job.maps.clear();
+
+	// Only cache if nothing was edited while baking
+	if (p_use_cache) {
+		MutexLock lock(_cache_mutex);
+		if (epoch == _cache_epoch) {
+			for (const int i : job.bake_ids) {
+				CachedTile &entry = _cache[areas[i].position];
+				if (entry.tile) {
+					_cache_bytes -= entry.tile->get_bytes();
+				}
+				entry.tile = job.tiles[i];
+				entry.settings = p_settings;
+				entry.map_generation = generations[i];
+				entry.last_used = ++_use_count;
+				_cache_bytes += entry.tile->get_bytes();
+			}
+			_trim_cache();
+		}
+	}
+
+	_merge_tiles(job, r_vertices, r_indices);
+	LOG(DEBUG, "Baked ", job.bake_ids.size(), " of ", job.tiles.size(), " tiles, ", r_vertices.size(), " vertices, ",
+			r_indices.size() / 3, " triangles in ", Time::get_singleton()->get_ticks_usec() - start_time, " us");
+}
+
+// Drops cached tiles touching the edited area, so the next bake only redoes those
+void TerrainGeneratorMeshBaker::invalidate(const AABB &p_global_area) {
+	if (!_terrain) {
+		return;
+	}
+	real_t spacing = _terrain->get_vertex_spacing();
+	Vector2i area_min = Vector2i(Math::floor(p_global_area.position.x / spacing), Math::floor(p_global_area.position.z / spacing));
+	Vector2i area_max = Vector2i(Math::ceil(p_global_area.get_end().x / spacing), Math::ceil(p_global_area.get_end().z / spacing));
+	Rect2i area(area_min, area_max - area_min + V2I(1));
+
+	MutexLock lock(_cache_mutex);
+	_cache_epoch++;
+	int erased = 0;
+	for (auto it = _cache.begin(); it != _cache.end();) {
+		// Cells extend up to a step past the tile, and the minimum filter reads half a step around vertices
+		int32_t step = 1 << CLAMP(it->second.settings.lod, 0, 8);
+		if (area.intersects(it->second.tile->area.grow(step + 1))) {
+			_cache_bytes -= it->second.tile->get_bytes();
+			it = _cache.erase(it);
+			erased++;
+		} else {
+			++it;
+		}
+	}
+	LOG(EXTREME, "Edited area ", area, " invalidated ", erased, " baked tiles");
+}
+
+void TerrainGeneratorMeshBaker::clear_cache() {
+	MutexLock lock(_cache_mutex);
+	_cache_epoch++;
+	_cache.clear();
+	_cache_bytes = 0;
+}
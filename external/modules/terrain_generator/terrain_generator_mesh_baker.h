@@ -0,0 +1,87 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/os/mutex.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "constants.h"
+#include "map_snapshot.h"
+#include "terrain_generator_data.h"
+
+class TerrainGenerator;
+
+// Bakes the terrain into indexed triangles for bake_mesh() and navigation source geometry.
+// The area is split into tiles on a TILE_SIZE grid, baked in parallel on the WorkerThreadPool. Whole
+// terrain bakes are also split on region boundaries, while AABB bakes may span several regions when
+// region_size is below TILE_SIZE. Tiles may be cached, and are baked again once a region map they
+// read has changed since. bake() snapshots the live regions, so it must be called on the main thread.
+class TerrainGeneratorMeshBaker {
+	CLASS_NAME_STATIC("TerrainGeneratorMeshBaker");
+
+public: // Constants
+	static inline const int TILE_SIZE = 256; // Max descaled vertices per tile side
+	static inline const uint64_t CACHE_MAX_BYTES = 256 * 1024 * 1024;
+
+	struct BakeSettings {
+		int32_t lod = 0;
+		TerrainGeneratorData::HeightFilter filter = TerrainGeneratorData::HEIGHT_FILTER_NEAREST;
+		bool require_nav = false;
+		AABB global_aabb; // If it has volume, bake only cells within it with a height in its range
+
+		bool operator==(const BakeSettings &p_other) const {
+			return lod == p_other.lod && filter == p_other.filter && require_nav == p_other.require_nav &&
+					global_aabb == p_other.global_aabb;
+		}
+	};
+
+private:
+	struct Tile {
+		Rect2i area; // Descaled. Cells start at the position, every step until the end
+		std::vector<Vector3> vertices;
+		std::vector<int32_t> indices;
+		std::vector<std::pair<Vector2i, int32_t>> border_vertices; // Shared with adjacent tiles
+		uint64_t get_bytes() const;
+	};
+
+	struct BakeJob {
+		BakeSettings settings;
+		int32_t step = 1;
+		MapSnapshot maps;
+		std::vector<std::shared_ptr<Tile>> tiles;
+		std::vector<int> bake_ids; // Tiles not found in the cache
+	};
+
+	struct CachedTile {
+		std::shared_ptr<Tile> tile;
+		BakeSettings settings;
+		uint64_t map_generation = 0; // Of the regions read, from TerrainGeneratorData::get_map_generation()
+		uint64_t last_used = 0;
+	};
+
+	TerrainGenerator *_terrain = nullptr;
+
+	Mutex _cache_mutex; // Invalidation may come from signals emitted on any thread
+	std::unordered_map<Vector2i, CachedTile, Vector2iHash> _cache; // By tile area position
+	uint64_t _cache_bytes = 0;
+	uint64_t _cache_epoch = 0; // Incremented on invalidation
+	uint64_t _use_count = 0;
+
+	void _get_tile_areas(const BakeJob &p_job, std::vector<Rect2i> &r_areas) const;
+	real_t _sample_height(const MapSnapshot &p_maps, const BakeJob &p_job, const int p_x, const int p_z, const uint32_t p_control) const;
+	void _bake_tile(const uint32_t p_index, BakeJob *p_job);
+	void _merge_tiles(const BakeJob &p_job, PackedVector3Array &r_vertices, PackedInt32Array &r_indices) const;
+	void _trim_cache();
+
+public:
+	TerrainGeneratorMeshBaker() {}
+	~TerrainGeneratorMeshBaker() { clear_cache(); }
+	void initialize(TerrainGenerator *p_terrain) { _terrain = p_terrain; }
+
+	void bake(const BakeSettings &p_settings, const bool p_use_cache, PackedVector3Array &r_vertices, PackedInt32Array &r_indices);
+	void invalidate(const AABB &p_global_area);
+	void clear_cache();
+	uint64_t get_cache_bytes() const { return _cache_bytes; }
+};
@@ -7,6 +7,7 @@
 #include "logger.h"
 #include "terrain_generator.h"
 #include "terrain_generator_mesher.h"
+#include "terrain_generator_profiler.h"
 
 ///////////////////////////
 // Private Functions
@@ -315,6 +316,7 @@ void TerrainGeneratorMesher::destroy() {
 
 void TerrainGeneratorMesher::snap() {
 	IS_INIT(VOID);
+	TerrainGeneratorProfiler::Scope profile(TerrainGeneratorProfiler::MESHER);
 	// If clipmap target has moved enough, re-center terrain on the target.
 	Vector3 target_pos = _terrain->get_clipmap_target_position();
 	Vector2 target_pos_2d = v3v2(target_pos);
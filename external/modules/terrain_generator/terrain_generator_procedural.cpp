@@ -0,0 +1,607 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include <godot/core/object/worker_thread_pool.h>
+#include <godot/core/os/time.h>
+
+#include "logger.h"
+#include "terrain_generator_data.h"
+#include "terrain_generator_procedural.h"
+#include "terrain_generator_util.h"
+
+/////////////////////
+// Noise Functions
+/////////////////////
+
+static inline uint32_t hash_lattice(const int64_t p_x, const int64_t p_y, const uint32_t p_seed) {
+	uint32_t h = p_seed;
+	h ^= uint32_t(p_x) * 0x8da6b343u;
+	h ^= uint32_t(p_y) * 0xd8163841u;
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	h *= 0x846ca68bu;
+	h ^= h >> 16;
+	return h;
+}
+
+// Dot product of the offset with one of 8 gradients picked by the hash
+static inline float lattice_gradient(const uint32_t p_hash, const float p_x, const float p_y) {
+	switch (p_hash & 7) {
+		case 0:
+			return p_x + p_y;
+		case 1:
+			return p_x - p_y;
+		case 2:
+			return -p_x + p_y;
+		case 3:
+			return -p_x - p_y;
+		case 4:
+			return p_x;
+		case 5:
+			return -p_x;
+		case 6:
+			return p_y;
+		default:
+			return -p_y;
+	}
+}
+
+static inline float fade(const float p_t) {
+	return p_t * p_t * p_t * (p_t * (p_t * 6.f - 15.f) + 10.f);
+}
+
+// Gradient noise from about -1 to 1. Coordinates are doubles so the fraction stays precise far
+// from the origin.
+static float gradient_noise(const double p_x, const double p_y, const uint32_t p_seed) {
+	double x0 = Math::floor(p_x);
+	double y0 = Math::floor(p_y);
+	int64_t ix = int64_t(x0);
+	int64_t iy = int64_t(y0);
+	float fx = float(p_x - x0);
+	float fy = float(p_y - y0);
+	float n00 = lattice_gradient(hash_lattice(ix, iy, p_seed), fx, fy);
+	float n10 = lattice_gradient(hash_lattice(ix + 1, iy, p_seed), fx - 1.f, fy);
+	float n01 = lattice_gradient(hash_lattice(ix, iy + 1, p_seed), fx, fy - 1.f);
+	float n11 = lattice_gradient(hash_lattice(ix + 1, iy + 1, p_seed), fx - 1.f, fy - 1.f);
+	float u = fade(fx);
+	float v = fade(fy);
+	return Math::lerp(Math::lerp(n00, n10, u), Math::lerp(n01, n11, u), v);
+}
+
+// Fractal Brownian motion, from about -1 to 1
+static float fbm_noise(const double p_x, const double p_y, const TerrainGeneratorProceduralStage *p_stage, const uint32_t p_seed) {
+	float sum = 0.f;
+	float amplitude = 1.f;
+	float norm = 0.f;
+	double frequency = 1.0;
+	for (int o = 0; o < p_stage->get_octaves(); o++) {
+		sum += amplitude * gradient_noise(p_x * frequency, p_y * frequency, p_seed + uint32_t(o) * 0x9e3779b9u);
+		norm += amplitude;
+		amplitude *= p_stage->get_gain();
+		frequency *= p_stage->get_lacunarity();
+	}
+	return (norm > 0.f) ? sum / norm : 0.f;
+}
+
+// Ridged multifractal from 0 to 1. Each octave is weighted by the previous one, so detail
+// collects along the ridges.
+static float ridged_noise(const double p_x, const double p_y, const TerrainGeneratorProceduralStage *p_stage, const uint32_t p_seed) {
+	float sum = 0.f;
+	float amplitude = 1.f;
+	float norm = 0.f;
+	float weight = 1.f;
+	double frequency = 1.0;
+	for (int o = 0; o < p_stage->get_octaves(); o++) {
+		float n = 1.f - Math::abs(gradient_noise(p_x * frequency, p_y * frequency, p_seed + uint32_t(o) * 0x9e3779b9u));
+		n *= n * weight;
+		weight = CLAMP(n * 2.f, 0.f, 1.f);
+		sum += amplitude * n;
+		norm += amplitude;
+		amplitude *= p_stage->get_gain();
+		frequency *= p_stage->get_lacunarity();
+	}
+	return (norm > 0.f) ? sum / norm : 0.f;
+}
+
+// 1 within the range, easing to 0 over the falloff outside of it
+static inline float range_weight(const float p_value, const Vector2 &p_range, const float p_falloff) {
+	if (p_falloff <= 0.f) {
+		return (p_value >= p_range.x && p_value <= p_range.y) ? 1.f : 0.f;
+	}
+	float low = CLAMP((p_value - (p_range.x - p_falloff)) / p_falloff, 0.f, 1.f);
+	float high = CLAMP(((p_range.y + p_falloff) - p_value) / p_falloff, 0.f, 1.f);
+	return Math::smoothstep(0.f, 1.f, low) * Math::smoothstep(0.f, 1.f, high);
+}
+
+static inline float biome_weight(const float p_biome, const TerrainGeneratorProceduralStage *p_stage) {
+	return range_weight(p_biome, p_stage->get_biome_range(), p_stage->get_biome_falloff());
+}
+
+/////////////////////
+// Private Functions
+/////////////////////
+
+std::vector<const TerrainGeneratorProceduralStage *> TerrainGeneratorProcedural::_get_enabled_stages() const {
+	std::vector<const TerrainGeneratorProceduralStage *> stages;
+	for (int i = 0; i < _stages.size(); i++) {
+		Ref<TerrainGeneratorProceduralStage> stage = _stages[i];
+		if (stage.is_valid() && stage->is_enabled()) {
+			stages.push_back(stage.ptr());
+		}
+	}
+	return stages;
+}
+
+// Depends only on the seeds, so reordering stages does not change their noise
+uint32_t TerrainGeneratorProcedural::_get_stage_seed(const TerrainGeneratorProceduralStage *p_stage) const {
+	return hash_lattice(_seed, p_stage->get_seed_offset(), 0x5bd1e995u);
+}
+
+void TerrainGeneratorProcedural::_run_pass(GenerateJob &p_job, const Pass p_pass) {
+	p_job.pass = p_pass;
+	p_job.stage_seeds.resize(p_job.stages.size());
+	for (uint32_t i = 0; i < p_job.stages.size(); i++) {
+		p_job.stage_seeds[i] = _get_stage_seed(p_job.stages[i]);
+	}
+	int rows = (p_pass == PASS_PAINT) ? p_job.region_size : p_job.width;
+	int strip_count = (rows + p_job.strip_rows - 1) / p_job.strip_rows;
+	if (strip_count > 1) {
+		WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+		WorkerThreadPool::GroupID task_id = wtp->add_template_group_task(this, &TerrainGeneratorProcedural::_process_strip,
+				&p_job, strip_count, -1, true, "TerrainGenerator procedural pass");
+		wtp->wait_for_group_task_completion(task_id);
+	} else {
+		_process_strip(0, &p_job);
+	}
+}
+
+void TerrainGeneratorProcedural::_process_strip(const uint32_t p_index, GenerateJob *p_job) {
+	int rows = (p_job->pass == PASS_PAINT) ? p_job->region_size : p_job->width;
+	int y_start = p_index * p_job->strip_rows;
+	int y_end = MIN(y_start + p_job->strip_rows, rows);
+	switch (p_job->pass) {
+		case PASS_SHAPE:
+			_shape_rows(p_job, y_start, y_end);
+			break;
+		case PASS_THERMAL:
+			_thermal_rows(p_job, y_start, y_end);
+			break;
+		case PASS_HYDRAULIC_FLOW:
+			_flow_rows(p_job, y_start, y_end);
+			break;
+		case PASS_HYDRAULIC_TRANSPORT:
+			_transport_rows(p_job, y_start, y_end);
+			break;
+		case PASS_PAINT:
+			_paint_rows(p_job, y_start, y_end);
+			break;
+	}
+}
+
+// Applies consecutive noise and biome stages per pixel
+void TerrainGeneratorProcedural::_shape_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const {
+	const int width = p_job->width;
+	const double spacing = p_job->vertex_spacing;
+	for (int y = p_y_start; y < p_y_end; y++) {
+		double world_y = double(p_job->origin.y + y) * spacing;
+		for (int x = 0; x < width; x++) {
+			double world_x = double(p_job->origin.x + x) * spacing;
+			int i = y * width + x;
+			float height = p_job->heights[i];
+			for (uint32_t s = 0; s < p_job->stages.size(); s++) {
+				const TerrainGeneratorProceduralStage *stage = p_job->stages[s];
+				double nx = world_x * stage->get_frequency();
+				double ny = world_y * stage->get_frequency();
+				uint32_t seed = p_job->stage_seeds[s];
+				if (stage->get_type() == TerrainGeneratorProceduralStage::STAGE_BIOME_MASK) {
+					p_job->biome[i] = CLAMP(0.5f + fbm_noise(nx, ny, stage, seed), 0.f, 1.f);
+					continue;
+				}
+				float noise = (stage->get_type() == TerrainGeneratorProceduralStage::STAGE_RIDGED_NOISE) ? ridged_noise(nx, ny, stage, seed) : fbm_noise(nx, ny, stage, seed);
+				float value = noise * stage->get_amplitude() + stage->get_height_offset();
+				float weight = stage->get_strength() * biome_weight(p_job->biome[i], stage);
+				switch (stage->get_operation()) {
+					case TerrainGeneratorProceduralStage::OP_ADD:
+						height += value * weight;
+						break;
+					case TerrainGeneratorProceduralStage::OP_SUBTRACT:
+						height -= value * weight;
+						break;
+					case TerrainGeneratorProceduralStage::OP_MAX:
+						height = Math::lerp(height, MAX(height, value), weight);
+						break;
+					case TerrainGeneratorProceduralStage::OP_MIN:
+						height = Math::lerp(height, MIN(height, value), weight);
+						break;
+				}
+			}
+			p_job->heights[i] = height;
+		}
+	}
+}
+
+// Moves material from each pixel to lower neighbors where the drop exceeds the talus angle.
+// The exchange between two pixels is computed the same way from both sides, so it conserves mass.
+void TerrainGeneratorProcedural::_thermal_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const {
+	const TerrainGeneratorProceduralStage *stage = p_job->stages[0];
+	const int width = p_job->width;
+	const float talus = Math::tan(Math::deg_to_rad(stage->get_talus_angle())) * p_job->vertex_spacing;
+	const float rate = stage->get_strength() * 0.125f;
+	const float *heights = p_job->heights.data();
+	float *heights_back = p_job->heights_back.data();
+	for (int y = p_y_start; y < p_y_end; y++) {
+		int up = MAX(y - 1, 0) * width;
+		int down = MIN(y + 1, width - 1) * width;
+		for (int x = 0; x < width; x++) {
+			int i = y * width + x;
+			int neighbors[4] = { y * width + MAX(x - 1, 0), y * width + MIN(x + 1, width - 1), up + x, down + x };
+			float height = heights[i];
+			float delta = 0.f;
+			for (int n = 0; n < 4; n++) {
+				float drop = heights[neighbors[n]] - height;
+				if (drop > talus) {
+					delta += rate * (drop - talus);
+				} else if (drop < -talus) {
+					delta -= rate * (-drop - talus);
+				}
+			}
+			heights_back[i] = height + delta;
+		}
+	}
+}
+
+// First half of a hydraulic iteration: splits each pixel's outflow of water between its lower
+// neighbors, by the drop of the water surface
+void TerrainGeneratorProcedural::_flow_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const {
+	const int width = p_job->width;
+	const float *heights = p_job->heights.data();
+	const float *water = p_job->water.data();
+	float *outflow = p_job->outflow.data();
+	for (int y = p_y_start; y < p_y_end; y++) {
+		int up = MAX(y - 1, 0) * width;
+		int down = MIN(y + 1, width - 1) * width;
+		for (int x = 0; x < width; x++) {
+			int i = y * width + x;
+			float *out = outflow + i * 4;
+			out[0] = out[1] = out[2] = out[3] = 0.f;
+			float depth = water[i];
+			if (depth <= 0.f) {
+				continue;
+			}
+			int neighbors[4] = { y * width + MAX(x - 1, 0), y * width + MIN(x + 1, width - 1), up + x, down + x };
+			float surface = heights[i] + depth;
+			float drops[4];
+			float total = 0.f;
+			for (int n = 0; n < 4; n++) {
+				float drop = surface - heights[neighbors[n]] - water[neighbors[n]];
+				drops[n] = MAX(drop, 0.f);
+				total += drops[n];
+			}
+			if (total <= 0.f) {
+				continue;
+			}
+			// Moving a quarter of the drop levels the surfaces without overshooting
+			float moved = MIN(depth, total * 0.25f);
+			for (int n = 0; n < 4; n++) {
+				out[n] = moved * drops[n] / total;
+			}
+		}
+	}
+}
+
+// Second half of a hydraulic iteration: gathers water and suspended sediment from neighbors,
+// then erodes or deposits toward the sediment capacity of the flow
+void TerrainGeneratorProcedural::_transport_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const {
+	const TerrainGeneratorProceduralStage *stage = p_job->stages[0];
+	const int width = p_job->width;
+	const float spacing = p_job->vertex_spacing;
+	const float *heights = p_job->heights.data();
+	const float *water = p_job->water.data();
+	const float *sediment = p_job->sediment.data();
+	const float *outflow = p_job->outflow.data();
+	float *heights_back = p_job->heights_back.data();
+	float *water_back = p_job->water_back.data();
+	float *sediment_back = p_job->sediment_back.data();
+	for (int y = p_y_start; y < p_y_end; y++) {
+		int up = MAX(y - 1, 0) * width;
+		int down = MIN(y + 1, width - 1) * width;
+		for (int x = 0; x < width; x++) {
+			int i = y * width + x;
+			// Left, right, up, down. Each neighbor sends water through its outflow facing this pixel
+			int neighbors[4] = { y * width + MAX(x - 1, 0), y * width + MIN(x + 1, width - 1), up + x, down + x };
+			static const int facing[4] = { 1, 0, 3, 2 };
+			const float *out = outflow + i * 4;
+			float out_total = out[0] + out[1] + out[2] + out[3];
+			float depth = water[i];
+			float carried = (depth > 0.f) ? sediment[i] * out_total / depth : 0.f;
+			float in_water = 0.f;
+			float in_sediment = 0.f;
+			float lowest = FLT_MAX;
+			for (int n = 0; n < 4; n++) {
+				int ni = neighbors[n];
+				lowest = MIN(lowest, heights[ni]);
+				if (ni == i) {
+					continue;
+				}
+				float flow = outflow[ni * 4 + facing[n]];
+				if (flow > 0.f) {
+					in_water += flow;
+					in_sediment += sediment[ni] * flow / water[ni];
+				}
+			}
+			float height = heights[i];
+			float new_water = depth - out_total + in_water;
+			float new_sediment = sediment[i] - carried + in_sediment;
+
+			float grad_x = (heights[neighbors[1]] - heights[neighbors[0]]) / (2.f * spacing);
+			float grad_y = (heights[neighbors[3]] - heights[neighbors[2]]) / (2.f * spacing);
+			float slope = MAX(Math::sqrt(grad_x * grad_x + grad_y * grad_y), 0.01f);
+			float capacity = stage->get_sediment_capacity() * (out_total + in_water) * 0.5f * slope;
+			if (new_sediment > capacity) {
+				float deposit = stage->get_deposition_rate() * (new_sediment - capacity);
+				height += deposit;
+				new_sediment -= deposit;
+			} else {
+				// Never dig below the lowest neighbor, which would leave pits
+				float erode = stage->get_erosion_rate() * (capacity - new_sediment);
+				erode = MIN(erode, MAX((height - lowest) * 0.5f, 0.f));
+				height -= erode;
+				new_sediment += erode;
+			}
+			if (p_job->settle) {
+				height += new_sediment;
+				new_sediment = 0.f;
+			}
+			heights_back[i] = height;
+			water_back[i] = new_water * (1.f - stage->get_evaporation()) + stage->get_rain();
+			sediment_back[i] = new_sediment;
+		}
+	}
+}
+
+// Writes the region maps, applying texture and color stages on the final heights
+void TerrainGeneratorProcedural::_paint_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const {
+	const int width = p_job->width;
+	const int region_size = p_job->region_size;
+	const int apron = p_job->apron;
+	const float spacing = p_job->vertex_spacing;
+	const float *heights = p_job->heights.data();
+	for (int y = p_y_start; y < p_y_end; y++) {
+		for (int x = 0; x < region_size; x++) {
+			int bx = x + apron;
+			int by = y + apron;
+			int i = by * width + bx;
+			float height = heights[i];
+			uint8_t base = 0;
+			uint8_t overlay = 0;
+			float blend = 0.f;
+			Color color = COLOR_ROUGHNESS;
+			if (!p_job->stages.empty()) {
+				// The apron is at least 1 pixel, so the neighbors are always in the buffer
+				float grad_x = (heights[i + 1] - heights[i - 1]) / (2.f * spacing);
+				float grad_y = (heights[i + width] - heights[i - width]) / (2.f * spacing);
+				float slope = Math::rad_to_deg(Math::atan(Math::sqrt(grad_x * grad_x + grad_y * grad_y)));
+				float biome = p_job->biome[i];
+				for (const TerrainGeneratorProceduralStage *stage : p_job->stages) {
+					float weight = stage->get_strength() * biome_weight(biome, stage) *
+							range_weight(height, stage->get_height_range(), stage->get_height_falloff()) *
+							range_weight(slope, stage->get_slope_range(), stage->get_slope_falloff());
+					if (weight <= 0.f) {
+						continue;
+					}
+					if (stage->get_type() == TerrainGeneratorProceduralStage::STAGE_COLOR) {
+						color = color.lerp(stage->get_color(), weight);
+					} else if (weight >= 1.f) {
+						base = stage->get_texture_id();
+						blend = 0.f;
+					} else {
+						overlay = stage->get_texture_id();
+						blend = weight;
+					}
+				}
+			}
+			int out = y * region_size + x;
+			p_job->height_out[out] = height;
+			p_job->control_out[out] = p_job->has_texture_stages ? (enc_base(base) | enc_overlay(overlay) | enc_blend(uint8_t(blend * 255.f))) : enc_auto(true);
+			uint8_t *color_out = p_job->color_out + out * 4;
+			color_out[0] = uint8_t(CLAMP(color.r * 255.f + .5f, 0.f, 255.f));
+			color_out[1] = uint8_t(CLAMP(color.g * 255.f + .5f, 0.f, 255.f));
+			color_out[2] = uint8_t(CLAMP(color.b * 255.f + .5f, 0.f, 255.f));
+			color_out[3] = uint8_t(CLAMP(color.a * 255.f + .5f, 0.f, 255.f));
+		}
+	}
+}
+
+/////////////////////
+// Public Functions
+/////////////////////
+
+void TerrainGeneratorProcedural::set_seed(const int p_seed) {
+	LOG(INFO, "Setting seed: ", p_seed);
+	_seed = p_seed;
+	emit_changed();
+}
+
+void TerrainGeneratorProcedural::set_base_height(const real_t p_height) {
+	_base_height = CLAMP(p_height, -10000.f, 10000.f);
+	LOG(INFO, "Setting base height: ", _base_height);
+	emit_changed();
+}
+
+void TerrainGeneratorProcedural::set_generate_blank_regions(const bool p_enabled) {
+	LOG(INFO, "Setting generate blank regions: ", p_enabled);
+	_generate_blank_regions = p_enabled;
+	emit_changed();
+}
+
+void TerrainGeneratorProcedural::set_stages(const TypedArray<TerrainGeneratorProceduralStage> &p_stages) {
+	LOG(INFO, "Setting stages: ", p_stages.size());
+	_stages = p_stages;
+	emit_changed();
+}
+
+// Pixels generated beyond each region edge. See TerrainGeneratorProceduralStage::get_apron()
+// The extra pixel is for the slope of texture and color stages.
+int TerrainGeneratorProcedural::get_apron() const {
+	int apron = 1;
+	for (const TerrainGeneratorProceduralStage *stage : _get_enabled_stages()) {
+		apron += stage->get_apron();
+	}
+	return apron;
+}
+
+// Replaces the height, control and color maps of the region. It must have a location and size.
+Error TerrainGeneratorProcedural::generate_region(const Ref<TerrainGeneratorRegion> &p_region) {
+	if (p_region.is_null()) {
+		LOG(ERROR, "Provided region is null");
+		return FAILED;
+	}
+	Vector2i region_loc = p_region->get_location();
+	int region_size = p_region->get_region_size();
+	if (region_loc.x == INT32_MAX || region_size <= 0) {
+		LOG(ERROR, "Region has not been setup. Location: ", region_loc, ", size: ", region_size);
+		return FAILED;
+	}
+	uint64_t start_time = Time::get_singleton()->get_ticks_usec();
+	std::vector<const TerrainGeneratorProceduralStage *> stages = _get_enabled_stages();
+
+	GenerateJob job;
+	job.region_size = region_size;
+	job.vertex_spacing = p_region->get_vertex_spacing();
+	job.apron = get_apron();
+	job.width = region_size + job.apron * 2;
+	job.origin = region_loc * region_size - V2I(job.apron);
+	int threads = MAX(1, WorkerThreadPool::get_singleton()->get_thread_count());
+	job.strip_rows = CLAMP(job.width / (threads * 2), MIN_STRIP_ROWS, MAX_STRIP_ROWS);
+
+	const size_t pixels = size_t(job.width) * job.width;
+	job.heights.assign(pixels, _base_height);
+	job.biome.assign(pixels, 0.f);
+	std::vector<const TerrainGeneratorProceduralStage *> shape_stages;
+	std::vector<const TerrainGeneratorProceduralStage *> paint_stages;
+	// Consecutive noise and biome stages share a pass
+	auto run_shape_stages = [&]() {
+		if (!shape_stages.empty()) {
+			job.stages = shape_stages;
+			_run_pass(job, PASS_SHAPE);
+			shape_stages.clear();
+		}
+	};
+	for (const TerrainGeneratorProceduralStage *stage : stages) {
+		switch (stage->get_type()) {
+			case TerrainGeneratorProceduralStage::STAGE_THERMAL_EROSION: {
+				run_shape_stages();
+				job.stages = { stage };
+				job.heights_back.resize(pixels);
+				for (int it = 0; it < stage->get_iterations(); it++) {
+					_run_pass(job, PASS_THERMAL);
+					job.heights.swap(job.heights_back);
+				}
+				break;
+			}
+			case TerrainGeneratorProceduralStage::STAGE_HYDRAULIC_EROSION: {
+				run_shape_stages();
+				job.stages = { stage };
+				job.heights_back.resize(pixels);
+				job.water.assign(pixels, stage->get_rain());
+				job.water_back.resize(pixels);
+				job.sediment.assign(pixels, 0.f);
+				job.sediment_back.resize(pixels);
+				job.outflow.resize(pixels * 4);
+				for (int it = 0; it < stage->get_iterations(); it++) {
+					job.settle = (it == stage->get_iterations() - 1);
+					_run_pass(job, PASS_HYDRAULIC_FLOW);
+					_run_pass(job, PASS_HYDRAULIC_TRANSPORT);
+					job.heights.swap(job.heights_back);
+					job.water.swap(job.water_back);
+					job.sediment.swap(job.sediment_back);
+				}
+				job.settle = false;
+				break;
+			}
+			case TerrainGeneratorProceduralStage::STAGE_TEXTURE:
+				job.has_texture_stages = true;
+				paint_stages.push_back(stage);
+				break;
+			case TerrainGeneratorProceduralStage::STAGE_COLOR:
+				paint_stages.push_back(stage);
+				break;
+			default:
+				shape_stages.push_back(stage);
+				break;
+		}
+	}
+	run_shape_stages();
+
+	PackedByteArray map_data[TYPE_MAX];
+	map_data[TYPE_HEIGHT].resize(region_size * region_size * sizeof(float));
+	map_data[TYPE_CONTROL].resize(region_size * region_size * sizeof(uint32_t));
+	map_data[TYPE_COLOR].resize(region_size * region_size * 4);
+	job.height_out = reinterpret_cast<float *>(map_data[TYPE_HEIGHT].ptrw());
+	job.control_out = reinterpret_cast<uint32_t *>(map_data[TYPE_CONTROL].ptrw());
+	job.color_out = map_data[TYPE_COLOR].ptrw();
+	job.stages = paint_stages;
+	_run_pass(job, PASS_PAINT);
+
+	p_region->set_height_map(Image::create_from_data(region_size, region_size, false, Image::FORMAT_RF, map_data[TYPE_HEIGHT]));
+	p_region->set_control_map(Image::create_from_data(region_size, region_size, false, Image::FORMAT_RF, map_data[TYPE_CONTROL]));
+	Ref<Image> color_map = Image::create_from_data(region_size, region_size, false, Image::FORMAT_RGBA8, map_data[TYPE_COLOR]);
+	color_map->generate_mipmaps();
+	p_region->set_color_map(color_map);
+	p_region->set_modified(true);
+	LOG(DEBUG, "Generated region ", region_loc, " with apron ", job.apron, " in ",
+			(Time::get_singleton()->get_ticks_usec() - start_time) / 1000, "ms");
+	return OK;
+}
+
+// Generates regions that are discarded, reporting the throughput
+Dictionary TerrainGeneratorProcedural::benchmark(const int p_region_size, const int p_region_count, const real_t p_vertex_spacing) {
+	int region_size = CLAMP(p_region_size, 64, 2048);
+	int count = CLAMP(p_region_count, 1, TerrainGeneratorData::REGION_MAP_SIZE * TerrainGeneratorData::REGION_MAP_SIZE);
+	int half = TerrainGeneratorData::REGION_MAP_SIZE / 2;
+	uint64_t start_time = Time::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < count; i++) {
+		Ref<TerrainGeneratorRegion> region;
+		region.instantiate();
+		region->set_region_size(region_size);
+		region->set_vertex_spacing(p_vertex_spacing);
+		region->set_location(Vector2i(i % TerrainGeneratorData::REGION_MAP_SIZE - half, i / TerrainGeneratorData::REGION_MAP_SIZE - half));
+		generate_region(region);
+	}
+	double seconds = MAX(double(Time::get_singleton()->get_ticks_usec() - start_time) / 1000000.0, 0.000001);
+
+	Dictionary result;
+	result["regions"] = count;
+	result["region_size"] = region_size;
+	result["apron"] = get_apron();
+	result["threads"] = WorkerThreadPool::get_singleton()->get_thread_count();
+	result["seconds"] = seconds;
+	result["regions_per_second"] = double(count) / seconds;
+	result["megapixels_per_second"] = double(count) * region_size * region_size / 1000000.0 / seconds;
+	LOG(MESG, "Generated ", count, " regions of ", region_size, " in ", vformat("%.3f", seconds), "s, ",
+			vformat("%.2f", double(count) / seconds), " regions/s");
+	return result;
+}
+
+/////////////////////
+// Protected Functions
+/////////////////////
+
+void TerrainGeneratorProcedural::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_seed", "seed"), &TerrainGeneratorProcedural::set_seed);
+	ClassDB::bind_method(D_METHOD("get_seed"), &TerrainGeneratorProcedural::get_seed);
+	ClassDB::bind_method(D_METHOD("set_base_height", "height"), &TerrainGeneratorProcedural::set_base_height);
+	ClassDB::bind_method(D_METHOD("get_base_height"), &TerrainGeneratorProcedural::get_base_height);
+	ClassDB::bind_method(D_METHOD("set_generate_blank_regions", "enabled"), &TerrainGeneratorProcedural::set_generate_blank_regions);
+	ClassDB::bind_method(D_METHOD("get_generate_blank_regions"), &TerrainGeneratorProcedural::get_generate_blank_regions);
+	ClassDB::bind_method(D_METHOD("set_stages", "stages"), &TerrainGeneratorProcedural::set_stages);
+	ClassDB::bind_method(D_METHOD("get_stages"), &TerrainGeneratorProcedural::get_stages);
+	ClassDB::bind_method(D_METHOD("get_apron"), &TerrainGeneratorProcedural::get_apron);
+	ClassDB::bind_method(D_METHOD("generate_region", "region"), &TerrainGeneratorProcedural::generate_region);
+	ClassDB::bind_method(D_METHOD("benchmark", "region_size", "region_count", "vertex_spacing"), &TerrainGeneratorProcedural::benchmark, DEFVAL(256), DEFVAL(16), DEFVAL(1.f));
+
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "seed"), "set_seed", "get_seed");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "base_height", PROPERTY_HINT_RANGE, "-2000.0,2000.0,0.1,or_less,or_greater"), "set_base_height", "get_base_height");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "generate_blank_regions"), "set_generate_blank_regions", "get_generate_blank_regions");
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "stages", PROPERTY_HINT_ARRAY_TYPE, "TerrainGeneratorProceduralStage"), "set_stages", "get_stages");
+}
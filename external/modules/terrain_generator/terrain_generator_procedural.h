@@ -0,0 +1,100 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/io/resource.h>
+#include <vector>
+
+#include "constants.h"
+#include "terrain_generator_procedural_stage.h"
+#include "terrain_generator_region.h"
+
+// Generates region maps from a stack of TerrainGeneratorProceduralStages, applied in order.
+// Noise is a function of the world position and seed, so the result does not depend on which
+// regions are generated, in which order, or on how many threads.
+// Erosion reads neighboring pixels, so each region is generated with an apron around it: wide
+// enough that pixels inside the region match what generating the whole world at once would give.
+// This keeps region borders seamless, at the cost of simulating the apron for every region.
+// Every pass is split into strips of rows, processed in parallel on the WorkerThreadPool.
+// Texture and color stages are evaluated on the final heights after all other stages.
+class TerrainGeneratorProcedural : public Resource {
+	GDCLASS(TerrainGeneratorProcedural, Resource);
+	CLASS_NAME();
+
+public: // Constants
+	static inline const int MIN_STRIP_ROWS = 8;
+	static inline const int MAX_STRIP_ROWS = 64;
+
+private:
+	enum Pass {
+		PASS_SHAPE, // Noise and biome stages
+		PASS_THERMAL,
+		PASS_HYDRAULIC_FLOW,
+		PASS_HYDRAULIC_TRANSPORT,
+		PASS_PAINT, // Texture and color stages, writing the region maps
+	};
+
+	struct GenerateJob {
+		Pass pass = PASS_SHAPE;
+		std::vector<const TerrainGeneratorProceduralStage *> stages; // Of the current pass
+		std::vector<uint32_t> stage_seeds;
+		bool settle = false; // Drop suspended sediment on the last hydraulic iteration
+		bool has_texture_stages = false;
+
+		Vector2i origin = V2I_ZERO; // World pixel of the first buffer pixel
+		int region_size = 0;
+		int apron = 0;
+		int width = 0; // Buffer width and height: the region plus the apron on both sides
+		int strip_rows = MAX_STRIP_ROWS;
+		real_t vertex_spacing = 1.f;
+
+		std::vector<float> heights;
+		std::vector<float> heights_back;
+		std::vector<float> biome;
+		std::vector<float> water;
+		std::vector<float> water_back;
+		std::vector<float> sediment;
+		std::vector<float> sediment_back;
+		std::vector<float> outflow; // Left, right, up, down per pixel
+
+		// Region map data, written by PASS_PAINT
+		float *height_out = nullptr;
+		uint32_t *control_out = nullptr;
+		uint8_t *color_out = nullptr;
+	};
+
+	int _seed = 0;
+	real_t _base_height = 0.f;
+	bool _generate_blank_regions = true;
+	TypedArray<TerrainGeneratorProceduralStage> _stages;
+
+	std::vector<const TerrainGeneratorProceduralStage *> _get_enabled_stages() const;
+	uint32_t _get_stage_seed(const TerrainGeneratorProceduralStage *p_stage) const;
+	void _run_pass(GenerateJob &p_job, const Pass p_pass);
+	void _process_strip(const uint32_t p_index, GenerateJob *p_job);
+	void _shape_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const;
+	void _thermal_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const;
+	void _flow_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const;
+	void _transport_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const;
+	void _paint_rows(GenerateJob *p_job, const int p_y_start, const int p_y_end) const;
+
+public:
+	TerrainGeneratorProcedural() {}
+	~TerrainGeneratorProcedural() {}
+
+	void set_seed(const int p_seed);
+	int get_seed() const { return _seed; }
+	void set_base_height(const real_t p_height);
+	real_t get_base_height() const { return _base_height; }
+	void set_generate_blank_regions(const bool p_enabled);
+	bool get_generate_blank_regions() const { return _generate_blank_regions; }
+	void set_stages(const TypedArray<TerrainGeneratorProceduralStage> &p_stages);
+	TypedArray<TerrainGeneratorProceduralStage> get_stages() const { return _stages; }
+	int get_apron() const;
+
+	Error generate_region(const Ref<TerrainGeneratorRegion> &p_region);
+	Dictionary benchmark(const int p_region_size = 256, const int p_region_count = 16, const real_t p_vertex_spacing = 1.f);
+
+protected:
+	static void _bind_methods();
+};
@@ -0,0 +1,332 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include "logger.h"
+#include "terrain_generator_procedural_stage.h"
+
+///////////////////////////
+// Public Functions
+///////////////////////////
+
+void TerrainGeneratorProceduralStage::set_enabled(const bool p_enabled) {
+	LOG(INFO, "Setting enabled: ", p_enabled);
+	_enabled = p_enabled;
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_type(const StageType p_type) {
+	_type = CLAMP(p_type, STAGE_FBM_NOISE, StageType(STAGE_MAX - 1));
+	LOG(INFO, "Setting stage type: ", _type);
+	notify_property_list_changed(); // Call _validate_property to update inspector
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_strength(const real_t p_strength) {
+	_strength = CLAMP(p_strength, 0.f, 1.f);
+	LOG(INFO, "Setting strength: ", _strength);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_biome_range(const Vector2 &p_range) {
+	_biome_range = Vector2(CLAMP(p_range.x, 0.f, 1.f), CLAMP(p_range.y, 0.f, 1.f));
+	LOG(INFO, "Setting biome range: ", _biome_range);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_biome_falloff(const real_t p_falloff) {
+	_biome_falloff = CLAMP(p_falloff, 0.f, 1.f);
+	LOG(INFO, "Setting biome falloff: ", _biome_falloff);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_seed_offset(const int p_offset) {
+	LOG(INFO, "Setting seed offset: ", p_offset);
+	_seed_offset = p_offset;
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_frequency(const real_t p_frequency) {
+	_frequency = CLAMP(p_frequency, 0.00001f, 1.f);
+	LOG(INFO, "Setting frequency: ", _frequency);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_octaves(const int p_octaves) {
+	_octaves = CLAMP(p_octaves, 1, 12);
+	LOG(INFO, "Setting octaves: ", _octaves);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_lacunarity(const real_t p_lacunarity) {
+	_lacunarity = CLAMP(p_lacunarity, 1.f, 4.f);
+	LOG(INFO, "Setting lacunarity: ", _lacunarity);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_gain(const real_t p_gain) {
+	_gain = CLAMP(p_gain, 0.f, 1.f);
+	LOG(INFO, "Setting gain: ", _gain);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_amplitude(const real_t p_amplitude) {
+	_amplitude = CLAMP(p_amplitude, 0.f, 10000.f);
+	LOG(INFO, "Setting amplitude: ", _amplitude);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_height_offset(const real_t p_offset) {
+	_height_offset = CLAMP(p_offset, -10000.f, 10000.f);
+	LOG(INFO, "Setting height offset: ", _height_offset);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_operation(const Operation p_operation) {
+	_operation = CLAMP(p_operation, OP_ADD, OP_MIN);
+	LOG(INFO, "Setting operation: ", _operation);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_iterations(const int p_iterations) {
+	_iterations = CLAMP(p_iterations, 1, 256);
+	LOG(INFO, "Setting iterations: ", _iterations);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_talus_angle(const real_t p_degrees) {
+	_talus_angle = CLAMP(p_degrees, 0.f, 89.f);
+	LOG(INFO, "Setting talus angle: ", _talus_angle);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_rain(const real_t p_rain) {
+	_rain = CLAMP(p_rain, 0.f, 1.f);
+	LOG(INFO, "Setting rain: ", _rain);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_evaporation(const real_t p_evaporation) {
+	_evaporation = CLAMP(p_evaporation, 0.f, 1.f);
+	LOG(INFO, "Setting evaporation: ", _evaporation);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_sediment_capacity(const real_t p_capacity) {
+	_sediment_capacity = CLAMP(p_capacity, 0.f, 100.f);
+	LOG(INFO, "Setting sediment capacity: ", _sediment_capacity);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_erosion_rate(const real_t p_rate) {
+	_erosion_rate = CLAMP(p_rate, 0.f, 1.f);
+	LOG(INFO, "Setting erosion rate: ", _erosion_rate);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_deposition_rate(const real_t p_rate) {
+	_deposition_rate = CLAMP(p_rate, 0.f, 1.f);
+	LOG(INFO, "Setting deposition rate: ", _deposition_rate);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_texture_id(const int p_texture_id) {
+	_texture_id = CLAMP(p_texture_id, 0, 31);
+	LOG(INFO, "Setting texture id: ", _texture_id);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_color(const Color &p_color) {
+	LOG(INFO, "Setting color: ", p_color);
+	_color = p_color;
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_height_range(const Vector2 &p_range) {
+	LOG(INFO, "Setting height range: ", p_range);
+	_height_range = p_range;
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_height_falloff(const real_t p_falloff) {
+	_height_falloff = CLAMP(p_falloff, 0.f, 1000.f);
+	LOG(INFO, "Setting height falloff: ", _height_falloff);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_slope_range(const Vector2 &p_range) {
+	_slope_range = Vector2(CLAMP(p_range.x, 0.f, 90.f), CLAMP(p_range.y, 0.f, 90.f));
+	LOG(INFO, "Setting slope range: ", _slope_range);
+	emit_changed();
+}
+
+void TerrainGeneratorProceduralStage::set_slope_falloff(const real_t p_falloff) {
+	_slope_falloff = CLAMP(p_falloff, 0.f, 90.f);
+	LOG(INFO, "Setting slope falloff: ", _slope_falloff);
+	emit_changed();
+}
+
+// Pixels beyond the region edge the stage reads, so the result inside matches its neighbors.
+// Each erosion pass reads the adjacent pixels, so errors at the edge of the generated area spread
+// one pixel per pass. Hydraulic iterations have two passes.
+int TerrainGeneratorProceduralStage::get_apron() const {
+	if (!_enabled) {
+		return 0;
+	}
+	switch (_type) {
+		case STAGE_THERMAL_EROSION:
+			return _iterations;
+		case STAGE_HYDRAULIC_EROSION:
+			return _iterations * 2;
+		default:
+			return 0;
+	}
+}
+
+///////////////////////////
+// Protected Functions
+///////////////////////////
+
+void TerrainGeneratorProceduralStage::_validate_property(PropertyInfo &p_property) const {
+	static const char *noise_props[] = { "seed_offset", "frequency", "octaves", "lacunarity", "gain" };
+	static const char *height_props[] = { "amplitude", "height_offset", "operation" };
+	static const char *hydraulic_props[] = { "rain", "evaporation", "sediment_capacity", "erosion_rate", "deposition_rate" };
+	static const char *paint_props[] = { "height_range", "height_falloff", "slope_range", "slope_falloff" };
+	bool visible = true;
+	const String &name = p_property.name;
+	auto has = [&name](const char *const *p_props, const int p_count) {
+		for (int i = 0; i < p_count; i++) {
+			if (name == p_props[i]) {
+				return true;
+			}
+		}
+		return false;
+	};
+	if (has(noise_props, 5)) {
+		visible = is_noise();
+	} else if (has(height_props, 3)) {
+		visible = _type == STAGE_FBM_NOISE || _type == STAGE_RIDGED_NOISE;
+	} else if (name == "iterations") {
+		visible = is_erosion();
+	} else if (name == "talus_angle") {
+		visible = _type == STAGE_THERMAL_EROSION;
+	} else if (has(hydraulic_props, 5)) {
+		visible = _type == STAGE_HYDRAULIC_EROSION;
+	} else if (name == "texture_id") {
+		visible = _type == STAGE_TEXTURE;
+	} else if (name == "color") {
+		visible = _type == STAGE_COLOR;
+	} else if (has(paint_props, 4)) {
+		visible = is_paint();
+	} else if (name == "strength") {
+		visible = _type != STAGE_HYDRAULIC_EROSION && _type != STAGE_BIOME_MASK;
+	} else if (name.begins_with("biome_")) {
+		visible = !is_erosion() && _type != STAGE_BIOME_MASK;
+	} else {
+		return;
+	}
+	p_property.usage = visible ? PROPERTY_USAGE_DEFAULT : PROPERTY_USAGE_NO_EDITOR;
+}
+
+void TerrainGeneratorProceduralStage::_bind_methods() {
+	BIND_ENUM_CONSTANT(STAGE_FBM_NOISE);
+	BIND_ENUM_CONSTANT(STAGE_RIDGED_NOISE);
+	BIND_ENUM_CONSTANT(STAGE_BIOME_MASK);
+	BIND_ENUM_CONSTANT(STAGE_THERMAL_EROSION);
+	BIND_ENUM_CONSTANT(STAGE_HYDRAULIC_EROSION);
+	BIND_ENUM_CONSTANT(STAGE_TEXTURE);
+	BIND_ENUM_CONSTANT(STAGE_COLOR);
+	BIND_ENUM_CONSTANT(STAGE_MAX);
+
+	BIND_ENUM_CONSTANT(OP_ADD);
+	BIND_ENUM_CONSTANT(OP_SUBTRACT);
+	BIND_ENUM_CONSTANT(OP_MAX);
+	BIND_ENUM_CONSTANT(OP_MIN);
+
+	ClassDB::bind_method(D_METHOD("set_enabled", "enabled"), &TerrainGeneratorProceduralStage::set_enabled);
+	ClassDB::bind_method(D_METHOD("is_enabled"), &TerrainGeneratorProceduralStage::is_enabled);
+	ClassDB::bind_method(D_METHOD("set_type", "type"), &TerrainGeneratorProceduralStage::set_type);
+	ClassDB::bind_method(D_METHOD("get_type"), &TerrainGeneratorProceduralStage::get_type);
+	ClassDB::bind_method(D_METHOD("set_strength", "strength"), &TerrainGeneratorProceduralStage::set_strength);
+	ClassDB::bind_method(D_METHOD("get_strength"), &TerrainGeneratorProceduralStage::get_strength);
+	ClassDB::bind_method(D_METHOD("set_biome_range", "range"), &TerrainGeneratorProceduralStage::set_biome_range);
+	ClassDB::bind_method(D_METHOD("get_biome_range"), &TerrainGeneratorProceduralStage::get_biome_range);
+	ClassDB::bind_method(D_METHOD("set_biome_falloff", "falloff"), &TerrainGeneratorProceduralStage::set_biome_falloff);
+	ClassDB::bind_method(D_METHOD("get_biome_falloff"), &TerrainGeneratorProceduralStage::get_biome_falloff);
+
+	ClassDB::bind_method(D_METHOD("set_seed_offset", "offset"), &TerrainGeneratorProceduralStage::set_seed_offset);
+	ClassDB::bind_method(D_METHOD("get_seed_offset"), &TerrainGeneratorProceduralStage::get_seed_offset);
+	ClassDB::bind_method(D_METHOD("set_frequency", "frequency"), &TerrainGeneratorProceduralStage::set_frequency);
+	ClassDB::bind_method(D_METHOD("get_frequency"), &TerrainGeneratorProceduralStage::get_frequency);
+	ClassDB::bind_method(D_METHOD("set_octaves", "octaves"), &TerrainGeneratorProceduralStage::set_octaves);
+	ClassDB::bind_method(D_METHOD("get_octaves"), &TerrainGeneratorProceduralStage::get_octaves);
+	ClassDB::bind_method(D_METHOD("set_lacunarity", "lacunarity"), &TerrainGeneratorProceduralStage::set_lacunarity);
+	ClassDB::bind_method(D_METHOD("get_lacunarity"), &TerrainGeneratorProceduralStage::get_lacunarity);
+	ClassDB::bind_method(D_METHOD("set_gain", "gain"), &TerrainGeneratorProceduralStage::set_gain);
+	ClassDB::bind_method(D_METHOD("get_gain"), &TerrainGeneratorProceduralStage::get_gain);
+	ClassDB::bind_method(D_METHOD("set_amplitude", "amplitude"), &TerrainGeneratorProceduralStage::set_amplitude);
+	ClassDB::bind_method(D_METHOD("get_amplitude"), &TerrainGeneratorProceduralStage::get_amplitude);
+	ClassDB::bind_method(D_METHOD("set_height_offset", "offset"), &TerrainGeneratorProceduralStage::set_height_offset);
+	ClassDB::bind_method(D_METHOD("get_height_offset"), &TerrainGeneratorProceduralStage::get_height_offset);
+	ClassDB::bind_method(D_METHOD("set_operation", "operation"), &TerrainGeneratorProceduralStage::set_operation);
+	ClassDB::bind_method(D_METHOD("get_operation"), &TerrainGeneratorProceduralStage::get_operation);
+
+	ClassDB::bind_method(D_METHOD("set_iterations", "iterations"), &TerrainGeneratorProceduralStage::set_iterations);
+	ClassDB::bind_method(D_METHOD("get_iterations"), &TerrainGeneratorProceduralStage::get_iterations);
+	ClassDB::bind_method(D_METHOD("set_talus_angle", "degrees"), &TerrainGeneratorProceduralStage::set_talus_angle);
+	ClassDB::bind_method(D_METHOD("get_talus_angle"), &TerrainGeneratorProceduralStage::get_talus_angle);
+	ClassDB::bind_method(D_METHOD("set_rain", "rain"), &TerrainGeneratorProceduralStage::set_rain);
+	ClassDB::bind_method(D_METHOD("get_rain"), &TerrainGeneratorProceduralStage::get_rain);
+	ClassDB::bind_method(D_METHOD("set_evaporation", "evaporation"), &TerrainGeneratorProceduralStage::set_evaporation);
+	ClassDB::bind_method(D_METHOD("get_evaporation"), &TerrainGeneratorProceduralStage::get_evaporation);
+	ClassDB::bind_method(D_METHOD("set_sediment_capacity", "capacity"), &TerrainGeneratorProceduralStage::set_sediment_capacity);
+	ClassDB::bind_method(D_METHOD("get_sediment_capacity"), &TerrainGeneratorProceduralStage::get_sediment_capacity);
+	ClassDB::bind_method(D_METHOD("set_erosion_rate", "rate"), &TerrainGeneratorProceduralStage::set_erosion_rate);
+	ClassDB::bind_method(D_METHOD("get_erosion_rate"), &TerrainGeneratorProceduralStage::get_erosion_rate);
+	ClassDB::bind_method(D_METHOD("set_deposition_rate", "rate"), &TerrainGeneratorProceduralStage::set_deposition_rate);
+	ClassDB::bind_method(D_METHOD("get_deposition_rate"), &TerrainGeneratorProceduralStage::get_deposition_rate);
+
+	ClassDB::bind_method(D_METHOD("set_texture_id", "texture_id"), &TerrainGeneratorProceduralStage::set_texture_id);
+	ClassDB::bind_method(D_METHOD("get_texture_id"), &TerrainGeneratorProceduralStage::get_texture_id);
+	ClassDB::bind_method(D_METHOD("set_color", "color"), &TerrainGeneratorProceduralStage::set_color);
+	ClassDB::bind_method(D_METHOD("get_color"), &TerrainGeneratorProceduralStage::get_color);
+	ClassDB::bind_method(D_METHOD("set_height_range", "range"), &TerrainGeneratorProceduralStage::set_height_range);
+	ClassDB::bind_method(D_METHOD("get_height_range"), &TerrainGeneratorProceduralStage::get_height_range);
+	ClassDB::bind_method(D_METHOD("set_height_falloff", "falloff"), &TerrainGeneratorProceduralStage::set_height_falloff);
+	ClassDB::bind_method(D_METHOD("get_height_falloff"), &TerrainGeneratorProceduralStage::get_height_falloff);
+	ClassDB::bind_method(D_METHOD("set_slope_range", "range"), &TerrainGeneratorProceduralStage::set_slope_range);
+	ClassDB::bind_method(D_METHOD("get_slope_range"), &TerrainGeneratorProceduralStage::get_slope_range);
+	ClassDB::bind_method(D_METHOD("set_slope_falloff", "falloff"), &TerrainGeneratorProceduralStage::set_slope_falloff);
+	ClassDB::bind_method(D_METHOD("get_slope_falloff"), &TerrainGeneratorProceduralStage::get_slope_falloff);
+
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "enabled", PROPERTY_HINT_NONE), "set_enabled", "is_enabled");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "type", PROPERTY_HINT_ENUM, "FBM Noise,Ridged Noise,Biome Mask,Thermal Erosion,Hydraulic Erosion,Texture,Color"), "set_type", "get_type");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "strength", PROPERTY_HINT_RANGE, "0.0,1.0"), "set_strength", "get_strength");
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "biome_range"), "set_biome_range", "get_biome_range");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "biome_falloff", PROPERTY_HINT_RANGE, "0.0,1.0"), "set_biome_falloff", "get_biome_falloff");
+
+	ADD_GROUP("Noise", "");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "seed_offset"), "set_seed_offset", "get_seed_offset");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "frequency", PROPERTY_HINT_RANGE, "0.00001,0.1,0.00001,or_greater"), "set_frequency", "get_frequency");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "octaves", PROPERTY_HINT_RANGE, "1,12,1"), "set_octaves", "get_octaves");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "lacunarity", PROPERTY_HINT_RANGE, "1.0,4.0"), "set_lacunarity", "get_lacunarity");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "gain", PROPERTY_HINT_RANGE, "0.0,1.0"), "set_gain", "get_gain");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "amplitude", PROPERTY_HINT_RANGE, "0.0,2000.0,0.1,or_greater"), "set_amplitude", "get_amplitude");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "height_offset", PROPERTY_HINT_RANGE, "-2000.0,2000.0,0.1,or_less,or_greater"), "set_height_offset", "get_height_offset");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "operation", PROPERTY_HINT_ENUM, "Add,Subtract,Max,Min"), "set_operation", "get_operation");
+
+	ADD_GROUP("Erosion", "");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "iterations", PROPERTY_HINT_RANGE, "1,256,1"), "set_iterations", "get_iterations");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "talus_angle", PROPERTY_HINT_RANGE, "0.0,89.0,0.1,degrees"), "set_talus_angle", "get_talus_angle");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "rain", PROPERTY_HINT_RANGE, "0.0,1.0,0.001"), "set_rain", "get_rain");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "evaporation", PROPERTY_HINT_RANGE, "0.0,1.0,0.001"), "set_evaporation", "get_evaporation");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "sediment_capacity", PROPERTY_HINT_RANGE, "0.0,100.0,0.01"), "set_sediment_capacity", "get_sediment_capacity");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "erosion_rate", PROPERTY_HINT_RANGE, "0.0,1.0,0.001"), "set_erosion_rate", "get_erosion_rate");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "deposition_rate", PROPERTY_HINT_RANGE, "0.0,1.0,0.001"), "set_deposition_rate", "get_deposition_rate");
+
+	ADD_GROUP("Paint", "");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "texture_id", PROPERTY_HINT_RANGE, "0,31,1"), "set_texture_id", "get_texture_id");
+	ADD_PROPERTY(PropertyInfo(Variant::COLOR, "color"), "set_color", "get_color");
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "height_range"), "set_height_range", "get_height_range");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "height_falloff", PROPERTY_HINT_RANGE, "0.0,1000.0,0.1"), "set_height_falloff", "get_height_falloff");
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "slope_range"), "set_slope_range", "get_slope_range");
+	ADD_PROPERTY(PropertyInfo(Variant::FLOAT, "slope_falloff", PROPERTY_HINT_RANGE, "0.0,90.0,0.1,degrees"), "set_slope_falloff", "get_slope_falloff");
+}
@@ -0,0 +1,144 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/io/resource.h>
+
+#include "constants.h"
+
+
+// One step of a TerrainGeneratorProcedural stack. The stage type selects which of the settings
+// below are used; the others are hidden in the inspector.
+// Noise stages shape the height map, the biome mask stage writes a 0-1 mask that other stages
+// may be limited to with biome_range, erosion stages simulate on the heights, and the texture
+// and color stages paint the control and color maps by height, slope and biome.
+class TerrainGeneratorProceduralStage : public Resource {
+	GDCLASS(TerrainGeneratorProceduralStage, Resource);
+	CLASS_NAME();
+	friend class TerrainGeneratorProcedural;
+
+public: // Constants
+	enum StageType {
+		STAGE_FBM_NOISE,
+		STAGE_RIDGED_NOISE,
+		STAGE_BIOME_MASK,
+		STAGE_THERMAL_EROSION,
+		STAGE_HYDRAULIC_EROSION,
+		STAGE_TEXTURE,
+		STAGE_COLOR,
+		STAGE_MAX,
+	};
+
+	enum Operation {
+		OP_ADD,
+		OP_SUBTRACT,
+		OP_MAX,
+		OP_MIN,
+	};
+
+private:
+	bool _enabled = true;
+	StageType _type = STAGE_FBM_NOISE;
+	real_t _strength = 1.f;
+	Vector2 _biome_range = Vector2(0.f, 1.f);
+	real_t _biome_falloff = 0.1f;
+
+	// Noise
+	int _seed_offset = 0;
+	real_t _frequency = 0.002f; // Cycles per meter
+	int _octaves = 6;
+	real_t _lacunarity = 2.f;
+	real_t _gain = 0.5f;
+	real_t _amplitude = 200.f;
+	real_t _height_offset = 0.f;
+	Operation _operation = OP_ADD;
+
+	// Erosion
+	int _iterations = 20;
+	real_t _talus_angle = 35.f;
+	real_t _rain = 0.01f;
+	real_t _evaporation = 0.02f;
+	real_t _sediment_capacity = 4.f;
+	real_t _erosion_rate = 0.3f;
+	real_t _deposition_rate = 0.3f;
+
+	// Texture & Color
+	int _texture_id = 0;
+	Color _color = COLOR_ROUGHNESS;
+	Vector2 _height_range = Vector2(-10000.f, 10000.f);
+	real_t _height_falloff = 10.f;
+	Vector2 _slope_range = Vector2(0.f, 90.f);
+	real_t _slope_falloff = 5.f;
+
+public:
+	TerrainGeneratorProceduralStage() {}
+	~TerrainGeneratorProceduralStage() {}
+
+	void set_enabled(const bool p_enabled);
+	bool is_enabled() const { return _enabled; }
+	void set_type(const StageType p_type);
+	StageType get_type() const { return _type; }
+	void set_strength(const real_t p_strength);
+	real_t get_strength() const { return _strength; }
+	void set_biome_range(const Vector2 &p_range);
+	Vector2 get_biome_range() const { return _biome_range; }
+	void set_biome_falloff(const real_t p_falloff);
+	real_t get_biome_falloff() const { return _biome_falloff; }
+
+	void set_seed_offset(const int p_offset);
+	int get_seed_offset() const { return _seed_offset; }
+	void set_frequency(const real_t p_frequency);
+	real_t get_frequency() const { return _frequency; }
+	void set_octaves(const int p_octaves);
+	int get_octaves() const { return _octaves; }
+	void set_lacunarity(const real_t p_lacunarity);
+	real_t get_lacunarity() const { return _lacunarity; }
+	void set_gain(const real_t p_gain);
+	real_t get_gain() const { return _gain; }
+	void set_amplitude(const real_t p_amplitude);
+	real_t get_amplitude() const { return _amplitude; }
+	void set_height_offset(const real_t p_offset);
+	real_t get_height_offset() const { return _height_offset; }
+	void set_operation(const Operation p_operation);
+	Operation get_operation() const { return _operation; }
+
+	void set_iterations(const int p_iterations);
+	int get_iterations() const { return _iterations; }
+	void set_talus_angle(const real_t p_degrees);
+	real_t get_talus_angle() const { return _talus_angle; }
+	void set_rain(const real_t p_rain);
+	real_t get_rain() const { return _rain; }
+	void set_evaporation(const real_t p_evaporation);
+	real_t get_evaporation() const { return _evaporation; }
+	void set_sediment_capacity(const real_t p_capacity);
+	real_t get_sediment_capacity() const { return _sediment_capacity; }
+	void set_erosion_rate(const real_t p_rate);
+	real_t get_erosion_rate() const { return _erosion_rate; }
+	void set_deposition_rate(const real_t p_rate);
+	real_t get_deposition_rate() const { return _deposition_rate; }
+
+	void set_texture_id(const int p_texture_id);
+	int get_texture_id() const { return _texture_id; }
+	void set_color(const Color &p_color);
+	Color get_color() const { return _color; }
+	void set_height_range(const Vector2 &p_range);
+	Vector2 get_height_range() const { return _height_range; }
+	void set_height_falloff(const real_t p_falloff);
+	real_t get_height_falloff() const { return _height_falloff; }
+	void set_slope_range(const Vector2 &p_range);
+	Vector2 get_slope_range() const { return _slope_range; }
+	void set_slope_falloff(const real_t p_falloff);
+	real_t get_slope_falloff() const { return _slope_falloff; }
+
+	bool is_noise() const { return _type == STAGE_FBM_NOISE || _type == STAGE_RIDGED_NOISE || _type == STAGE_BIOME_MASK; }
+	bool is_erosion() const { return _type == STAGE_THERMAL_EROSION || _type == STAGE_HYDRAULIC_EROSION; }
+	bool is_paint() const { return _type == STAGE_TEXTURE || _type == STAGE_COLOR; }
+	int get_apron() const;
+
+protected:
+	void _validate_property(PropertyInfo &p_property) const;
+	static void _bind_methods();
+};
+
+VARIANT_ENUM_CAST(TerrainGeneratorProceduralStage::StageType);
+VARIANT_ENUM_CAST(TerrainGeneratorProceduralStage::Operation);
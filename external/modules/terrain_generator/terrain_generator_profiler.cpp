@@ -0,0 +1,157 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include <godot/core/config/engine.h>
+#include <godot/main/performance.h>
+#include <algorithm>
+
+#include "logger.h"
+#include "terrain_generator.h"
+#include "terrain_generator_profiler.h"
+
+Mutex TerrainGeneratorProfiler::_mutex;
+uint64_t TerrainGeneratorProfiler::_frame = 0;
+uint64_t TerrainGeneratorProfiler::_usec[2][COUNTER_MAX] = {};
+uint64_t TerrainGeneratorProfiler::_upload_bytes[2] = {};
+uint64_t TerrainGeneratorProfiler::_upload_bytes_total = 0;
+std::vector<ObjectID> TerrainGeneratorProfiler::_terrains;
+
+///////////////////////////
+// Private Functions
+///////////////////////////
+
+// Moves the current totals to the last frame once a new frame starts. Call with _mutex locked.
+void TerrainGeneratorProfiler::_sync_frame() {
+	uint64_t frame = Engine::get_singleton()->get_process_frames();
+	if (frame == _frame) {
+		return;
+	}
+	bool consecutive = frame == _frame + 1;
+	for (int i = 0; i < COUNTER_MAX; i++) {
+		_usec[1][i] = consecutive ? _usec[0][i] : 0;
+		_usec[0][i] = 0;
+	}
+	_upload_bytes[1] = consecutive ? _upload_bytes[0] : 0;
+	_upload_bytes[0] = 0;
+	_frame = frame;
+}
+
+String TerrainGeneratorProfiler::_get_monitor_name(const int p_monitor) {
+	if (p_monitor < COUNTER_MAX) {
+		return String("TerrainGenerator/") + COUNTERSTR[p_monitor] + " (ms)";
+	}
+	switch (p_monitor) {
+		case MONITOR_GPU_UPLOAD:
+			return "TerrainGenerator/GPU upload (KB)";
+		case MONITOR_RESIDENT_MEMORY:
+			return "TerrainGenerator/Resident regions (MB)";
+		default:
+			return "";
+	}
+}
+
+Variant TerrainGeneratorProfiler::_get_monitor(const int p_monitor) {
+	if (p_monitor >= 0 && p_monitor < COUNTER_MAX) {
+		return get_frame_msec(Counter(p_monitor));
+	}
+	switch (p_monitor) {
+		case MONITOR_GPU_UPLOAD:
+			return double(get_frame_upload_bytes()) / 1024.0;
+		case MONITOR_RESIDENT_MEMORY:
+			return double(get_resident_bytes()) / (1024.0 * 1024.0);
+		default:
+			return 0;
+	}
+}
+
+///////////////////////////
+// Public Functions
+///////////////////////////
+
+void TerrainGeneratorProfiler::add_time(const Counter p_counter, const uint64_t p_usec) {
+	MutexLock lock(_mutex);
+	_sync_frame();
+	_usec[0][p_counter] += p_usec;
+}
+
+void TerrainGeneratorProfiler::add_upload_bytes(const uint64_t p_bytes) {
+	MutexLock lock(_mutex);
+	_sync_frame();
+	_upload_bytes[0] += p_bytes;
+	_upload_bytes_total += p_bytes;
+}
+
+// Time spent in the last completed frame
+double TerrainGeneratorProfiler::get_frame_msec(const Counter p_counter) {
+	ASSERT(p_counter >= 0 && p_counter < COUNTER_MAX, 0.0);
+	MutexLock lock(_mutex);
+	_sync_frame();
+	return double(_usec[1][p_counter]) / 1000.0;
+}
+
+// Bytes uploaded to the GPU in the last completed frame
+uint64_t TerrainGeneratorProfiler::get_frame_upload_bytes() {
+	MutexLock lock(_mutex);
+	_sync_frame();
+	return _upload_bytes[1];
+}
+
+uint64_t TerrainGeneratorProfiler::get_upload_bytes_total() {
+	MutexLock lock(_mutex);
+	return _upload_bytes_total;
+}
+
+// Map memory of the active regions of all terrains in the tree
+int64_t TerrainGeneratorProfiler::get_resident_bytes() {
+	int64_t bytes = 0;
+	for (const ObjectID &id : _terrains) {
+		TerrainGenerator *terrain = Object::cast_to<TerrainGenerator>(ObjectDB::get_instance(id));
+		if (terrain && terrain->get_data()) {
+			bytes += terrain->get_data()->get_resident_bytes();
+		}
+	}
+	return bytes;
+}
+
+// Called when a terrain enters the tree. The monitors are added with the first terrain.
+void TerrainGeneratorProfiler::add_terrain(const TerrainGenerator *p_terrain) {
+	if (!p_terrain || std::find(_terrains.begin(), _terrains.end(), p_terrain->get_instance_id()) != _terrains.end()) {
+		return;
+	}
+	_terrains.push_back(p_terrain->get_instance_id());
+	Performance *perf = Performance::get_singleton();
+	if (_terrains.size() > 1 || !perf) {
+		return;
+	}
+	LOG(INFO, "Adding performance monitors");
+	for (int i = 0; i < MONITOR_MAX; i++) {
+		StringName name = _get_monitor_name(i);
+		if (!perf->has_custom_monitor(name)) {
+			Vector<Variant> args;
+			args.push_back(i);
+			perf->add_custom_monitor(name, callable_mp_static(&TerrainGeneratorProfiler::_get_monitor), args);
+		}
+	}
+}
+
+// Called when a terrain exits the tree. The monitors are removed with the last terrain.
+void TerrainGeneratorProfiler::remove_terrain(const TerrainGenerator *p_terrain) {
+	if (!p_terrain) {
+		return;
+	}
+	auto it = std::find(_terrains.begin(), _terrains.end(), p_terrain->get_instance_id());
+	if (it == _terrains.end()) {
+		return;
+	}
+	_terrains.erase(it);
+	Performance *perf = Performance::get_singleton();
+	if (!_terrains.empty() || !perf) {
+		return;
+	}
+	LOG(INFO, "Removing performance monitors");
+	for (int i = 0; i < MONITOR_MAX; i++) {
+		StringName name = _get_monitor_name(i);
+		if (perf->has_custom_monitor(name)) {
+			perf->remove_custom_monitor(name);
+		}
+	}
+}
@@ -0,0 +1,100 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/object/object_id.h>
+#include <godot/core/os/mutex.h>
+#include <godot/core/os/time.h>
+#include <vector>
+
+#include "constants.h"
+
+class TerrainGenerator;
+
+// Counts the time spent in each subsystem and the bytes uploaded to the GPU, per frame. The totals of
+// the last completed frame, and the resident region memory of all terrains in the tree, are shown in
+// the Debugger Monitors tab under TerrainGenerator, through Performance custom monitors.
+// Times are wall clock on the calling thread, and include work waited on from other threads and
+// other counters called within, eg. Region IO includes Update maps after loading. Nested scopes of
+// the same counter are counted once. Counters are shared by all terrains.
+class TerrainGeneratorProfiler {
+	CLASS_NAME_STATIC("TerrainGeneratorProfiler");
+
+public: // Constants
+	enum Counter {
+		STREAMING, // Data::update_streaming()
+		REGION_IO, // Loading and saving region files on the main thread
+		UPDATE_MAPS, // Data::update_maps()
+		MESHER, // Mesher::snap()
+		COLLISION, // Collision::update()
+		INSTANCER, // Instancer::update_transforms() and _update_mmis()
+		NAVIGATION, // TerrainGenerator::generate_nav_mesh_source_geometry()
+		COUNTER_MAX,
+	};
+
+	static inline const char *COUNTERSTR[] = {
+		"Streaming",
+		"Region IO",
+		"Update maps",
+		"Mesher",
+		"Collision",
+		"Instancer",
+		"Navigation",
+		"COUNTER_MAX",
+	};
+
+	// Adds the time until it goes out of scope to a counter
+	class Scope {
+		Counter _counter;
+		uint64_t _start = 0;
+
+	public:
+		Scope(const Counter p_counter);
+		~Scope();
+	};
+
+private:
+	enum Monitor {
+		MONITOR_GPU_UPLOAD = COUNTER_MAX,
+		MONITOR_RESIDENT_MEMORY,
+		MONITOR_MAX,
+	};
+
+	static Mutex _mutex;
+	static uint64_t _frame;
+	static uint64_t _usec[2][COUNTER_MAX]; // Current and last frame
+	static uint64_t _upload_bytes[2];
+	static uint64_t _upload_bytes_total;
+	static std::vector<ObjectID> _terrains; // In the tree, for resident memory
+	static inline thread_local int _depth[COUNTER_MAX] = {};
+
+	static void _sync_frame();
+	static String _get_monitor_name(const int p_monitor);
+	static Variant _get_monitor(const int p_monitor);
+
+public:
+	static void add_time(const Counter p_counter, const uint64_t p_usec);
+	static void add_upload_bytes(const uint64_t p_bytes);
+	static double get_frame_msec(const Counter p_counter);
+	static uint64_t get_frame_upload_bytes();
+	static uint64_t get_upload_bytes_total();
+	static int64_t get_resident_bytes();
+
+	static void add_terrain(const TerrainGenerator *p_terrain);
+	static void remove_terrain(const TerrainGenerator *p_terrain);
+};
+
+// Inline Functions
+
+inline TerrainGeneratorProfiler::Scope::Scope(const Counter p_counter) {
+	_counter = p_counter;
+	if (_depth[_counter]++ == 0) {
+		_start = Time::get_singleton()->get_ticks_usec();
+	}
+}
+
+inline TerrainGeneratorProfiler::Scope::~Scope() {
+	if (--_depth[_counter] == 0) {
+		add_time(_counter, Time::get_singleton()->get_ticks_usec() - _start);
+	}
+}
@@ -6,6 +6,7 @@
 #include "logger.h"
 #include "terrain_generator_data.h"
 #include "terrain_generator_region.h"
+#include "terrain_generator_region_file.h"
 #include "terrain_generator_util.h"
 
 /////////////////////
@@ -93,6 +94,7 @@ void TerrainGeneratorRegion::set_height_map(const Ref<Image> &p_map) {
 	}
 	_height_map = sanitize_map(TYPE_HEIGHT, p_map);
 	calc_height_range();
+	set_all_dirty();
 }
 
 void TerrainGeneratorRegion::set_control_map(const Ref<Image> &p_map) {
@@ -101,6 +103,7 @@ void TerrainGeneratorRegion::set_control_map(const Ref<Image> &p_map) {
 		set_region_size((p_map.is_valid()) ? p_map->get_width() : 0);
 	}
 	_control_map = sanitize_map(TYPE_CONTROL, p_map);
+	set_all_dirty();
 }
 
 void TerrainGeneratorRegion::set_color_map(const Ref<Image> &p_map) {
@@ -113,6 +116,7 @@ void TerrainGeneratorRegion::set_color_map(const Ref<Image> &p_map) {
 		LOG(DEBUG, "Color map does not have mipmaps. Generating");
 		_color_map->generate_mipmaps();
 	}
+	set_all_dirty();
 }
 
 void TerrainGeneratorRegion::sanitize_maps() {
@@ -227,7 +231,11 @@ Error TerrainGeneratorRegion::save(const String &p_path, const bool p_16_bit) {
 	LOG(MESG, "Writing", (p_16_bit) ? " 16-bit" : "", " region ", _location, " to ", get_path());
 	set_version(TerrainGeneratorData::CURRENT_VERSION);
 	Error err = OK;
-	if (p_16_bit) {
+	if (get_path().get_extension() == TerrainGeneratorRegionFile::EXTENSION) {
+		Ref<TerrainGeneratorRegionFile> file;
+		file.instantiate();
+		err = file->save(this, get_path(), p_16_bit);
+	} else if (p_16_bit) {
 		Ref<Image> original_map;
 		original_map.instantiate();
 		original_map->copy_from(_height_map);
@@ -239,6 +247,7 @@ Error TerrainGeneratorRegion::save(const String &p_path, const bool p_16_bit) {
 	}
 	if (err == OK) {
 		_modified = false;
+		clear_dirty();
 		LOG(INFO, "File saved successfully");
 	} else {
 		LOG(ERROR, "Cannot save region file: ", get_path(), ". Error code: ", ERROR, ". Look up @GlobalScope Error enum in the Godot docs");
@@ -246,6 +255,16 @@ Error TerrainGeneratorRegion::save(const String &p_path, const bool p_16_bit) {
 	return err;
 }
 
+void TerrainGeneratorRegion::set_edited(const bool p_edited) {
+	_edited = p_edited;
+	if (!_edited) {
+		_update_tracked = false;
+		for (int i = 0; i < TYPE_MAX; i++) {
+			_update_areas[i] = Rect2i();
+		}
+	}
+}
+
 void TerrainGeneratorRegion::set_location(const Vector2i &p_location) {
 	// In the future anywhere they want to put the location might be fine, but because of region_map
 	// We have a limitation of 16x16 and eventually 45x45.
@@ -258,6 +277,71 @@ void TerrainGeneratorRegion::set_location(const Vector2i &p_location) {
 	_location = p_location;
 }
 
+// Marks the tiles overlapping p_area, in region pixels, for the next save
+void TerrainGeneratorRegion::add_dirty_area(const Rect2i &p_area) {
+	_map_generation = _last_map_generation.increment();
+	if (_all_dirty) {
+		return;
+	}
+	int tiles = get_tiles_per_side();
+	if (int(_dirty_tiles.size()) != tiles * tiles) {
+		_dirty_tiles.assign(tiles * tiles, false);
+	}
+	Rect2i area = p_area.intersection(Rect2i(V2I_ZERO, Vector2i(_region_size, _region_size)));
+	if (!area.has_area()) {
+		return;
+	}
+	Vector2i start = area.position / TILE_SIZE;
+	Vector2i end = (area.get_end() - Vector2i(1, 1)) / TILE_SIZE;
+	for (int y = start.y; y <= end.y && y < tiles; y++) {
+		for (int x = start.x; x <= end.x && x < tiles; x++) {
+			_dirty_tiles[y * tiles + x] = true;
+		}
+	}
+}
+
+bool TerrainGeneratorRegion::is_tile_dirty(const Vector2i &p_tile) const {
+	if (_all_dirty) {
+		return true;
+	}
+	int tiles = get_tiles_per_side();
+	int index = p_tile.y * tiles + p_tile.x;
+	return p_tile.x >= 0 && p_tile.x < tiles && index >= 0 && index < int(_dirty_tiles.size()) && _dirty_tiles[index];
+}
+
+void TerrainGeneratorRegion::set_all_dirty() {
+	_map_generation = _last_map_generation.increment();
+	_all_dirty = true;
+	_dirty_tiles.clear();
+}
+
+void TerrainGeneratorRegion::clear_dirty() {
+	_all_dirty = false;
+	int tiles = get_tiles_per_side();
+	_dirty_tiles.assign(tiles * tiles, false);
+}
+
+// Queues p_area of a map, in region pixels, for TerrainGeneratorData::update_maps() to upload
+void TerrainGeneratorRegion::add_update_area(const MapType p_map_type, const Rect2i &p_area) {
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX || !p_area.has_area()) {
+		return;
+	}
+	_map_generation = _last_map_generation.increment();
+	Rect2i &area = _update_areas[p_map_type];
+	area = area.has_area() ? area.merge(p_area) : p_area;
+	_update_tracked = true;
+}
+
+// Returns the queued area of a map and clears it
+Rect2i TerrainGeneratorRegion::take_update_area(const MapType p_map_type) {
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX) {
+		return Rect2i();
+	}
+	Rect2i area = _update_areas[p_map_type];
+	_update_areas[p_map_type] = Rect2i();
+	return area;
+}
+
 void TerrainGeneratorRegion::set_data(const Dictionary &p_data) {
 #define SET_IF_HAS(var, str) \
 	if (p_data.has(str)) {   \
@@ -274,7 +358,12 @@ void TerrainGeneratorRegion::set_data(const Dictionary &p_data) {
 	SET_IF_HAS(_height_map, "height_map");
 	SET_IF_HAS(_control_map, "control_map");
 	SET_IF_HAS(_color_map, "color_map");
-	SET_IF_HAS(_instances, "instances");
+	if (p_data.has("height_map") || p_data.has("control_map") || p_data.has("color_map")) {
+		set_all_dirty();
+	}
+	if (p_data.has("instances")) {
+		_instances.set_data(p_data["instances"]);
+	}
 }
 
 Dictionary TerrainGeneratorRegion::get_data() const {
@@ -290,7 +379,7 @@ Dictionary TerrainGeneratorRegion::get_data() const {
 	dict["height_map"] = _height_map;
 	dict["control_map"] = _control_map;
 	dict["color_map"] = _color_map;
-	dict["instances"] = _instances;
+	dict["instances"] = _instances.get_data();
 	return dict;
 }
 
@@ -298,7 +387,9 @@ Ref<TerrainGeneratorRegion> TerrainGeneratorRegion::duplicate(const bool p_deep)
 	Ref<TerrainGeneratorRegion> region;
 	region.instantiate();
 	if (!p_deep) {
-		region->set_data(get_data());
+		Dictionary dict = get_data();
+		dict.erase("instances");
+		region->set_data(dict);
 	} else {
 		Dictionary dict;
 		// Native type copies
@@ -313,9 +404,10 @@ Ref<TerrainGeneratorRegion> TerrainGeneratorRegion::duplicate(const bool p_deep)
 		dict["height_map"] = _height_map->duplicate();
 		dict["control_map"] = _control_map->duplicate();
 		dict["color_map"] = _color_map->duplicate();
-		dict["instances"] = _instances.duplicate(true);
 		region->set_data(dict);
 	}
+	// Packed arrays are copy-on-write, so both are unique copies once either is edited
+	region->_instances = _instances;
 	return region;
 }
 
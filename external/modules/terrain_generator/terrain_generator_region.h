@@ -2,7 +2,11 @@
 
 #pragma once
 
+#include <godot/core/templates/safe_refcount.h>
+#include <vector>
+
 #include "constants.h"
+#include "instance_store.h"
 #include "terrain_generator_util.h"
 
 
@@ -39,6 +43,8 @@ public: // Constants
 		COLOR_NAN, // TYPE_MAX, unused just in case someone indexes the array
 	};
 
+	static inline const int TILE_SIZE = 64; // Dirty tracking and region file tile size
+
 private:
 	// Saved data
 	real_t _version = 0.8f; // Set to first version to ensure we always upgrades this
@@ -49,7 +55,7 @@ private:
 	Ref<Image> _control_map;
 	Ref<Image> _color_map;
 	// Instancer
-	Dictionary _instances; // Meshes{int} -> Cells{v2i} -> [ Transform3D, Color, Modified ]
+	InstanceStore _instances; // Meshes{int} -> Cells{v2i} -> packed transforms and colors
 	real_t _vertex_spacing = 1.f; // Vertex Spacing value that transforms are currently scaled.
 
 	// Working data not saved to disk
@@ -57,6 +63,14 @@ private:
 	bool _edited = false; // Marked for undo/redo storage
 	bool _modified = false; // Marked for saving
 	Vector2i _location = V2I_MAX;
+	// Map tiles edited since last saved, for partial saves of region files
+	std::vector<bool> _dirty_tiles;
+	bool _all_dirty = true;
+	// Map areas changed since last sent to the texture arrays, in pixels
+	Rect2i _update_areas[TYPE_MAX];
+	bool _update_tracked = false; // Set once areas are sent while edited, so untouched maps are skipped
+	static inline SafeNumeric<uint64_t> _last_map_generation; // Shared so generations are unique across regions
+	uint64_t _map_generation = _last_map_generation.increment(); // Renewed on every map change, eg. to find stale caches
 
 public:
 	TerrainGeneratorRegion() {}
@@ -92,8 +106,10 @@ public:
 	void calc_height_range();
 
 	// Instancer
-	void set_instances(const Dictionary &p_instances) { _instances = p_instances; }
-	Dictionary get_instances() const { return _instances; }
+	void set_instances(const Dictionary &p_instances) { _instances.set_data(p_instances); }
+	Dictionary get_instances() const { return _instances.get_data(); }
+	InstanceStore *get_instance_store() { return &_instances; }
+	const InstanceStore *get_instance_store() const { return &_instances; }
 	void set_vertex_spacing(const real_t p_vertex_spacing) { _vertex_spacing = CLAMP(p_vertex_spacing, 0.25f, 100.f); }
 	real_t get_vertex_spacing() const { return _vertex_spacing; }
 
@@ -103,12 +119,22 @@ public:
 	// Working Data
 	void set_deleted(const bool p_deleted) { _deleted = p_deleted; }
 	bool is_deleted() const { return _deleted; }
-	void set_edited(const bool p_edited) { _edited = p_edited; }
+	void set_edited(const bool p_edited);
 	bool is_edited() const { return _edited; }
 	void set_modified(const bool p_modified) { _modified = p_modified; }
 	bool is_modified() const { return _modified; }
 	void set_location(const Vector2i &p_location);
 	Vector2i get_location() const { return _location; }
+	int get_tiles_per_side() const { return MAX(1, _region_size / TILE_SIZE); }
+	void add_dirty_area(const Rect2i &p_area);
+	bool is_tile_dirty(const Vector2i &p_tile) const;
+	void set_all_dirty();
+	bool is_all_dirty() const { return _all_dirty; }
+	void clear_dirty();
+	void add_update_area(const MapType p_map_type, const Rect2i &p_area);
+	Rect2i take_update_area(const MapType p_map_type);
+	bool is_update_tracked() const { return _update_tracked; }
+	uint64_t get_map_generation() const { return _map_generation; }
 
 	// Utility
 	void set_data(const Dictionary &p_data);
@@ -0,0 +1,841 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include <godot/core/core_bind.h>
+#include <godot/core/io/compression.h>
+#include <godot/core/io/dir_access.h>
+#include <godot/core/io/marshalls.h>
+#include <godot/core/object/worker_thread_pool.h>
+#include <godot/core/os/time.h>
+#include <cstring>
+
+#include "logger.h"
+#include "terrain_generator_data.h"
+#include "terrain_generator_region_file.h"
+#include "terrain_generator_util.h"
+
+/////////////////////
+// Private Functions
+/////////////////////
+
+// Replaces each element with its difference to the element on its left, or above at the start of
+// a row, then splits the elements into byte planes. Neighboring pixels are similar, so this leaves
+// long runs of zeros for the compressor. Floats and packed bits are XORed, 16-bit heights subtracted.
+static void encode_residuals(const uint8_t *p_src, uint8_t *r_dst, const int p_width, const int p_element_size, const bool p_subtract) {
+	const int count = p_width * p_width;
+	for (int i = 0; i < count; i++) {
+		int prev_i = (i % p_width != 0) ? i - 1 : i - p_width;
+		uint32_t value = 0;
+		uint32_t prev = 0;
+		memcpy(&value, p_src + i * p_element_size, p_element_size);
+		if (prev_i >= 0) {
+			memcpy(&prev, p_src + prev_i * p_element_size, p_element_size);
+		}
+		uint32_t residual = p_subtract ? value - prev : value ^ prev;
+		for (int b = 0; b < p_element_size; b++) {
+			r_dst[b * count + i] = uint8_t(residual >> (b * 8));
+		}
+	}
+}
+
+static void decode_residuals(const uint8_t *p_src, uint8_t *r_dst, const int p_width, const int p_element_size, const bool p_subtract) {
+	const int count = p_width * p_width;
+	for (int i = 0; i < count; i++) {
+		int prev_i = (i % p_width != 0) ? i - 1 : i - p_width;
+		uint32_t residual = 0;
+		uint32_t prev = 0;
+		for (int b = 0; b < p_element_size; b++) {
+			residual |= uint32_t(p_src[b * count + i]) << (b * 8);
+		}
+		if (prev_i >= 0) {
+			memcpy(&prev, r_dst + prev_i * p_element_size, p_element_size);
+		}
+		uint32_t value = p_subtract ? residual + prev : residual ^ prev;
+		memcpy(r_dst + i * p_element_size, &value, p_element_size);
+	}
+}
+
+static uint16_t quantize_height(const float p_height, const Vector2 &p_range) {
+	real_t span = p_range.y - p_range.x;
+	if (span <= 0.f || Math::is_nan(p_height)) {
+		return 0;
+	}
+	real_t value = Math::round((p_height - p_range.x) / span * 65535.f);
+	return uint16_t(CLAMP(value, 0.f, 65535.f));
+}
+
+static float dequantize_height(const uint16_t p_value, const Vector2 &p_range) {
+	return p_range.x + (p_range.y - p_range.x) * real_t(p_value) / 65535.f;
+}
+
+void TerrainGeneratorRegionFile::_setup_layout(const int p_region_size, const int p_tile_size) {
+	_header.region_size = p_region_size;
+	_header.tile_size = MIN(p_tile_size, p_region_size);
+	_header.level_count = 1;
+	while ((p_region_size >> _header.level_count) >= _header.tile_size) {
+		_header.level_count++;
+	}
+	_level_offsets.resize(_header.level_count);
+	_entries_per_map = 0;
+	for (int level = 0; level < _header.level_count; level++) {
+		_level_offsets[level] = _entries_per_map;
+		int tiles = _get_tiles_per_side(level);
+		_entries_per_map += tiles * tiles;
+	}
+	_entries.assign(TYPE_MAX * _entries_per_map + 1, Entry()); // Plus instances
+}
+
+int TerrainGeneratorRegionFile::_get_entry_id(const MapType p_map_type, const int p_level, const Vector2i &p_tile) const {
+	return p_map_type * _entries_per_map + _level_offsets[p_level] + p_tile.y * _get_tiles_per_side(p_level) + p_tile.x;
+}
+
+void TerrainGeneratorRegionFile::_get_entry_tile(const int p_entry_id, MapType &r_map_type, int &r_level, Vector2i &r_tile) const {
+	r_map_type = MapType(p_entry_id / _entries_per_map);
+	int local_id = p_entry_id % _entries_per_map;
+	r_level = _header.level_count - 1;
+	while (r_level > 0 && _level_offsets[r_level] > local_id) {
+		r_level--;
+	}
+	local_id -= _level_offsets[r_level];
+	int tiles = _get_tiles_per_side(r_level);
+	r_tile = Vector2i(local_id % tiles, local_id / tiles);
+}
+
+int TerrainGeneratorRegionFile::_get_element_size(const MapType p_map_type) const {
+	if (p_map_type == TYPE_HEIGHT && _header.height_encoding == HEIGHT_QUANTIZED16) {
+		return 2;
+	}
+	return 4; // RF height & control, RGBA8 color
+}
+
+// Bytes to reserve for an entry. Instances that compress very well get extra room, so their raw size
+// stays within what _read_header() accepts.
+uint32_t TerrainGeneratorRegionFile::_get_min_capacity(const int p_entry_id, const uint32_t p_size, const uint32_t p_raw_size) const {
+	if (p_entry_id != _get_instances_entry_id()) {
+		return p_size;
+	}
+	return MAX(p_size, (p_raw_size + MAX_INSTANCE_RATIO - 1) / MAX_INSTANCE_RATIO);
+}
+
+// Writes the header followed by the entry directory
+bool TerrainGeneratorRegionFile::_store_header(const Ref<FileAccess> &p_file) const {
+	p_file->seek(0);
+	bool ok = p_file->store_32(MAGIC);
+	ok = ok && p_file->store_32(FORMAT_VERSION);
+	ok = ok && p_file->store_32(_header.region_size);
+	ok = ok && p_file->store_32(_header.tile_size);
+	ok = ok && p_file->store_32(_header.level_count);
+	ok = ok && p_file->store_32(_header.height_encoding);
+	ok = ok && p_file->store_32(uint32_t(_header.location.x));
+	ok = ok && p_file->store_32(uint32_t(_header.location.y));
+	ok = ok && p_file->store_float(_header.vertex_spacing);
+	ok = ok && p_file->store_float(_header.height_range.x);
+	ok = ok && p_file->store_float(_header.height_range.y);
+	ok = ok && p_file->store_float(_header.version);
+	ok = ok && p_file->store_32(uint32_t(_entries.size()));
+	while (ok && p_file->get_position() < HEADER_SIZE) {
+		ok = p_file->store_32(0);
+	}
+	for (int i = 0; ok && i < int(_entries.size()); i++) {
+		const Entry &entry = _entries[i];
+		ok = p_file->store_64(entry.offset);
+		ok = ok && p_file->store_32(entry.size);
+		ok = ok && p_file->store_32(entry.capacity);
+		ok = ok && p_file->store_32(entry.raw_size);
+		ok = ok && p_file->store_32(0); // Reserved
+	}
+	return ok;
+}
+
+Error TerrainGeneratorRegionFile::_read_header(const Ref<FileAccess> &p_file) {
+	String path = p_file->get_path();
+	uint64_t length = p_file->get_length();
+	p_file->seek(0);
+	if (length < uint64_t(HEADER_SIZE) || p_file->get_32() != MAGIC) {
+		LOG(ERROR, "Not a region file: ", path);
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	uint32_t version = p_file->get_32();
+	if (version > FORMAT_VERSION) {
+		LOG(ERROR, "Region file ", path, " has format version ", version, ". Supported: ", FORMAT_VERSION);
+		return ERR_FILE_UNRECOGNIZED;
+	}
+	int region_size = p_file->get_32();
+	int tile_size = p_file->get_32();
+	int level_count = p_file->get_32();
+	uint32_t encoding = p_file->get_32();
+	bool valid_sizes = region_size >= 64 && region_size <= 2048 && (region_size & (region_size - 1)) == 0 &&
+			tile_size > 0 && tile_size <= region_size && (tile_size & (tile_size - 1)) == 0;
+	if (!valid_sizes) {
+		LOG(ERROR, "Region file ", path, " is corrupt. Region size: ", region_size, ", tile size: ", tile_size);
+		return ERR_FILE_CORRUPT;
+	}
+	_header = Header();
+	_setup_layout(region_size, tile_size);
+	if (level_count != _header.level_count || encoding > HEIGHT_QUANTIZED16) {
+		LOG(ERROR, "Region file ", path, " is corrupt. Levels: ", level_count, ", height encoding: ", encoding);
+		return ERR_FILE_CORRUPT;
+	}
+	_header.height_encoding = HeightEncoding(encoding);
+	_header.location.x = int32_t(p_file->get_32());
+	_header.location.y = int32_t(p_file->get_32());
+	_header.vertex_spacing = p_file->get_float();
+	_header.height_range.x = p_file->get_float();
+	_header.height_range.y = p_file->get_float();
+	_header.version = p_file->get_float();
+	uint32_t entry_count = p_file->get_32();
+	if (entry_count != _entries.size() || length < HEADER_SIZE + uint64_t(entry_count) * ENTRY_SIZE) {
+		LOG(ERROR, "Region file ", path, " is corrupt. Expected ", _entries.size(), " entries, found ", entry_count);
+		return ERR_FILE_CORRUPT;
+	}
+	p_file->seek(HEADER_SIZE);
+	const int instances_id = _get_instances_entry_id();
+	for (int i = 0; i < _entries.size(); i++) {
+		Entry &entry = _entries[i];
+		entry.offset = p_file->get_64();
+		entry.size = p_file->get_32();
+		entry.capacity = p_file->get_32();
+		entry.raw_size = p_file->get_32();
+		p_file->get_32(); // Reserved
+		if (entry.size > entry.capacity || entry.offset + entry.capacity > length) {
+			LOG(ERROR, "Region file ", path, " is corrupt. Tile data out of bounds");
+			return ERR_FILE_CORRUPT;
+		}
+		// Decompression buffers are sized from raw_size, so bound it before anything is allocated
+		bool valid_raw_size = entry.raw_size <= uint64_t(entry.capacity) * MAX_INSTANCE_RATIO;
+		if (i != instances_id) {
+			MapType map_type;
+			int level;
+			Vector2i tile;
+			_get_entry_tile(i, map_type, level, tile);
+			valid_raw_size = entry.raw_size == uint64_t(tile_size) * tile_size * _get_element_size(map_type);
+		}
+		if (!valid_raw_size) {
+			LOG(ERROR, "Region file ", path, " is corrupt. Entry ", i, " has a decompressed size of ", entry.raw_size);
+			return ERR_FILE_CORRUPT;
+		}
+	}
+	return OK;
+}
+
+// Samples one tile of a map at its level, encodes and compresses it. Runs on the WorkerThreadPool.
+void TerrainGeneratorRegionFile::_encode_entry(const uint32_t p_index, EncodeJob *p_job) {
+	int entry_id = p_job->entry_ids[p_index];
+	PackedByteArray &result = p_job->results[p_index];
+	std::vector<uint8_t> raw;
+	if (entry_id == _get_instances_entry_id()) {
+		raw.assign(p_job->instances.ptr(), p_job->instances.ptr() + p_job->instances.size());
+	} else {
+		MapType map_type;
+		int level;
+		Vector2i tile;
+		_get_entry_tile(entry_id, map_type, level, tile);
+		const Image *map = p_job->maps[map_type];
+		const uint8_t *src = map->ptr();
+		const int width = map->get_width();
+		const int tile_size = _header.tile_size;
+		const int element_size = _get_element_size(map_type);
+		const int step = 1 << level;
+		std::vector<uint8_t> samples(tile_size * tile_size * element_size);
+		for (int y = 0; y < tile_size; y++) {
+			for (int x = 0; x < tile_size; x++) {
+				int src_x = (tile.x * tile_size + x) * step;
+				int src_y = (tile.y * tile_size + y) * step;
+				const uint8_t *src_px = src + (src_y * width + src_x) * 4;
+				uint8_t *dst_px = samples.data() + (y * tile_size + x) * element_size;
+				if (element_size == 2) {
+					float height;
+					memcpy(&height, src_px, 4);
+					uint16_t value = quantize_height(height, _header.height_range);
+					memcpy(dst_px, &value, 2);
+				} else if (map_type == TYPE_COLOR && step > 1) {
+					// Box filter colors. Heights and control bits are point sampled as averages are invalid
+					uint32_t sum[4] = { 0, 0, 0, 0 };
+					for (int by = 0; by < step; by++) {
+						const uint8_t *row = src + ((src_y + by) * width + src_x) * 4;
+						for (int bx = 0; bx < step * 4; bx++) {
+							sum[bx & 3] += row[bx];
+						}
+					}
+					uint32_t samples_count = step * step;
+					for (int c = 0; c < 4; c++) {
+						dst_px[c] = uint8_t((sum[c] + samples_count / 2) / samples_count);
+					}
+				} else {
+					memcpy(dst_px, src_px, 4);
+				}
+			}
+		}
+		raw.resize(samples.size());
+		encode_residuals(samples.data(), raw.data(), tile_size, element_size, element_size == 2);
+	}
+	int64_t max_size = Compression::get_max_compressed_buffer_size(raw.size(), Compression::MODE_ZSTD);
+	result.resize(max_size);
+	int64_t size = Compression::compress(result.ptrw(), raw.data(), raw.size(), Compression::MODE_ZSTD);
+	result.resize(MAX(size, 0));
+	p_job->raw_sizes[p_index] = raw.size();
+}
+
+// Decompresses one map tile into its place in the output. Runs on the WorkerThreadPool.
+void TerrainGeneratorRegionFile::_decode_entry(const uint32_t p_index, DecodeJob *p_job) {
+	int entry_id = p_job->entry_ids[p_index];
+	const PackedByteArray &compressed = p_job->compressed[p_index];
+	MapType map_type;
+	int level;
+	Vector2i tile;
+	_get_entry_tile(entry_id, map_type, level, tile);
+	const int tile_size = _header.tile_size;
+	const int element_size = _get_element_size(map_type);
+	const uint32_t raw_size = tile_size * tile_size * element_size;
+	if (_entries[entry_id].raw_size != raw_size) {
+		p_job->failed.set();
+		return;
+	}
+	std::vector<uint8_t> raw(raw_size);
+	int64_t size = Compression::decompress(raw.data(), raw_size, compressed.ptr(), compressed.size(), Compression::MODE_ZSTD);
+	if (size != int64_t(raw_size)) {
+		p_job->failed.set();
+		return;
+	}
+	std::vector<uint8_t> samples(raw_size);
+	decode_residuals(raw.data(), samples.data(), tile_size, element_size, element_size == 2);
+
+	Vector2i origin = (tile - p_job->output_origin) * tile_size;
+	for (int y = 0; y < tile_size; y++) {
+		uint8_t *dst_row = p_job->outputs[map_type] + ((origin.y + y) * p_job->output_width + origin.x) * 4;
+		const uint8_t *src_row = samples.data() + y * tile_size * element_size;
+		if (element_size == 2) {
+			for (int x = 0; x < tile_size; x++) {
+				uint16_t value;
+				memcpy(&value, src_row + x * 2, 2);
+				float height = dequantize_height(value, _header.height_range);
+				memcpy(dst_row + x * 4, &height, 4);
+			}
+		} else {
+			memcpy(dst_row, src_row, tile_size * 4);
+		}
+	}
+}
+
+void TerrainGeneratorRegionFile::_decode_entries(DecodeJob &p_job, const bool p_parallel) {
+	if (p_parallel && p_job.entry_ids.size() > 1) {
+		WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+		WorkerThreadPool::GroupID task_id = wtp->add_template_group_task(this, &TerrainGeneratorRegionFile::_decode_entry,
+				&p_job, p_job.entry_ids.size(), -1, true, "TerrainGenerator region decode");
+		wtp->wait_for_group_task_completion(task_id);
+	} else {
+		for (uint32_t i = 0; i < p_job.entry_ids.size(); i++) {
+			_decode_entry(i, &p_job);
+		}
+	}
+}
+
+// Reads the compressed bytes of each entry. Reads are sequential, so the file may be shared across threads.
+Error TerrainGeneratorRegionFile::_read_entries(const std::vector<int> &p_entry_ids, std::vector<PackedByteArray> &r_data) {
+	MutexLock lock(_mutex);
+	if (_file.is_null()) {
+		LOG(ERROR, "No region file open");
+		return ERR_FILE_CANT_READ;
+	}
+	r_data.resize(p_entry_ids.size());
+	for (uint32_t i = 0; i < p_entry_ids.size(); i++) {
+		const Entry &entry = _entries[p_entry_ids[i]];
+		PackedByteArray &data = r_data[i];
+		data.resize(entry.size);
+		_file->seek(entry.offset);
+		if (_file->get_buffer(data.ptrw(), entry.size) != entry.size) {
+			LOG(ERROR, "Cannot read tile data from ", _path);
+			return ERR_FILE_CANT_READ;
+		}
+	}
+	return OK;
+}
+
+static bool store_padding(const Ref<FileAccess> &p_file, uint32_t p_bytes) {
+	static const uint8_t zeros[256] = {};
+	bool ok = true;
+	while (ok && p_bytes > 0) {
+		uint32_t count = MIN(p_bytes, uint32_t(sizeof(zeros)));
+		ok = p_file->store_buffer(zeros, count);
+		p_bytes -= count;
+	}
+	return ok;
+}
+
+// Writes every entry to a temporary file, which then replaces the existing file
+Error TerrainGeneratorRegionFile::_write_full(const String &p_path, EncodeJob &p_job) {
+	String temp_path = p_path + ".tmp";
+	Error err = OK;
+	Ref<FileAccess> file = FileAccess::open(temp_path, FileAccess::WRITE, &err);
+	if (file.is_null()) {
+		LOG(ERROR, "Cannot open file for writing: ", temp_path, " error: ", err);
+		return (err != OK) ? err : ERR_FILE_CANT_WRITE;
+	}
+	uint64_t offset = HEADER_SIZE + uint64_t(_entries.size()) * ENTRY_SIZE;
+	file->seek(offset);
+	bool ok = true;
+	for (uint32_t i = 0; ok && i < p_job.entry_ids.size(); i++) {
+		Entry &entry = _entries[p_job.entry_ids[i]];
+		const PackedByteArray &data = p_job.results[i];
+		entry.offset = offset;
+		entry.size = data.size();
+		entry.capacity = _get_capacity(_get_min_capacity(p_job.entry_ids[i], entry.size, p_job.raw_sizes[i]));
+		entry.raw_size = p_job.raw_sizes[i];
+		ok = file->store_buffer(data.ptr(), data.size()) && store_padding(file, entry.capacity - entry.size);
+		offset += entry.capacity;
+	}
+	ok = ok && _store_header(file);
+	file.unref(); // Close before renaming
+
+	Ref<DirAccess> da = DirAccess::create_for_path(p_path);
+	if (!ok) {
+		LOG(ERROR, "Cannot write region file: ", temp_path);
+		da->remove(temp_path);
+		return ERR_FILE_CANT_WRITE;
+	}
+	err = da->rename(temp_path, p_path);
+	if (err != OK) {
+		LOG(ERROR, "Cannot replace region file: ", p_path, " error: ", err);
+		da->remove(temp_path);
+	}
+	return err;
+}
+
+// Writes the given entries into the existing file. Entries are appended after the current end rather
+// than overwriting their old tiles, and the directory is only rewritten once they are flushed, so an
+// interrupted save leaves the previous version readable. The abandoned tiles count as waste until
+// save() rewrites the whole file.
+Error TerrainGeneratorRegionFile::_write_partial(const Ref<FileAccess> &p_file, EncodeJob &p_job) {
+	uint64_t end = p_file->get_length();
+	std::vector<Entry> entries = _entries;
+	bool ok = true;
+	p_file->seek(end);
+	for (uint32_t i = 0; ok && i < p_job.entry_ids.size(); i++) {
+		Entry &entry = entries[p_job.entry_ids[i]];
+		const PackedByteArray &data = p_job.results[i];
+		entry.offset = end;
+		entry.size = data.size();
+		entry.capacity = _get_capacity(_get_min_capacity(p_job.entry_ids[i], entry.size, p_job.raw_sizes[i]));
+		entry.raw_size = p_job.raw_sizes[i];
+		ok = p_file->store_buffer(data.ptr(), data.size()) && store_padding(p_file, entry.capacity - entry.size);
+		end += entry.capacity;
+	}
+	if (ok) {
+		p_file->flush();
+		_entries = entries;
+		ok = _store_header(p_file);
+	}
+	if (!ok) {
+		LOG(ERROR, "Cannot write region file: ", p_file->get_path());
+		return ERR_FILE_CANT_WRITE;
+	}
+	return OK;
+}
+
+/////////////////////
+// Public Functions
+/////////////////////
+
+Error TerrainGeneratorRegionFile::open(const String &p_path) {
+	close();
+	Error err = OK;
+	Ref<FileAccess> file = FileAccess::open(p_path, FileAccess::READ, &err);
+	if (file.is_null()) {
+		LOG(ERROR, "Cannot open region file: ", p_path, " error: ", err);
+		return (err != OK) ? err : ERR_FILE_CANT_OPEN;
+	}
+	err = _read_header(file);
+	if (err != OK) {
+		return err;
+	}
+	MutexLock lock(_mutex);
+	_file = file;
+	_path = p_path;
+	return OK;
+}
+
+void TerrainGeneratorRegionFile::close() {
+	MutexLock lock(_mutex);
+	_file.unref();
+	_path = "";
+}
+
+// Reads one tile of a map. Level 0 is full resolution, each level halves it.
+Ref<Image> TerrainGeneratorRegionFile::read_tile(const MapType p_map_type, const Vector2i &p_tile, const int p_level) {
+	if (!is_open()) {
+		LOG(ERROR, "No region file open");
+		return Ref<Image>();
+	}
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX) {
+		LOG(ERROR, "Specified map type out of range");
+		return Ref<Image>();
+	}
+	if (p_level < 0 || p_level >= _header.level_count) {
+		LOG(ERROR, "Level ", p_level, " out of range. Levels: ", _header.level_count);
+		return Ref<Image>();
+	}
+	int tiles = _get_tiles_per_side(p_level);
+	if (p_tile.x < 0 || p_tile.y < 0 || p_tile.x >= tiles || p_tile.y >= tiles) {
+		LOG(ERROR, "Tile ", p_tile, " out of range for level ", p_level, ". Tiles: ", tiles);
+		return Ref<Image>();
+	}
+	int tile_size = _header.tile_size;
+	PackedByteArray data;
+	data.resize(tile_size * tile_size * 4);
+	DecodeJob job;
+	job.entry_ids.push_back(_get_entry_id(p_map_type, p_level, p_tile));
+	job.outputs[p_map_type] = data.ptrw();
+	job.output_width = tile_size;
+	job.output_origin = p_tile;
+	if (_read_entries(job.entry_ids, job.compressed) != OK) {
+		return Ref<Image>();
+	}
+	_decode_entries(job, false);
+	if (job.failed.is_set()) {
+		LOG(ERROR, "Cannot decode tile ", p_tile, " of ", TYPESTR[p_map_type], " in ", _path);
+		return Ref<Image>();
+	}
+	return Image::create_from_data(tile_size, tile_size, false, FORMAT[p_map_type], data);
+}
+
+// Reads a whole map at the given level, decoding its tiles in parallel
+Ref<Image> TerrainGeneratorRegionFile::read_map(const MapType p_map_type, const int p_level) {
+	if (!is_open()) {
+		LOG(ERROR, "No region file open");
+		return Ref<Image>();
+	}
+	if (p_map_type < 0 || p_map_type >= TYPE_MAX) {
+		LOG(ERROR, "Specified map type out of range");
+		return Ref<Image>();
+	}
+	if (p_level < 0 || p_level >= _header.level_count) {
+		LOG(ERROR, "Level ", p_level, " out of range. Levels: ", _header.level_count);
+		return Ref<Image>();
+	}
+	int width = _header.region_size >> p_level;
+	int tiles = _get_tiles_per_side(p_level);
+	PackedByteArray data;
+	data.resize(width * width * 4);
+	DecodeJob job;
+	for (int i = 0; i < tiles * tiles; i++) {
+		job.entry_ids.push_back(_get_entry_id(p_map_type, p_level, Vector2i(i % tiles, i / tiles)));
+	}
+	job.outputs[p_map_type] = data.ptrw();
+	job.output_width = width;
+	if (_read_entries(job.entry_ids, job.compressed) != OK) {
+		return Ref<Image>();
+	}
+	_decode_entries(job, true);
+	if (job.failed.is_set()) {
+		LOG(ERROR, "Cannot decode ", TYPESTR[p_map_type], " level ", p_level, " in ", _path);
+		return Ref<Image>();
+	}
+	return Image::create_from_data(width, width, false, FORMAT[p_map_type], data);
+}
+
+// Reads all full resolution maps and instances into a new region. Tiles are decoded on the
+// WorkerThreadPool unless p_parallel is false, as when already called from a worker thread.
+Ref<TerrainGeneratorRegion> TerrainGeneratorRegionFile::read_region(const bool p_parallel) {
+	if (!is_open()) {
+		LOG(ERROR, "No region file open");
+		return Ref<TerrainGeneratorRegion>();
+	}
+	int region_size = _header.region_size;
+	int tiles = _get_tiles_per_side(0);
+	PackedByteArray map_data[TYPE_MAX];
+	DecodeJob job;
+	job.output_width = region_size;
+	for (int m = 0; m < TYPE_MAX; m++) {
+		map_data[m].resize(region_size * region_size * 4);
+		job.outputs[m] = map_data[m].ptrw();
+		for (int i = 0; i < tiles * tiles; i++) {
+			job.entry_ids.push_back(_get_entry_id(MapType(m), 0, Vector2i(i % tiles, i / tiles)));
+		}
+	}
+	job.entry_ids.push_back(_get_instances_entry_id());
+	if (_read_entries(job.entry_ids, job.compressed) != OK) {
+		return Ref<TerrainGeneratorRegion>();
+	}
+
+	// Instances are last
+	PackedByteArray instance_data = job.compressed.back();
+	job.entry_ids.pop_back();
+	job.compressed.pop_back();
+	const Entry &instance_entry = _entries[_get_instances_entry_id()];
+	Variant instances;
+	PackedByteArray raw;
+	raw.resize(instance_entry.raw_size);
+	int64_t size = Compression::decompress(raw.ptrw(), raw.size(), instance_data.ptr(), instance_data.size(), Compression::MODE_ZSTD);
+	if (size != raw.size() || decode_variant(instances, raw.ptr(), raw.size()) != OK || instances.get_type() != Variant::DICTIONARY) {
+		LOG(ERROR, "Cannot decode instances in ", _path);
+		return Ref<TerrainGeneratorRegion>();
+	}
+
+	_decode_entries(job, p_parallel);
+	if (job.failed.is_set()) {
+		LOG(ERROR, "Cannot decode maps in ", _path);
+		return Ref<TerrainGeneratorRegion>();
+	}
+
+	Dictionary dict;
+	dict["version"] = _header.version;
+	dict["region_size"] = region_size;
+	dict["vertex_spacing"] = _header.vertex_spacing;
+	dict["height_range"] = _header.height_range;
+	dict["location"] = _header.location;
+	for (int m = 0; m < TYPE_MAX; m++) {
+		String key = (m == TYPE_HEIGHT) ? "height_map" : (m == TYPE_CONTROL) ? "control_map" : "color_map";
+		dict[key] = Image::create_from_data(region_size, region_size, false, FORMAT[m], map_data[m]);
+	}
+	dict["instances"] = instances;
+	Ref<TerrainGeneratorRegion> region;
+	region.instantiate();
+	region->set_data(dict);
+	region->get_color_map()->generate_mipmaps();
+	region->clear_dirty();
+	return region;
+}
+
+/**
+ * Writes the region to p_path. If the file already exists with the same layout, location and vertex
+ * spacing, only tiles under the region's dirty tiles, and the coarser levels above them, are encoded
+ * and appended to it.
+ * Otherwise, or once more than MAX_WASTE of the file is unused, the whole file is rewritten.
+ * Heights quantized to 16 bits depend on the height range, so all height tiles are written when it changes.
+ * Instances are always written.
+ */
+Error TerrainGeneratorRegionFile::save(const Ref<TerrainGeneratorRegion> &p_region, const String &p_path, const bool p_16_bit) {
+	if (p_region.is_null() || p_region->get_region_size() == 0) {
+		LOG(ERROR, "Region is not valid");
+		return ERR_INVALID_PARAMETER;
+	}
+	if (p_path.is_empty()) {
+		LOG(ERROR, "No valid path provided");
+		return ERR_FILE_BAD_PATH;
+	}
+	int region_size = p_region->get_region_size();
+	Ref<Image> maps[TYPE_MAX];
+	for (int m = 0; m < TYPE_MAX; m++) {
+		maps[m] = p_region->get_map(MapType(m));
+		if (maps[m].is_null() || maps[m]->get_width() != region_size || maps[m]->get_height() != region_size) {
+			LOG(ERROR, "Region ", p_region->get_location(), " ", TYPESTR[m], " is missing or the wrong size");
+			return ERR_INVALID_DATA;
+		}
+		if (maps[m]->get_format() != FORMAT[m]) {
+			maps[m] = maps[m]->duplicate();
+			maps[m]->convert(FORMAT[m]);
+		}
+	}
+	close();
+
+	HeightEncoding encoding = p_16_bit ? HEIGHT_QUANTIZED16 : HEIGHT_FLOAT32;
+	Vector2 height_range = p_region->get_height_range();
+	if (p_16_bit) {
+		// The stored range may be wider than the data, and quantization should use all of it
+		const float *heights = reinterpret_cast<const float *>(maps[TYPE_HEIGHT]->ptr());
+		height_range = Vector2(FLT_MAX, -FLT_MAX);
+		for (int i = 0; i < region_size * region_size; i++) {
+			if (!Math::is_nan(heights[i])) {
+				height_range.x = MIN(height_range.x, heights[i]);
+				height_range.y = MAX(height_range.y, heights[i]);
+			}
+		}
+		if (height_range.x > height_range.y) {
+			height_range = V2_ZERO;
+		}
+	}
+
+	// Reuse the existing file if its layout matches
+	Ref<FileAccess> file;
+	bool partial = false;
+	bool heights_changed = false;
+	if (!p_region->is_all_dirty() && FileAccess::exists(p_path)) {
+		file = FileAccess::open(p_path, FileAccess::READ_WRITE);
+		if (file.is_valid() && _read_header(file) == OK && _header.region_size == region_size &&
+				_header.tile_size == MIN(TerrainGeneratorRegion::TILE_SIZE, region_size) && _header.height_encoding == encoding &&
+				_header.location == p_region->get_location() &&
+				Math::is_equal_approx(_header.vertex_spacing, p_region->get_vertex_spacing())) {
+			uint64_t used = HEADER_SIZE + uint64_t(_entries.size()) * ENTRY_SIZE;
+			for (const Entry &entry : _entries) {
+				used += entry.capacity;
+			}
+			partial = used >= uint64_t(file->get_length() * (1.f - MAX_WASTE));
+			heights_changed = p_16_bit && _header.height_range != height_range;
+		}
+	}
+	if (!partial) {
+		file.unref();
+		_header = Header();
+		_setup_layout(region_size, TerrainGeneratorRegion::TILE_SIZE);
+	}
+	_header.height_encoding = encoding;
+	_header.location = p_region->get_location();
+	_header.vertex_spacing = p_region->get_vertex_spacing();
+	_header.height_range = height_range;
+	_header.version = TerrainGeneratorData::CURRENT_VERSION;
+
+	EncodeJob job;
+	for (int m = 0; m < TYPE_MAX; m++) {
+		job.maps[m] = *maps[m];
+	}
+	Dictionary instances = p_region->get_instances();
+	int length = 0;
+	encode_variant(instances, nullptr, length);
+	job.instances.resize(length);
+	encode_variant(instances, job.instances.ptrw(), length);
+
+	if (partial) {
+		std::vector<bool> dirty(_entries.size(), false);
+		int tiles = _get_tiles_per_side(0);
+		for (int m = 0; m < TYPE_MAX; m++) {
+			for (int y = 0; y < tiles; y++) {
+				for (int x = 0; x < tiles; x++) {
+					if (!p_region->is_tile_dirty(Vector2i(x, y)) && !(m == TYPE_HEIGHT && heights_changed)) {
+						continue;
+					}
+					for (int level = 0; level < _header.level_count; level++) {
+						dirty[_get_entry_id(MapType(m), level, Vector2i(x >> level, y >> level))] = true;
+					}
+				}
+			}
+		}
+		dirty[_get_instances_entry_id()] = true;
+		for (int i = 0; i < int(dirty.size()); i++) {
+			if (dirty[i]) {
+				job.entry_ids.push_back(i);
+			}
+		}
+	} else {
+		for (int i = 0; i < int(_entries.size()); i++) {
+			job.entry_ids.push_back(i);
+		}
+	}
+	job.results.resize(job.entry_ids.size());
+	job.raw_sizes.resize(job.entry_ids.size());
+	WorkerThreadPool *wtp = WorkerThreadPool::get_singleton();
+	WorkerThreadPool::GroupID task_id = wtp->add_template_group_task(this, &TerrainGeneratorRegionFile::_encode_entry,
+			&job, job.entry_ids.size(), -1, true, "TerrainGenerator region encode");
+	wtp->wait_for_group_task_completion(task_id);
+	for (const PackedByteArray &result : job.results) {
+		if (result.is_empty()) {
+			LOG(ERROR, "Cannot compress region ", _header.location);
+			return ERR_CANT_CREATE;
+		}
+	}
+
+	Error err = partial ? _write_partial(file, job) : _write_full(p_path, job);
+	if (err == OK) {
+		LOG(INFO, "Wrote ", job.entry_ids.size(), " of ", _entries.size(), " tiles to ", p_path);
+	}
+	return err;
+}
+
+Ref<TerrainGeneratorRegion> TerrainGeneratorRegionFile::load_region(const String &p_path, const bool p_parallel) {
+	Ref<TerrainGeneratorRegionFile> file;
+	file.instantiate();
+	if (file->open(p_path) != OK) {
+		return Ref<TerrainGeneratorRegion>();
+	}
+	return file->read_region(p_parallel);
+}
+
+/**
+ * Converts all TerrainGenerator*.res region files in p_src_dir to region files in p_dst_dir.
+ * Returns a report comparing file sizes and load times, and the time to read the first
+ * height tile and the lowest height level of each region.
+ */
+Dictionary TerrainGeneratorRegionFile::convert_directory(const String &p_src_dir, const String &p_dst_dir, const bool p_16_bit) {
+	Dictionary report;
+	PackedStringArray files = Util::get_files(p_src_dir, "TerrainGenerator*.res");
+	if (files.is_empty()) {
+		LOG(WARN, "No TerrainGenerator region files found in: ", p_src_dir);
+		return report;
+	}
+	Error err = DirAccess::make_dir_recursive_absolute(p_dst_dir);
+	if (err != OK) {
+		LOG(ERROR, "Cannot create directory: ", p_dst_dir, " error: ", err);
+		return report;
+	}
+	Time *time = Time::get_singleton();
+	int converted = 0;
+	uint64_t res_bytes = 0;
+	uint64_t tiled_bytes = 0;
+	uint64_t res_load_usec = 0;
+	uint64_t tiled_load_usec = 0;
+	uint64_t tile_read_usec = 0;
+	uint64_t mip_read_usec = 0;
+	for (int i = 0; i < files.size(); i++) {
+		String src_path = p_src_dir + String("/") + files[i];
+		Vector2i loc = Util::filename_to_location(files[i]);
+		uint64_t start = time->get_ticks_usec();
+		Ref<TerrainGeneratorRegion> region = CoreBind::ResourceLoader::get_singleton()->load(src_path, "TerrainGeneratorRegion", CoreBind::ResourceLoader::CACHE_MODE_IGNORE);
+		uint64_t load_usec = time->get_ticks_usec() - start;
+		if (region.is_null() || loc.x == INT32_MAX) {
+			LOG(ERROR, "Cannot load region at ", src_path);
+			continue;
+		}
+		region->set_location(loc);
+		String dst_path = p_dst_dir + String("/") + Util::location_to_filename(loc, EXTENSION);
+		Ref<TerrainGeneratorRegionFile> file;
+		file.instantiate();
+		if (file->save(region, dst_path, p_16_bit) != OK) {
+			LOG(ERROR, "Cannot convert region at ", src_path);
+			continue;
+		}
+
+		start = time->get_ticks_usec();
+		if (load_region(dst_path).is_null()) {
+			LOG(ERROR, "Cannot read converted region at ", dst_path);
+			continue;
+		}
+		tiled_load_usec += time->get_ticks_usec() - start;
+		res_load_usec += load_usec;
+		file->open(dst_path);
+		start = time->get_ticks_usec();
+		file->read_tile(TYPE_HEIGHT, V2I_ZERO);
+		tile_read_usec += time->get_ticks_usec() - start;
+		start = time->get_ticks_usec();
+		file->read_map(TYPE_HEIGHT, file->get_level_count() - 1);
+		mip_read_usec += time->get_ticks_usec() - start;
+		file->close();
+
+		res_bytes += FileAccess::get_file_as_bytes(src_path).size();
+		tiled_bytes += FileAccess::get_file_as_bytes(dst_path).size();
+		converted++;
+	}
+	report["regions"] = converted;
+	report["failed"] = files.size() - converted;
+	report["res_bytes"] = int64_t(res_bytes);
+	report["tiled_bytes"] = int64_t(tiled_bytes);
+	report["size_ratio"] = (res_bytes > 0) ? double(tiled_bytes) / double(res_bytes) : 0.0;
+	report["res_load_msec"] = double(res_load_usec) / 1000.0;
+	report["tiled_load_msec"] = double(tiled_load_usec) / 1000.0;
+	report["tile_read_msec"] = double(tile_read_usec) / 1000.0;
+	report["mip_read_msec"] = double(mip_read_usec) / 1000.0;
+	LOG(MESG, "Converted ", converted, " of ", files.size(), " regions to ", p_dst_dir, ": ", report);
+	return report;
+}
+
+/////////////////////
+// Protected Functions
+/////////////////////
+
+void TerrainGeneratorRegionFile::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("open", "path"), &TerrainGeneratorRegionFile::open);
+	ClassDB::bind_method(D_METHOD("close"), &TerrainGeneratorRegionFile::close);
+	ClassDB::bind_method(D_METHOD("is_open"), &TerrainGeneratorRegionFile::is_open);
+	ClassDB::bind_method(D_METHOD("get_path"), &TerrainGeneratorRegionFile::get_path);
+	ClassDB::bind_method(D_METHOD("get_region_size"), &TerrainGeneratorRegionFile::get_region_size);
+	ClassDB::bind_method(D_METHOD("get_tile_size"), &TerrainGeneratorRegionFile::get_tile_size);
+	ClassDB::bind_method(D_METHOD("get_level_count"), &TerrainGeneratorRegionFile::get_level_count);
+	ClassDB::bind_method(D_METHOD("get_location"), &TerrainGeneratorRegionFile::get_location);
+	ClassDB::bind_method(D_METHOD("get_height_range"), &TerrainGeneratorRegionFile::get_height_range);
+	ClassDB::bind_method(D_METHOD("is_16_bit"), &TerrainGeneratorRegionFile::is_16_bit);
+
+	ClassDB::bind_method(D_METHOD("read_tile", "map_type", "tile", "level"), &TerrainGeneratorRegionFile::read_tile, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("read_map", "map_type", "level"), &TerrainGeneratorRegionFile::read_map, DEFVAL(0));
+	ClassDB::bind_method(D_METHOD("read_region", "parallel"), &TerrainGeneratorRegionFile::read_region, DEFVAL(true));
+	ClassDB::bind_method(D_METHOD("save", "region", "path", "save_16_bit"), &TerrainGeneratorRegionFile::save, DEFVAL(false));
+
+	ClassDB::bind_static_method("TerrainGeneratorRegionFile", D_METHOD("load_region", "path", "parallel"), &TerrainGeneratorRegionFile::load_region, DEFVAL(true));
+	ClassDB::bind_static_method("TerrainGeneratorRegionFile", D_METHOD("convert_directory", "src_dir", "dst_dir", "save_16_bit"), &TerrainGeneratorRegionFile::convert_directory, DEFVAL(false));
+}
@@ -0,0 +1,129 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/io/file_access.h>
+#include <godot/core/os/mutex.h>
+#include <godot/core/templates/safe_refcount.h>
+#include <vector>
+
+#include "constants.h"
+#include "terrain_generator_region.h"
+
+// Reads and writes regions in the tiled region file format (*.tgr).
+// Each map is split into TerrainGeneratorRegion::TILE_SIZE tiles, plus a pyramid of point sampled
+// (box filtered for color) mip levels down to a single tile. Every tile is delta encoded against
+// its neighbors, split into byte planes and compressed on its own, so one tile or one low
+// resolution level can be read without decoding the rest of the region.
+// Heights are stored as 32-bit floats, or quantized to 16 bits over the region height range.
+//
+// Layout: header, directory of entries, then the compressed tiles in any order. Entries are
+// ordered by map, level, row and column, followed by one entry for the instances.
+// Saving only the dirty tiles of an edited region appends them and then points the directory at
+// them, so the previous tiles stay intact until the directory is written.
+class TerrainGeneratorRegionFile : public RefCounted {
+	GDCLASS(TerrainGeneratorRegionFile, RefCounted);
+	CLASS_NAME();
+
+public: // Constants
+	static inline const char *EXTENSION = "tgr";
+	static inline const uint32_t MAGIC = 0x46524754; // "TGRF"
+	static inline const uint32_t FORMAT_VERSION = 1;
+	static inline const int HEADER_SIZE = 64;
+	static inline const int ENTRY_SIZE = 24;
+	static inline const real_t MAX_WASTE = 0.5f; // Ratio of unused bytes that triggers a full rewrite
+	static inline const uint32_t MAX_INSTANCE_RATIO = 256; // Max decompressed to reserved bytes of instances
+
+	enum HeightEncoding {
+		HEIGHT_FLOAT32,
+		HEIGHT_QUANTIZED16,
+	};
+
+private:
+	struct Header {
+		int region_size = 0;
+		int tile_size = 0;
+		int level_count = 0;
+		HeightEncoding height_encoding = HEIGHT_FLOAT32;
+		Vector2i location = V2I_MAX;
+		real_t vertex_spacing = 1.f;
+		Vector2 height_range = V2_ZERO;
+		real_t version = 0.f;
+	};
+
+	struct Entry {
+		uint64_t offset = 0;
+		uint32_t size = 0; // Compressed
+		uint32_t capacity = 0; // Bytes reserved in the file
+		uint32_t raw_size = 0; // Decompressed
+	};
+
+	struct EncodeJob {
+		const Image *maps[TYPE_MAX] = {};
+		PackedByteArray instances;
+		std::vector<int> entry_ids;
+		std::vector<PackedByteArray> results;
+		std::vector<uint32_t> raw_sizes;
+	};
+
+	struct DecodeJob {
+		std::vector<int> entry_ids;
+		std::vector<PackedByteArray> compressed;
+		uint8_t *outputs[TYPE_MAX] = {}; // Image data of each map, a level or a single tile
+		int output_width = 0;
+		Vector2i output_origin = V2I_ZERO; // In tiles
+		SafeFlag failed;
+	};
+
+	Ref<FileAccess> _file;
+	String _path;
+	Mutex _mutex; // Guards _file position for reads
+	Header _header;
+	std::vector<Entry> _entries;
+	std::vector<int> _level_offsets; // First entry of each level within a map
+	int _entries_per_map = 0;
+
+	void _setup_layout(const int p_region_size, const int p_tile_size);
+	int _get_tiles_per_side(const int p_level) const { return MAX(1, (_header.region_size >> p_level) / _header.tile_size); }
+	int _get_entry_id(const MapType p_map_type, const int p_level, const Vector2i &p_tile) const;
+	int _get_instances_entry_id() const { return TYPE_MAX * _entries_per_map; }
+	void _get_entry_tile(const int p_entry_id, MapType &r_map_type, int &r_level, Vector2i &r_tile) const;
+	int _get_element_size(const MapType p_map_type) const;
+	static uint32_t _get_capacity(const uint32_t p_size) { return (p_size + 63) & ~63u; }
+	uint32_t _get_min_capacity(const int p_entry_id, const uint32_t p_size, const uint32_t p_raw_size) const;
+
+	bool _store_header(const Ref<FileAccess> &p_file) const;
+	Error _read_header(const Ref<FileAccess> &p_file);
+	void _encode_entry(const uint32_t p_index, EncodeJob *p_job);
+	void _decode_entry(const uint32_t p_index, DecodeJob *p_job);
+	void _decode_entries(DecodeJob &p_job, const bool p_parallel);
+	Error _read_entries(const std::vector<int> &p_entry_ids, std::vector<PackedByteArray> &r_data);
+	Error _write_full(const String &p_path, EncodeJob &p_job);
+	Error _write_partial(const Ref<FileAccess> &p_file, EncodeJob &p_job);
+
+public:
+	TerrainGeneratorRegionFile() {}
+	~TerrainGeneratorRegionFile() { close(); }
+
+	Error open(const String &p_path);
+	void close();
+	bool is_open() const { return _file.is_valid(); }
+	String get_path() const { return _path; }
+	int get_region_size() const { return _header.region_size; }
+	int get_tile_size() const { return _header.tile_size; }
+	int get_level_count() const { return _header.level_count; }
+	Vector2i get_location() const { return _header.location; }
+	Vector2 get_height_range() const { return _header.height_range; }
+	bool is_16_bit() const { return _header.height_encoding == HEIGHT_QUANTIZED16; }
+
+	Ref<Image> read_tile(const MapType p_map_type, const Vector2i &p_tile, const int p_level = 0);
+	Ref<Image> read_map(const MapType p_map_type, const int p_level = 0);
+	Ref<TerrainGeneratorRegion> read_region(const bool p_parallel = true);
+	Error save(const Ref<TerrainGeneratorRegion> &p_region, const String &p_path, const bool p_16_bit = false);
+
+	static Ref<TerrainGeneratorRegion> load_region(const String &p_path, const bool p_parallel = true);
+	static Dictionary convert_directory(const String &p_src_dir, const String &p_dst_dir, const bool p_16_bit = false);
+
+protected:
+	static void _bind_methods();
+};
@@ -0,0 +1,260 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#include <godot/core/io/compression.h>
+#include <cstring>
+
+#include "logger.h"
+#include "terrain_generator_data.h"
+#include "terrain_generator_undo_delta.h"
+#include "terrain_generator_util.h"
+
+/////////////////////
+// Private Functions
+/////////////////////
+
+// Region locations are within REGION_MAP_SIZE and regions have at most 32 tiles per side
+static inline uint32_t tile_key(const Vector2i &p_region_loc, const MapType p_map_type, const Vector2i &p_tile) {
+	const int half = TerrainGeneratorData::REGION_MAP_SIZE / 2;
+	uint32_t loc = (uint32_t(p_region_loc.x + half) << 5) | uint32_t(p_region_loc.y + half);
+	return ((loc * TYPE_MAX + p_map_type) << 10) | (uint32_t(p_tile.x) << 5) | uint32_t(p_tile.y);
+}
+
+static void copy_rect(const Image *p_map, const Rect2i &p_rect, uint8_t *r_dst) {
+	const int pixel_size = Image::get_format_pixel_size(p_map->get_format());
+	const int row_size = p_rect.size.x * pixel_size;
+	const uint8_t *src = p_map->ptr();
+	for (int y = 0; y < p_rect.size.y; y++) {
+		const uint8_t *src_row = src + ((p_rect.position.y + y) * p_map->get_width() + p_rect.position.x) * pixel_size;
+		memcpy(r_dst + y * row_size, src_row, row_size);
+	}
+}
+
+static void paste_rect(Image *p_map, const Rect2i &p_rect, const uint8_t *p_src) {
+	const int pixel_size = Image::get_format_pixel_size(p_map->get_format());
+	const int row_size = p_rect.size.x * pixel_size;
+	uint8_t *dst = p_map->ptrw();
+	for (int y = 0; y < p_rect.size.y; y++) {
+		uint8_t *dst_row = dst + ((p_rect.position.y + y) * p_map->get_width() + p_rect.position.x) * pixel_size;
+		memcpy(dst_row, p_src + y * row_size, row_size);
+	}
+}
+
+static inline uint64_t instance_bytes(const TerrainGeneratorRegion *p_region) {
+	return uint64_t(p_region->get_instance_store()->get_instance_count()) * InstanceStore::BUFFER_FLOATS * sizeof(float);
+}
+
+static PackedByteArray compress_buffer(const uint8_t *p_data, const uint32_t p_size) {
+	PackedByteArray result;
+	int64_t max_size = Compression::get_max_compressed_buffer_size(p_size, Compression::MODE_ZSTD);
+	result.resize(max_size);
+	int64_t size = Compression::compress(result.ptrw(), p_data, p_size, Compression::MODE_ZSTD);
+	result.resize(MAX(size, 0));
+	return result;
+}
+
+// Stores the tile before the operation, and the tile after XORed with it, so unchanged pixels
+// compress to runs of zeros. Runs on the WorkerThreadPool.
+void TerrainGeneratorUndoDelta::_compress_task(void *p_userdata) {
+	uint64_t bytes = 0;
+	std::vector<uint8_t> diff;
+	for (Tile &tile : _tiles) {
+		const uint8_t *before = tile.data[0].ptr();
+		const uint8_t *after = tile.data[1].ptr();
+		diff.resize(tile.raw_size);
+		for (uint32_t i = 0; i < tile.raw_size; i++) {
+			diff[i] = before[i] ^ after[i];
+		}
+		tile.data[0] = compress_buffer(before, tile.raw_size);
+		tile.data[1] = compress_buffer(diff.data(), tile.raw_size);
+		bytes += tile.data[0].size() + tile.data[1].size();
+	}
+	for (const auto &it : _regions) {
+		bytes += it.second.instance_bytes;
+	}
+	_compressed = true;
+	_bytes.set(bytes);
+}
+
+void TerrainGeneratorUndoDelta::_wait_for_compression() {
+	if (_task_id != WorkerThreadPool::INVALID_TASK_ID) {
+		WorkerThreadPool::get_singleton()->wait_for_task_completion(_task_id);
+		_task_id = WorkerThreadPool::INVALID_TASK_ID;
+	}
+}
+
+/////////////////////
+// Public Functions
+/////////////////////
+
+// Stores the height range of the region, and its instances if requested, once per operation
+void TerrainGeneratorUndoDelta::capture_region(const TerrainGeneratorRegion *p_region, const bool p_instances) {
+	if (!p_region) {
+		return;
+	}
+	auto it = _regions.find(p_region->get_location());
+	if (it == _regions.end()) {
+		it = _regions.emplace(p_region->get_location(), RegionState()).first;
+		it->second.height_range[0] = p_region->get_height_range();
+	}
+	RegionState &state = it->second;
+	if (p_instances && !state.has_instances) {
+		state.instances[0] = p_region->get_instances();
+		state.has_instances = true;
+		state.instance_bytes = instance_bytes(p_region);
+		_bytes.add(state.instance_bytes);
+	}
+}
+
+// Copies the map tile containing the pixel, if not already copied. Call before changing the pixel.
+void TerrainGeneratorUndoDelta::capture_tile(const TerrainGeneratorRegion *p_region, const MapType p_map_type, const Vector2i &p_pixel) {
+	Vector2i tile = p_pixel / TILE_SIZE;
+	uint32_t key = tile_key(p_region->get_location(), p_map_type, tile);
+	if (_tile_ids.count(key)) {
+		return;
+	}
+	const Image *map = p_region->get_map_ptr(p_map_type);
+	if (!map) {
+		return;
+	}
+	Rect2i rect = Rect2i(tile * TILE_SIZE, V2I(TILE_SIZE)).intersection(Rect2i(V2I_ZERO, map->get_size()));
+	if (!rect.has_area()) {
+		return;
+	}
+	Tile new_tile;
+	new_tile.region_loc = p_region->get_location();
+	new_tile.map_type = p_map_type;
+	new_tile.rect = rect;
+	new_tile.raw_size = rect.get_area() * Image::get_format_pixel_size(map->get_format());
+	new_tile.data[0].resize(new_tile.raw_size);
+	copy_rect(map, rect, new_tile.data[0].ptrw());
+	_tile_ids[key] = _tiles.size();
+	_tiles.push_back(new_tile);
+	_bytes.add(new_tile.raw_size);
+}
+
+// Copies the edited tiles and region state after the operation, then compresses in the background
+void TerrainGeneratorUndoDelta::finish(const TerrainGeneratorData *p_data) {
+	uint64_t bytes = 0;
+	for (Tile &tile : _tiles) {
+		TerrainGeneratorRegion *region = p_data->get_region_ptr(tile.region_loc);
+		const Image *map = region ? region->get_map_ptr(tile.map_type) : nullptr;
+		if (!map || !Rect2i(V2I_ZERO, map->get_size()).encloses(tile.rect)) {
+			tile.data[1] = tile.data[0];
+		} else {
+			tile.data[1].resize(tile.raw_size);
+			copy_rect(map, tile.rect, tile.data[1].ptrw());
+		}
+		bytes += tile.raw_size * 2;
+	}
+	for (auto &it : _regions) {
+		TerrainGeneratorRegion *region = p_data->get_region_ptr(it.first);
+		if (!region) {
+			continue;
+		}
+		RegionState &state = it.second;
+		state.height_range[1] = region->get_height_range();
+		if (state.has_instances) {
+			state.instances[1] = region->get_instances();
+			state.instance_bytes += instance_bytes(region);
+		}
+		bytes += state.instance_bytes;
+	}
+	_bytes.set(bytes);
+	if (!_tiles.empty()) {
+		_task_id = WorkerThreadPool::get_singleton()->add_template_task(this, &TerrainGeneratorUndoDelta::_compress_task,
+				(void *)nullptr, false, "TerrainGenerator undo compression");
+	}
+}
+
+// Restores the regions to their state before (undo) or after (redo) the operation. Marks the
+// regions edited, with the restored areas queued for TerrainGeneratorData::update_maps().
+bool TerrainGeneratorUndoDelta::apply(TerrainGeneratorData *p_data, const bool p_redo) {
+	if (_expired) {
+		LOG(WARN, "This undo step was discarded to stay within the undo memory budget");
+		return false;
+	}
+	_wait_for_compression();
+	std::vector<uint8_t> raw;
+	std::vector<uint8_t> diff;
+	for (const Tile &tile : _tiles) {
+		TerrainGeneratorRegion *region = p_data->get_region_ptr(tile.region_loc);
+		Image *map = region ? region->get_map_ptr(tile.map_type) : nullptr;
+		if (!map || !Rect2i(V2I_ZERO, map->get_size()).encloses(tile.rect) ||
+				tile.raw_size != tile.rect.get_area() * Image::get_format_pixel_size(map->get_format())) {
+			LOG(ERROR, "Region ", tile.region_loc, " ", TerrainGeneratorRegion::TYPESTR[tile.map_type], " no longer matches the undo data");
+			continue;
+		}
+		raw.resize(tile.raw_size);
+		if (_compressed) {
+			int64_t size = Compression::decompress(raw.data(), tile.raw_size, tile.data[0].ptr(), tile.data[0].size(), Compression::MODE_ZSTD);
+			if (size != int64_t(tile.raw_size)) {
+				LOG(ERROR, "Undo data for region ", tile.region_loc, " is corrupt");
+				continue;
+			}
+			if (p_redo) {
+				diff.resize(tile.raw_size);
+				size = Compression::decompress(diff.data(), tile.raw_size, tile.data[1].ptr(), tile.data[1].size(), Compression::MODE_ZSTD);
+				if (size != int64_t(tile.raw_size)) {
+					LOG(ERROR, "Redo data for region ", tile.region_loc, " is corrupt");
+					continue;
+				}
+				for (uint32_t i = 0; i < tile.raw_size; i++) {
+					raw[i] ^= diff[i];
+				}
+			}
+		} else {
+			memcpy(raw.data(), tile.data[p_redo ? 1 : 0].ptr(), tile.raw_size);
+		}
+		paste_rect(map, tile.rect, raw.data());
+		if (tile.map_type == TYPE_COLOR) {
+			Util::update_mipmaps(region->get_map(tile.map_type), tile.rect);
+		}
+		region->set_edited(true);
+		region->add_update_area(tile.map_type, tile.rect);
+		region->add_dirty_area(tile.rect);
+		region->set_modified(true);
+	}
+	int side = p_redo ? 1 : 0;
+	for (const auto &it : _regions) {
+		TerrainGeneratorRegion *region = p_data->get_region_ptr(it.first);
+		if (!region) {
+			continue;
+		}
+		const RegionState &state = it.second;
+		region->set_height_range(state.height_range[side]);
+		if (state.has_instances) {
+			region->set_instances(state.instances[side]);
+		}
+		region->set_edited(true);
+		region->set_modified(true);
+	}
+	return true;
+}
+
+// Frees the stored data. The delta can no longer be applied.
+void TerrainGeneratorUndoDelta::expire() {
+	_wait_for_compression();
+	_tiles.clear();
+	_tile_ids.clear();
+	_regions.clear();
+	_expired = true;
+	_bytes.set(0);
+}
+
+std::vector<Vector2i> TerrainGeneratorUndoDelta::get_region_locations() const {
+	std::vector<Vector2i> locations;
+	locations.reserve(_regions.size());
+	for (const auto &it : _regions) {
+		locations.push_back(it.first);
+	}
+	return locations;
+}
+
+/////////////////////
+// Protected Functions
+/////////////////////
+
+void TerrainGeneratorUndoDelta::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("is_expired"), &TerrainGeneratorUndoDelta::is_expired);
+	ClassDB::bind_method(D_METHOD("get_tile_count"), &TerrainGeneratorUndoDelta::get_tile_count);
+}
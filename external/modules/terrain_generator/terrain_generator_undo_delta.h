@@ -0,0 +1,73 @@
+// Copyright © 2025 Cory Petkovsek, Roope Palmroos, and Contributors.
+
+#pragma once
+
+#include <godot/core/object/worker_thread_pool.h>
+#include <godot/core/templates/safe_refcount.h>
+#include <unordered_map>
+#include <vector>
+
+#include "constants.h"
+#include "terrain_generator_region.h"
+
+class TerrainGeneratorData;
+
+// The map tiles and region state changed by one editor operation, for undo and redo.
+// Map tiles are copied as they are first touched, so starting an operation copies nothing. When the
+// operation finishes the edited tiles are copied again, then both copies are compressed on the
+// WorkerThreadPool. Instances and height ranges are kept per region.
+// Deltas may be expired to keep the undo history within TerrainGenerator::undo_memory_budget,
+// after which they can no longer be applied.
+class TerrainGeneratorUndoDelta : public RefCounted {
+	GDCLASS(TerrainGeneratorUndoDelta, RefCounted);
+	CLASS_NAME();
+
+public: // Constants
+	static inline const int TILE_SIZE = TerrainGeneratorRegion::TILE_SIZE;
+
+private:
+	struct Tile {
+		Vector2i region_loc;
+		MapType map_type = TYPE_HEIGHT;
+		Rect2i rect; // In map pixels
+		uint32_t raw_size = 0;
+		PackedByteArray data[2]; // Before and after the operation
+	};
+
+	struct RegionState {
+		Vector2 height_range[2];
+		Dictionary instances[2];
+		bool has_instances = false;
+		uint64_t instance_bytes = 0; // Estimated, for both copies
+	};
+
+	std::vector<Tile> _tiles;
+	std::unordered_map<uint32_t, int> _tile_ids; // By tile key
+	std::unordered_map<Vector2i, RegionState, Vector2iHash> _regions;
+	WorkerThreadPool::TaskID _task_id = WorkerThreadPool::INVALID_TASK_ID;
+	bool _compressed = false; // Written by the compression task
+	bool _expired = false;
+	SafeNumeric<uint64_t> _bytes;
+
+	void _compress_task(void *p_userdata);
+	void _wait_for_compression();
+
+public:
+	TerrainGeneratorUndoDelta() {}
+	~TerrainGeneratorUndoDelta() { _wait_for_compression(); }
+
+	void capture_region(const TerrainGeneratorRegion *p_region, const bool p_instances);
+	void capture_tile(const TerrainGeneratorRegion *p_region, const MapType p_map_type, const Vector2i &p_pixel);
+	void finish(const TerrainGeneratorData *p_data);
+	bool apply(TerrainGeneratorData *p_data, const bool p_redo);
+	void expire();
+
+	bool is_empty() const { return _tiles.empty() && _regions.empty(); }
+	bool is_expired() const { return _expired; }
+	int get_tile_count() const { return _tiles.size(); }
+	uint64_t get_bytes() const { return _bytes.get(); }
+	std::vector<Vector2i> get_region_locations() const;
+
+protected:
+	static void _bind_methods();
+};
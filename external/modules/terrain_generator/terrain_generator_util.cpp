@@ -82,7 +82,7 @@ void TerrainGeneratorUtil::dump_maps(const TypedArray<Image> &p_maps, const Stri
 
 // Expects a filename in a String like: "TerrainGenerator-01_02.res" which returns (-1, 2)
 Vector2i TerrainGeneratorUtil::filename_to_location(const String &p_filename) {
-	String location_string = p_filename.trim_prefix("TerrainGenerator").trim_suffix(".res");
+	String location_string = p_filename.get_file().get_basename().trim_prefix("TerrainGenerator");
 	return string_to_location(location_string);
 }
 
@@ -97,9 +97,9 @@ Vector2i TerrainGeneratorUtil::string_to_location(const String &p_string) {
 	return Vector2i(x_str.to_int(), y_str.to_int());
 }
 
-// Expects a v2i(-1,2) and returns TerrainGenerator-01_02.res
-String TerrainGeneratorUtil::location_to_filename(const Vector2i &p_region_loc) {
-	return "TerrainGenerator" + location_to_string(p_region_loc) + ".res";
+// Expects a v2i(-1,2) and returns TerrainGenerator-01_02.res, or with the given extension
+String TerrainGeneratorUtil::location_to_filename(const Vector2i &p_region_loc, const String &p_extension) {
+	return "TerrainGenerator" + location_to_string(p_region_loc) + "." + p_extension;
 }
 
 // Expects a v2i(-1,2) and returns -01_02
@@ -299,6 +299,48 @@ Ref<Image> TerrainGeneratorUtil::get_filled_image(const Vector2i &p_size, const
 	return img;
 }
 
+/**
+ * Regenerates the mipmaps of an RGBA8 image over p_area, in pixels of the full size image, with
+ * the same 2x2 box filter as Image::generate_mipmaps(). Other formats, or images without
+ * mipmaps, regenerate all of them.
+ */
+void TerrainGeneratorUtil::update_mipmaps(const Ref<Image> &p_image, const Rect2i &p_area) {
+	if (p_image.is_null() || p_image->is_empty()) {
+		LOG(ERROR, "Provided image is not valid");
+		return;
+	}
+	if (!p_image->has_mipmaps() || p_image->get_format() != Image::FORMAT_RGBA8) {
+		p_image->generate_mipmaps();
+		return;
+	}
+	uint8_t *data = p_image->ptrw();
+	Rect2i area = p_area.intersection(Rect2i(V2I_ZERO, p_image->get_size()));
+	for (int mip = 1; mip <= p_image->get_mipmap_count() && area.has_area(); mip++) {
+		int64_t src_ofs, dst_ofs;
+		int src_w, src_h, dst_w, dst_h;
+		p_image->get_mipmap_offset_and_size(mip - 1, src_ofs, src_w, src_h);
+		p_image->get_mipmap_offset_and_size(mip, dst_ofs, dst_w, dst_h);
+		Vector2i start = area.position / 2;
+		Vector2i end = ((area.get_end() + Vector2i(1, 1)) / 2).min(Vector2i(dst_w, dst_h));
+		const uint8_t *src = data + src_ofs;
+		uint8_t *dst = data + dst_ofs;
+		for (int y = start.y; y < end.y; y++) {
+			int y0 = MIN(y * 2, src_h - 1);
+			int y1 = MIN(y * 2 + 1, src_h - 1);
+			for (int x = start.x; x < end.x; x++) {
+				int x0 = MIN(x * 2, src_w - 1);
+				int x1 = MIN(x * 2 + 1, src_w - 1);
+				for (int c = 0; c < 4; c++) {
+					uint32_t sum = src[(y0 * src_w + x0) * 4 + c] + src[(y0 * src_w + x1) * 4 + c] +
+							src[(y1 * src_w + x0) * 4 + c] + src[(y1 * src_w + x1) * 4 + c];
+					dst[(y * dst_w + x) * 4 + c] = uint8_t((sum + 2) >> 2);
+				}
+			}
+		}
+		area = Rect2i(start, end - start);
+	}
+}
+
 /**
  * Loads a file from disk and returns an Image
  * Parameters:
@@ -531,13 +573,14 @@ void TerrainGeneratorUtil::_bind_methods() {
 
 	// String functions
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("filename_to_location", "filename"), &TerrainGeneratorUtil::filename_to_location);
-	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("location_to_filename", "region_location"), &TerrainGeneratorUtil::location_to_filename);
+	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("location_to_filename", "region_location", "extension"), &TerrainGeneratorUtil::location_to_filename, DEFVAL("res"));
 
 	// Image handling
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("black_to_alpha", "image"), &TerrainGeneratorUtil::black_to_alpha);
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("get_min_max", "image"), &TerrainGeneratorUtil::get_min_max);
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("get_thumbnail", "image", "size"), &TerrainGeneratorUtil::get_thumbnail, DEFVAL(Vector2i(256, 256)));
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("get_filled_image", "size", "color", "create_mipmaps", "format"), &TerrainGeneratorUtil::get_filled_image);
+	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("update_mipmaps", "image", "area"), &TerrainGeneratorUtil::update_mipmaps);
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("load_image", "file_name", "cache_mode", "r16_height_range", "r16_size"), &TerrainGeneratorUtil::load_image, DEFVAL(CoreBind::ResourceLoader::CACHE_MODE_IGNORE), DEFVAL(Vector2(0, 255)), DEFVAL(V2I_ZERO));
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("pack_image", "src_rgb", "src_a", "invert_green", "invert_alpha", "normalize_alpha", "alpha_channel"), &TerrainGeneratorUtil::pack_image, DEFVAL(false), DEFVAL(false), DEFVAL(false), DEFVAL(0));
 	ClassDB::bind_static_method("TerrainGeneratorUtil", D_METHOD("luminance_to_height", "src_rgb"), &TerrainGeneratorUtil::luminance_to_height);
@@ -31,7 +31,7 @@ public:
 	// String functions
 	static Vector2i filename_to_location(const String &p_filename);
 	static Vector2i string_to_location(const String &p_string);
-	static String location_to_filename(const Vector2i &p_region_loc);
+	static String location_to_filename(const Vector2i &p_region_loc, const String &p_extension = "res");
 	static String location_to_string(const Vector2i &p_region_loc);
 	static PackedStringArray get_files(const String &p_dir, const String &p_glob = "*");
 
@@ -43,6 +43,7 @@ public:
 			const Color &p_color = COLOR_BLACK,
 			const bool p_create_mipmaps = true,
 			const Image::Format p_format = Image::FORMAT_MAX);
+	static void update_mipmaps(const Ref<Image> &p_image, const Rect2i &p_area);
 	static Ref<Image> load_image(const String &p_file_name, const int p_cache_mode = CoreBind::ResourceLoader::CACHE_MODE_IGNORE,
 			const Vector2 &p_r16_height_range = Vector2(0.f, 255.f), const Vector2i &p_r16_size = V2I_ZERO);
 	static Ref<Image> pack_image(const Ref<Image> &p_src_rgb,